@@ -0,0 +1,118 @@
+#!/bin/bash
+
+# Measures process startup cost (dynamic loading + static initialization)
+# and peak RSS of mainRob, optionally for both robSock variants:
+#   ./bench-startup.sh [-n runs] [-b] [-- cmake args...]   # -b builds the Qt and Qt-free variants first
+
+set -eu
+
+source .env
+
+CC=${CC:-cc}
+
+if ! command -v $CC >/dev/null 2>&1 ; then
+    echo "Error: $CC not found on system!" 1>&2
+    exit 1
+fi
+
+runs=200
+build=0
+
+while getopts "n:b" op
+do
+    case $op in
+        "n")
+            runs=$OPTARG
+            ;;
+        "b")
+            build=1
+            ;;
+        default)
+            echo "ERROR: unknown parameter"
+            ;;
+    esac
+done
+
+shift $(($OPTIND-1))
+
+# A tiny launcher is used instead of a shell or python, otherwise the
+# peak RSS reported for the child includes the image it was forked from.
+tmpdir=$(mktemp -d)
+trap 'rm -rf $tmpdir' EXIT
+
+$CC -O2 -x c -o $tmpdir/launcher - <<'EOF'
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+static int cmp(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv)
+{
+    int runs = atoi(argv[2]);
+    double *ms = malloc(runs * sizeof(double));
+    long maxrss = 0;
+
+    for(int i = 0; i < runs; i++) {
+        struct timespec t0, t1;
+        struct rusage ru;
+        int status;
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        pid_t pid = fork();
+        if(pid == 0) {
+            freopen("/dev/null", "w", stdout);
+            freopen("/dev/null", "w", stderr);
+            execl(argv[3], argv[3], "--bad-option", (char *)NULL);
+            _exit(127);
+        }
+        wait4(pid, &status, 0, &ru);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        if(WIFEXITED(status) && WEXITSTATUS(status) == 127) {
+            fprintf(stderr, "Error: could not run %s\n", argv[3]);
+            return 1;
+        }
+
+        ms[i] = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+        if(ru.ru_maxrss > maxrss) maxrss = ru.ru_maxrss;
+    }
+
+    qsort(ms, runs, sizeof(double), cmp);
+    printf("%-8s startup median %.2f ms  p90 %.2f ms  max RSS %ld KiB\n",
+           argv[1], ms[runs / 2], ms[runs * 9 / 10], maxrss);
+    return 0;
+}
+EOF
+
+# runs the executable with a bad option, so it exits right after startup
+measure() {
+    $tmpdir/launcher $1 $runs $2
+}
+
+if [ $build -eq 0 ]; then
+    measure "mainRob" $BIN_DIR/mainRob
+    exit 0
+fi
+
+for variant in qt noqt
+do
+    if [ $variant = "qt" ]; then qt=ON; else qt=OFF; fi
+
+    if ! cmake -S . -B build-$variant -DROBSOCK_WITH_QT=$qt "$@" >/dev/null \
+        || ! cmake --build build-$variant --target mainRob -j$(nproc) >/dev/null ; then
+        echo "Warning: could not build the $variant variant" 1>&2
+        continue
+    fi
+
+    # both variants output to the same place, keep a copy of each
+    cp $BIN_DIR/mainRob build-$variant/mainRob
+    measure $variant build-$variant/mainRob
+done
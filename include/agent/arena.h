@@ -0,0 +1,118 @@
+#ifndef AGENT_ARENA_H
+#define AGENT_ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace agent
+{
+
+/**
+ * @class Arena
+ * @brief Scratch memory handed out by bumping an offset, released all at once.
+ *
+ * Nothing is freed until reset, which makes the whole arena free again.
+ * When a request does not fit, a block is taken from the heap for it, and
+ * the next reset grows the buffer to what was used, so an arena reset
+ * every cycle stops going to the heap once it has seen the largest cycle.
+*/
+class Arena
+{
+public:
+    static constexpr size_t DEFAULT_CAPACITY{64*1024};
+
+    explicit Arena(size_t t_capacity = DEFAULT_CAPACITY);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /**
+     * Get memory from the arena.
+     *
+     * @param t_bytes The size of the memory.
+     * @param t_align The alignment of the memory, a power of 2.
+     * @return The memory, valid until the next reset.
+    */
+    void* allocate(size_t t_bytes, size_t t_align = alignof(std::max_align_t));
+
+    /**
+     * Release everything allocated, keeping the buffer for what comes next.
+    */
+    void reset();
+
+    /**
+     * Get the bytes allocated since the last reset.
+    */
+    inline size_t used() const { return m_used; }
+
+    /**
+     * Get the size of the buffer.
+    */
+    inline size_t capacity() const { return m_capacity; }
+
+private:
+    // a block taken from the heap when the buffer is full, freed by reset
+    struct Block { Block* next; };
+
+    char* m_buffer;
+    size_t m_capacity;
+    size_t m_offset{0};
+    size_t m_used{0};
+    Block* m_blocks{nullptr};
+};
+
+/**
+ * @class ArenaAllocator
+ * @brief A standard allocator drawing from an arena, as std::pmr::polymorphic_allocator.
+ *
+ * Deallocating is a no-op, the memory comes back when the arena is reset.
+ * Without an arena, the allocator uses the global new and delete.
+ *
+ * @tparam T The type allocated.
+*/
+template<class T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+
+    ArenaAllocator(Arena* t_arena = nullptr) noexcept : m_arena(t_arena) {}
+
+    template<class U>
+    ArenaAllocator(const ArenaAllocator<U>& t_other) noexcept : m_arena(t_other.arena()) {}
+
+    inline T* allocate(size_t t_n)
+    {
+        if(m_arena == nullptr)
+            return static_cast<T*>(::operator new(t_n*sizeof(T)));
+        return static_cast<T*>(m_arena->allocate(t_n*sizeof(T), alignof(T)));
+    }
+
+    inline void deallocate(T* t_p, size_t) noexcept
+    {
+        if(m_arena == nullptr)
+            ::operator delete(t_p);
+    }
+
+    inline Arena* arena() const noexcept { return m_arena; }
+
+private:
+    Arena* m_arena;
+};
+
+template<class T, class U>
+inline bool operator==(const ArenaAllocator<T>& t_a, const ArenaAllocator<U>& t_b) { return t_a.arena() == t_b.arena(); }
+template<class T, class U>
+inline bool operator!=(const ArenaAllocator<T>& t_a, const ArenaAllocator<U>& t_b) { return t_a.arena() != t_b.arena(); }
+
+/**
+ * A vector drawing from an arena, valid until the arena is reset.
+*/
+template<class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace agent
+
+#endif // AGENT_ARENA_H
@@ -0,0 +1,149 @@
+#ifndef AGENT_BITBOARD_H
+#define AGENT_BITBOARD_H
+
+#include "agent/utils.h"
+
+#include <cstdint>
+
+namespace agent
+{
+
+/**
+ * @class CellBoard
+ * @brief A set of cells of the grid, one bit per cell.
+ * 
+ * Each row of cells is a 64-bit word, bit 0 being the westmost cell and
+ * word 0 the southmost row. Moving every cell of the set one step in a
+ * direction is a shift of each word, so a whole BFS wavefront advances in
+ * a few word operations per row.
+ * 
+ * @tparam Grid The dimensions of the grid (see GridSpec).
+*/
+template<class Grid>
+class CellBoard
+{
+public:
+    static constexpr int COLS{Grid::HALF_WIDTH + 1};      // cells in a row
+    static constexpr int ROWS{Grid::HALF_HEIGHT + 1};     // rows of cells
+    static constexpr int SIZE{COLS*ROWS};                  // cells of the grid
+    static_assert(COLS <= 64, "a row of cells must fit a word");
+
+    /**
+     * Number the cells of the grid 0..SIZE-1, in the order of their identifiers.
+     * The identifier must be a valid cell.
+    */
+    static inline int index(const int& t_id) { return row(t_id)*COLS + col(t_id); }
+
+    /**
+     * Get the identifier of a cell from its index.
+    */
+    static inline int cellId(const int& t_index)
+    {
+        return computeCellId<Grid>(2*(t_index % COLS) - Grid::HALF_WIDTH, 2*(t_index / COLS) - Grid::HALF_HEIGHT);
+    }
+
+    /**
+     * Remove every cell from the set.
+    */
+    inline void clear() { for(int r = 0; r < ROWS; r++) m_rows[r] = 0; }
+
+    /**
+     * Check, add or remove a cell. The identifier must be a valid cell.
+    */
+    inline bool test(const int& t_id) const { return m_rows[row(t_id)] >> col(t_id) & 1; }
+    inline void set(const int& t_id) { m_rows[row(t_id)] |= uint64_t{1} << col(t_id); }
+    inline void reset(const int& t_id) { m_rows[row(t_id)] &= ~(uint64_t{1} << col(t_id)); }
+
+    /**
+     * Check if the set has any cell.
+    */
+    inline bool any() const
+    {
+        uint64_t bits = 0;
+        for(int r = 0; r < ROWS; r++) bits |= m_rows[r];
+        return bits != 0;
+    }
+
+    /**
+     * Count the cells of the set.
+    */
+    inline int count() const
+    {
+        int n = 0;
+        for(int r = 0; r < ROWS; r++) n += __builtin_popcountll(m_rows[r]);
+        return n;
+    }
+
+    /**
+     * Get the cell of the set with the lowest identifier.
+     * 
+     * @return The identifier, -1 if the set is empty.
+    */
+    inline int first() const
+    {
+        for(int r = 0; r < ROWS; r++)
+            if(m_rows[r])
+                return cellId(r*COLS + __builtin_ctzll(m_rows[r]));
+        return -1;
+    }
+
+    /**
+     * Call a function with the identifier of each cell of the set,
+     * from the lowest identifier to the highest.
+    */
+    template<class F>
+    inline void forEach(F t_f) const
+    {
+        for(int r = 0; r < ROWS; r++)
+            for(uint64_t bits = m_rows[r]; bits; bits &= bits - 1)
+                t_f(cellId(r*COLS + __builtin_ctzll(bits)));
+    }
+
+    inline CellBoard& operator|=(const CellBoard& t_other) { for(int r = 0; r < ROWS; r++) m_rows[r] |= t_other.m_rows[r]; return *this; }
+    inline CellBoard& operator&=(const CellBoard& t_other) { for(int r = 0; r < ROWS; r++) m_rows[r] &= t_other.m_rows[r]; return *this; }
+
+    /**
+     * Remove the cells of another set.
+    */
+    inline CellBoard& operator-=(const CellBoard& t_other) { for(int r = 0; r < ROWS; r++) m_rows[r] &= ~t_other.m_rows[r]; return *this; }
+
+    inline CellBoard operator|(const CellBoard& t_other) const { CellBoard b = *this; return b |= t_other; }
+    inline CellBoard operator&(const CellBoard& t_other) const { CellBoard b = *this; return b &= t_other; }
+    inline CellBoard operator-(const CellBoard& t_other) const { CellBoard b = *this; return b -= t_other; }
+
+    /**
+     * Move every cell of the set to its neighbor in a direction.
+     * 
+     * Cells moved past the borders are dropped.
+     * 
+     * @param t_dir The direction (0..7, see N_DIRECTIONS).
+     * @return The moved set.
+    */
+    inline CellBoard shifted(const int& t_dir) const
+    {
+        static const int dx[N_DIRECTIONS] = {1, 1, 0, -1, -1, -1, 0, 1};
+        static const int dy[N_DIRECTIONS] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+        CellBoard b;
+        for(int r = 0; r < ROWS; r++)
+        {
+            int from = r - dy[t_dir];
+            if(from < 0 || from >= ROWS) continue;
+            uint64_t bits = m_rows[from];
+            b.m_rows[r] = (dx[t_dir] > 0 ? bits << 1 : dx[t_dir] < 0 ? bits >> 1 : bits) & ROW_MASK;
+        }
+        return b;
+    }
+
+private:
+    static constexpr uint64_t ROW_MASK{COLS == 64 ? ~uint64_t{0} : (uint64_t{1} << (COLS % 64)) - 1};
+
+    static inline int col(const int& t_id) { return (cellX<Grid>(t_id) + Grid::HALF_WIDTH) >> 1; }
+    static inline int row(const int& t_id) { return (cellY<Grid>(t_id) + Grid::HALF_HEIGHT) >> 1; }
+
+    uint64_t m_rows[ROWS]{};
+};
+
+} // namespace agent
+
+#endif // AGENT_BITBOARD_H
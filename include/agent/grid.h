@@ -0,0 +1,199 @@
+#ifndef AGENT_GRID_H
+#define AGENT_GRID_H
+
+#include <cstdint>
+
+namespace agent
+{
+
+/**
+ * Dimensions of the grid of cells, fixed at compile time.
+ * 
+ * Cells sit at the even coordinates x in [-HALF_WIDTH, HALF_WIDTH] and
+ * y in [-HALF_HEIGHT, HALF_HEIGHT], the starting cell at (0,0). Identifiers
+ * number every point of the COLS x ROWS grid, the cells and the links between
+ * them, row by row from the bottom left corner.
+ * 
+ * @tparam HalfWidth The largest x coordinate of a cell (even).
+ * @tparam HalfHeight The largest y coordinate of a cell (even).
+*/
+template<int HalfWidth, int HalfHeight>
+struct GridSpec
+{
+    static_assert(HalfWidth >= 0 && HalfWidth % 2 == 0 && HalfHeight >= 0 && HalfHeight % 2 == 0,
+                  "the borders of the grid must be cells");
+    static_assert((2*HalfWidth + 1)*(2*HalfHeight + 1) <= 32767, "identifiers must fit the tables (GridTables)");
+
+    static constexpr int HALF_WIDTH{HalfWidth};
+    static constexpr int HALF_HEIGHT{HalfHeight};
+    static constexpr int COLS{2*HalfWidth + 1};
+    static constexpr int ROWS{2*HalfHeight + 1};
+    static constexpr int SIZE{COLS*ROWS};
+};
+
+/**
+ * The grid of the ciberRato labs: 25x11 cells, identifiers in a 49x21 grid.
+*/
+typedef GridSpec<24,10> DefaultGrid;
+
+/**
+ * A grid of 49x21 cells, four times the ciberRato labs, for synthetic arenas.
+*/
+typedef GridSpec<48,20> LargeGrid;
+
+/**
+ * Number of directions from a cell to its neighbors.
+ * 
+ * Directions go counterclockwise from east, 45 degrees apart:
+ * 0 is east, 2 north, 4 west and 6 south.
+*/
+constexpr int N_DIRECTIONS = 8;
+
+/**
+ * The neighbors of a cell, by direction. -1 where there is none.
+*/
+struct CellNeighbors {
+    short id[N_DIRECTIONS];
+};
+
+namespace detail
+{
+
+// a list of 0..N-1, built in log(N) steps (std::index_sequence is C++14)
+template<int... I> struct IndexList {};
+
+template<class A, class B> struct JoinIndex;
+template<int... A, int... B>
+struct JoinIndex<IndexList<A...>, IndexList<B...>> { typedef IndexList<A..., (int)sizeof...(A) + B...> type; };
+
+template<int N>
+struct MakeIndex { typedef typename JoinIndex<typename MakeIndex<N/2>::type, typename MakeIndex<N - N/2>::type>::type type; };
+template<> struct MakeIndex<0> { typedef IndexList<> type; };
+template<> struct MakeIndex<1> { typedef IndexList<0> type; };
+
+// coordinate steps to the neighbor in each direction
+constexpr int dirX(int t_dir) { return t_dir == 0 || t_dir == 1 || t_dir == 7 ? 2 : t_dir >= 3 && t_dir <= 5 ? -2 : 0; }
+constexpr int dirY(int t_dir) { return t_dir >= 1 && t_dir <= 3 ? 2 : t_dir >= 5 ? -2 : 0; }
+
+template<class Grid> constexpr int idX(int t_id) { return t_id % Grid::COLS - Grid::HALF_WIDTH; }
+template<class Grid> constexpr int idY(int t_id) { return t_id / Grid::COLS - Grid::HALF_HEIGHT; }
+
+template<class Grid> constexpr bool isCell(int t_id)
+{
+    return t_id >= 0 && t_id < Grid::SIZE && idX<Grid>(t_id) % 2 == 0 && idY<Grid>(t_id) % 2 == 0;
+}
+
+template<class Grid> constexpr bool inGrid(int t_x, int t_y)
+{
+    return t_x >= -Grid::HALF_WIDTH && t_x <= Grid::HALF_WIDTH && t_y >= -Grid::HALF_HEIGHT && t_y <= Grid::HALF_HEIGHT;
+}
+
+template<class Grid> constexpr short neighbor(int t_id, int t_dir)
+{
+    return isCell<Grid>(t_id) && inGrid<Grid>(idX<Grid>(t_id) + dirX(t_dir), idY<Grid>(t_id) + dirY(t_dir))
+           ? (short)(t_id + dirX(t_dir) + dirY(t_dir)*Grid::COLS) : (short)-1;
+}
+
+template<class Grid> constexpr CellNeighbors neighbors(int t_id)
+{
+    return CellNeighbors{{neighbor<Grid>(t_id, 0), neighbor<Grid>(t_id, 1), neighbor<Grid>(t_id, 2), neighbor<Grid>(t_id, 3),
+                          neighbor<Grid>(t_id, 4), neighbor<Grid>(t_id, 5), neighbor<Grid>(t_id, 6), neighbor<Grid>(t_id, 7)}};
+}
+
+// bits t_bit..31 of the validity word t_word
+template<class Grid> constexpr uint32_t validBits(int t_word, int t_bit)
+{
+    return t_bit == 32 ? 0u : (isCell<Grid>(t_word*32 + t_bit) ? 1u << t_bit : 0u) | validBits<Grid>(t_word, t_bit + 1);
+}
+
+} // namespace detail
+
+/**
+ * Lookup tables of a grid, generated at compile time.
+ * 
+ * Indexed by identifier: the integer coordinates of every point of the grid,
+ * the neighbors of every cell and a bitmap of the identifiers of cells. The
+ * identifier of the neighbor in a direction is also the identifier plus
+ * DELTA of the direction.
+ * 
+ * @tparam Grid The dimensions of the grid (see GridSpec).
+*/
+template<class Grid,
+         class Ids = typename detail::MakeIndex<Grid::SIZE>::type,
+         class Words = typename detail::MakeIndex<(Grid::SIZE + 31)/32>::type>
+struct GridTables;
+
+template<class Grid, int... I, int... W>
+struct GridTables<Grid, detail::IndexList<I...>, detail::IndexList<W...>>
+{
+    static constexpr short X[Grid::SIZE]{detail::idX<Grid>(I)...};
+    static constexpr short Y[Grid::SIZE]{detail::idY<Grid>(I)...};
+    static constexpr int DELTA[N_DIRECTIONS]{
+        detail::dirX(0) + detail::dirY(0)*Grid::COLS, detail::dirX(1) + detail::dirY(1)*Grid::COLS,
+        detail::dirX(2) + detail::dirY(2)*Grid::COLS, detail::dirX(3) + detail::dirY(3)*Grid::COLS,
+        detail::dirX(4) + detail::dirY(4)*Grid::COLS, detail::dirX(5) + detail::dirY(5)*Grid::COLS,
+        detail::dirX(6) + detail::dirY(6)*Grid::COLS, detail::dirX(7) + detail::dirY(7)*Grid::COLS};
+    static constexpr CellNeighbors NEIGHBORS[Grid::SIZE]{detail::neighbors<Grid>(I)...};
+    static constexpr uint32_t VALID[sizeof...(W)]{detail::validBits<Grid>(W, 0)...};
+};
+
+template<class Grid, int... I, int... W>
+constexpr short GridTables<Grid, detail::IndexList<I...>, detail::IndexList<W...>>::X[Grid::SIZE];
+template<class Grid, int... I, int... W>
+constexpr short GridTables<Grid, detail::IndexList<I...>, detail::IndexList<W...>>::Y[Grid::SIZE];
+template<class Grid, int... I, int... W>
+constexpr int GridTables<Grid, detail::IndexList<I...>, detail::IndexList<W...>>::DELTA[N_DIRECTIONS];
+template<class Grid, int... I, int... W>
+constexpr CellNeighbors GridTables<Grid, detail::IndexList<I...>, detail::IndexList<W...>>::NEIGHBORS[Grid::SIZE];
+template<class Grid, int... I, int... W>
+constexpr uint32_t GridTables<Grid, detail::IndexList<I...>, detail::IndexList<W...>>::VALID[sizeof...(W)];
+
+/**
+ * Get the x coordinate of an identifier.
+ * 
+ * It is assumed that the identifier is in the grid.
+*/
+template<class Grid = DefaultGrid>
+constexpr int cellX(const int& t_id) { return GridTables<Grid>::X[t_id]; }
+
+/**
+ * Get the y coordinate of an identifier.
+ * 
+ * It is assumed that the identifier is in the grid.
+*/
+template<class Grid = DefaultGrid>
+constexpr int cellY(const int& t_id) { return GridTables<Grid>::Y[t_id]; }
+
+/**
+ * Get the neighbor of a cell in a direction.
+ * 
+ * @param t_id The identifier of the cell.
+ * @param t_dir The direction (0..7, see N_DIRECTIONS).
+ * @return The identifier of the neighbor, -1 if the cell is on the border
+ *         in that direction or t_id is not a cell.
+*/
+template<class Grid = DefaultGrid>
+constexpr int neighborCellId(const int& t_id, const int& t_dir)
+{
+    return t_id >= 0 && t_id < Grid::SIZE ? GridTables<Grid>::NEIGHBORS[t_id].id[t_dir] : -1;
+}
+
+/**
+ * Get the direction from a cell to one of its neighbors.
+ * 
+ * @param t_id The identifier of the cell.
+ * @param t_nid The identifier of the neighbor.
+ * @return The direction (0..7), -1 if t_nid is not a neighbor of t_id.
+*/
+template<class Grid = DefaultGrid>
+inline int neighborDirection(const int& t_id, const int& t_nid)
+{
+    for(int d = 0; d < N_DIRECTIONS; d++)
+        if(t_nid - t_id == GridTables<Grid>::DELTA[d])
+            return neighborCellId<Grid>(t_id, d) == t_nid ? d : -1;
+    return -1;
+}
+
+} // namespace agent
+
+#endif // AGENT_GRID_H
@@ -1,11 +1,13 @@
 #ifndef AGENT_LOCALMAP_H
 #define AGENT_LOCALMAP_H
 
+#include "agent/arena.h"
+#include "agent/bitboard.h"
 #include "agent/utils.h"
 
 #include <vector>
 #include <cassert>
-#include <map>
+#include <utility>
 #include <string>
 
 namespace agent
@@ -18,21 +20,24 @@ namespace agent
  * This class serves the purpose of checking if a point is inside a wall.
  * The points in cause are line sensor coordinates. This will help detect
  * if the line sensor is inside a wall or not.
+ * 
+ * @tparam Grid The dimensions of the grid (see GridSpec).
 */
-class MapWall
+template<class Grid>
+class BasicMapWall
 {
 public:
-    MapWall() = default;
-    virtual ~MapWall() = default;
+    BasicMapWall() = default;
+    virtual ~BasicMapWall() = default;
 
     /**
      * Re-center wall to a cell and compute its coordinates.
      * 
      * @param t_id The identifier of the cell.
-     * @param t_dir The direction of the wall (in radians).
-     * @param isRight True if the angle is multiple of 90, false otherwise.
+     * @param t_dir The direction of the wall (0..7, see N_DIRECTIONS).
+     * @throws std::invalid_argument if there is no cell in that direction.
     */
-    void update(const int& t_id, const double& t_dir);
+    void update(const int& t_id, const int& t_dir);
 
     /**
      * Check if a point is inside the wall.
@@ -62,73 +67,32 @@ private:
     */
     bool addCorner(const double& t_x, const double& t_y);
 
-    std::vector<Position> m_corners;
+    Position m_corners[4];
+    int m_nCorners{0};
     std::pair<int,int> m_cells;
 };
 
-/**
- * @class MapCell
- * @brief Representation of a cell in the map of a ciberRato environment.
- * Used internally in the PerceivedMap class.
-*/
-class MapCell
-{
-public:
-    MapCell(int t_id);
-    virtual ~MapCell() = default;
-
-    inline const int& getId() const { return m_id; }
-    inline const std::vector<int>& getNeighbors() const { return m_neighbors; }
-    inline bool isExpanded() const { return m_expanded; }
-
-    /**
-     * Link a neighbor to the cell.
-     * 
-     * @param t_id The identifier of the neighbor.
-     * @return True if the neighbor was added, false otherwise.
-    */
-    bool linkNeighbor(int t_id);
-
-    /**
-     * Unlink a neighbor from the cell.
-     * 
-     * @param t_id The identifier of the neighbor.
-     * @return True if the neighbor was removed, false otherwise.
-    */
-    bool unlinkNeighbor(int t_id);
-
-    /**
-     * Set cell expansion.
-     * 
-     * A cell is expanded all neighbors are added to the list of neighbors.
-     * A cell can be unexpanded because it might detect some neighbors that are not connected.
-     * This way, the cell can be expanded again when the connection is verified.
-     * 
-     * @return True if the cell was expanded, false otherwise.
-    */
-    inline void setExpanded(bool t_expanded) { m_expanded = t_expanded; } 
-
-    /**
-     * 
-    */
-
-private:
-    int m_id;
-    std::vector<int> m_neighbors; // stored by their identifier
-    bool m_expanded{false};
-};
-
+typedef BasicMapWall<DefaultGrid> MapWall;
 
 /**
  * @class LocalMap
  * @brief A representation of the map perceived by the agent.
  * Private methods do not check if the parameters are valid.
+ * 
+ * The cells are stored as arrays indexed by cell (see CellBoard::index),
+ * one per property, so that the map and the planner scratch take a few
+ * kilobytes with no allocation per cell.
+ * 
+ * The library is built for DefaultGrid, the ciberRato labs, and LargeGrid.
+ * 
+ * @tparam Grid The dimensions of the grid (see GridSpec).
 */
-class PerceivedMap
+template<class Grid>
+class BasicPerceivedMap
 {
 public:
-    PerceivedMap() = default;
-    virtual ~PerceivedMap() = default;
+    BasicPerceivedMap();
+    virtual ~BasicPerceivedMap() = default;
 
     /**
      * Reset the map.
@@ -151,13 +115,38 @@ public:
     */
     void unlinkNeighbor(int t_id1, int t_id2);
 
+    /**
+     * Set the arena of the map's scratch memory.
+     * 
+     * The planner draws its temporary containers from it, or from the heap
+     * without one. Nothing it returns is kept there, so the owner may reset
+     * the arena between any two calls.
+     * 
+     * @param t_scratch The arena, nullptr for none.
+    */
+    inline void setScratch(Arena* t_scratch) { m_scratch = t_scratch; }
+
     /**
      * Get cell neighbors.
      * 
      * @param t_id The identifier of the cell.
-     * @return A vector with the identifiers of the neighbors.
+     * @return A vector with the identifiers of the neighbors, in the order they were linked.
+    */
+    std::vector<int> getNeighbors(const int& t_id) const;
+
+    /**
+     * Call a function with each neighbor of a cell, in the order they were
+     * linked, as getNeighbors lists them but without allocating.
+     * 
+     * @param t_id The identifier of the cell.
+     * @param t_f The function, called with the identifier of the neighbor.
     */
-    inline std::vector<int> getNeighbors(const int& t_id) { return getCell(t_id).getNeighbors(); }
+    template<class F>
+    void forEachNeighbor(const int& t_id, F t_f) const
+    {
+        checkInMap(t_id, "forEachNeighbor");
+        forEachLinked(t_id, t_f);
+    }
 
     /**
      * Link a cell as neighbor of another cell.
@@ -229,23 +218,26 @@ public:
     std::string toString() const;
 
 private:
+    friend struct MapBenchmark; // times the planner directly (tests/bench-map.cpp)
+    friend struct MapTest;      // checks the planner directly (tests/test-map.cpp)
+
+    static constexpr int N_CELLS{CellBoard<Grid>::SIZE};
+
     /**
-     * Get the cell corresponding to an identifier.
-     * 
-     * This function must be private to ensure that 
-     * no cell is changed outside of the class.
+     * Check if a cell is in the map.
      * 
      * @param t_id The identifier of the cell.
+     * @return True if the cell is in the map, false otherwise.
     */
-    MapCell& getCell(const int& t_id);
+    bool cellInLocalMap(const int& t_id) const;
 
     /**
-     * Check if a cell is in the map.
+     * Throw std::invalid_argument unless a cell is valid and in the map.
      * 
      * @param t_id The identifier of the cell.
-     * @return True if the cell is in the map, false otherwise.
+     * @param t_caller The name of the public method, for the message.
     */
-    bool cellInLocalMap(const int& t_id) const;
+    void checkInMap(const int& t_id, const char* t_caller) const;
 
     /**
      * Compute the distance between two cells.
@@ -262,13 +254,28 @@ private:
      * Compute shortest path to an open cell.
      * 
      * Used to find the next cell to expand.
-     * Uses breadth-first search.
+     * Uses breadth-first search, advancing each distance layer at once on
+     * the bitboards. Of the open cells at the smallest distance, the path
+     * goes to the one a queue would reach first, visiting the neighbors of
+     * each cell in the order they were linked.
      * 
      * @param t_start The identifier of the starting cell.
      * @return True if a path was found, false otherwise.
     */
     bool computePathWithoutGoal(const int& t_start);
 
+    /**
+     * Search the shortest path between two cells.
+     * 
+     * Uses A* algorithm. Leaves the predecessor of each cell reached
+     * in the planner scratch.
+     * 
+     * @param t_start The identifier of the starting cell.
+     * @param t_goal The identifier of the goal cell.
+     * @return True if a path was found, false otherwise.
+    */
+    bool search(const int& t_start, const int& t_goal);
+
     /**
      * Compute the shortest path between two cells.
      * 
@@ -313,10 +320,25 @@ private:
      * The path is stored in reverse order (start position is the last element).
      * Stores the path inside the class.
      * 
-     * @param t_cameFrom The map of predecessors.
      * @param t_current The identifier of the current cell.
     */
-    void reconstructPath(std::map<int,int>& t_cameFrom, const int& t_current);
+    void reconstructPath(const int& t_current);
+
+    /**
+     * Call a function with each neighbor linked to a cell, in the order
+     * they were linked, which breaks the ties of the searches.
+     * 
+     * @param t_id The identifier of the cell.
+     * @param t_f The function, called with the identifier of the neighbor.
+    */
+    template<class F>
+    inline void forEachLinked(const int& t_id, F t_f) const
+    {
+        int c = CellBoard<Grid>::index(t_id);
+        uint32_t order = m_linkOrder[c];
+        for(int n = __builtin_popcount(m_linkMask[c]); n > 0; n--, order >>= 4)
+            t_f(neighborCellId<Grid>(t_id, order & 0xf));
+    }
 
     /**
      * Write the map to a file.
@@ -334,12 +356,32 @@ private:
     */
     void writePathToFile(const std::string& t_fname, const std::vector<int>& t_checkpoints);
 
-    std::vector<MapCell> m_list;
+    // the cells as sets
+    CellBoard<Grid> m_known;
+    CellBoard<Grid> m_expanded;
+    CellBoard<Grid> m_links[N_DIRECTIONS];  // cells linked to their neighbor in each direction
+
+    // the cells by index
+    uint8_t m_linkMask[N_CELLS]{};          // a bit per direction linked, as m_links
+    uint32_t m_linkOrder[N_CELLS]{};        // the directions linked, 4 bits each, first linked lowest
+    int m_nCells{0};
+    int m_start{-1};                        // the first cell added
+
+    // planner scratch by index, valid where m_visit holds the current search
+    uint32_t m_search{0};
+    uint32_t m_visit[N_CELLS]{};
+    double m_gScore[N_CELLS];
+    double m_fScore[N_CELLS];
+    short m_cameFrom[N_CELLS];              // -1 at the start
+
+    Arena* m_scratch{nullptr};
     std::vector<int> m_path;
     int m_next{-1};
     bool m_complete{false};
 };
 
+typedef BasicPerceivedMap<DefaultGrid> PerceivedMap;
+
 } // namespace agent
 
 #endif // AGENT_LOCALMAP_H
@@ -0,0 +1,162 @@
+#ifndef AGENT_METRICS_H
+#define AGENT_METRICS_H
+
+#include "robSock/clatency.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace agent
+{
+
+/**
+ * @class Counter
+ * @brief A count that only goes up, e.g. nodes expanded by a search.
+*/
+class Counter
+{
+public:
+    Counter() = default;
+
+    inline void add(uint64_t t_n = 1) { m_value.fetch_add(t_n, std::memory_order_relaxed); }
+    inline uint64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_value{0};
+};
+
+/**
+ * @class Gauge
+ * @brief A value that is set, e.g. the number of cells in the map.
+*/
+class Gauge
+{
+public:
+    Gauge() = default;
+
+    inline void set(double t_value) { m_value.store(t_value, std::memory_order_relaxed); }
+    inline double value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> m_value{0.0};
+};
+
+/**
+ * @class Timer
+ * @brief Durations, kept in the fixed log-linear buckets of the latency statistics.
+*/
+class Timer
+{
+public:
+    Timer() = default;
+
+    /**
+     * Record a duration.
+     *
+     * @param t_ns The duration in nanoseconds.
+    */
+    inline void record(long long t_ns) { m_hist.add(t_ns); }
+
+    inline uint64_t count() const { return m_hist.count(); }
+    inline long long total() const { return m_hist.total(); }
+    inline long long max() const { return m_hist.max(); }
+    inline long long percentile(double t_p) const { return m_hist.percentile(t_p); }
+
+private:
+    CLatencyHistogram m_hist;
+};
+
+/**
+ * @class ScopedTimer
+ * @brief Records the time from its construction to its destruction in a timer.
+*/
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Timer& t_timer);
+    ~ScopedTimer();
+
+private:
+    Timer& m_timer;
+    long long m_start;
+};
+
+/**
+ * @class Metrics
+ * @brief Counters, gauges and timers registered by name.
+ *
+ * Registering takes a lock, updating does not: call sites look their
+ * metric up once and keep the reference, which stays valid for the
+ * lifetime of the process.
+*/
+class Metrics
+{
+public:
+    /**
+     * Get the registry of the process.
+    */
+    static Metrics& global();
+
+    Counter& counter(const std::string& t_name);
+    Gauge& gauge(const std::string& t_name);
+    Timer& timer(const std::string& t_name);
+
+    /**
+     * Write the value of every metric, one per line, sorted by name:
+     *   counter <name> <value>
+     *   gauge <name> <value>
+     *   timer <name> count=<n> total=<us> p50=<us> p90=<us> p99=<us> max=<us>
+     *
+     * @return The snapshot.
+    */
+    std::string snapshot() const;
+
+    /**
+     * Log the snapshot, one message per metric.
+    */
+    void dump() const;
+
+    /**
+     * Append a snapshot to a file every interval, and once more when stopped.
+     *
+     * Each snapshot starts with a "# metrics <ms>" line, the time since
+     * the dumps started, and ends with an empty line.
+     *
+     * @param t_fname The filename.
+     * @param t_intervalMs The interval in milliseconds, 0 to write only when stopped.
+     * @return True if the file could be opened, false otherwise.
+    */
+    bool startPeriodicDump(const std::string& t_fname, int t_intervalMs);
+
+    /**
+     * Stop the periodic dump, writing the last snapshot.
+    */
+    void stopPeriodicDump();
+
+private:
+    Metrics() = default;
+
+    void writeSnapshot();
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, std::unique_ptr<Counter>> m_counters;
+    std::map<std::string, std::unique_ptr<Gauge>> m_gauges;
+    std::map<std::string, std::unique_ptr<Timer>> m_timers;
+
+    std::mutex m_dumpMutex;
+    std::condition_variable m_dumpWake;
+    std::thread m_dumpThread;
+    FILE* m_dumpFile{nullptr};
+    long long m_dumpStart{0};
+    bool m_dumpStop{false};
+};
+
+} // namespace agent
+
+#endif // AGENT_METRICS_H
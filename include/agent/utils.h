@@ -1,6 +1,10 @@
 #ifndef AGENT_UTILS_H
 #define AGENT_UTILS_H
 
+#include "agent/grid.h"
+
+#include <cstdint>
+#include <functional>
 #include <tuple>
 #include <string>
 #include <ostream>
@@ -10,7 +14,7 @@ namespace agent
 {
 
 class MovementModel;
-class PerceivedMap;
+template<class Grid> class BasicPerceivedMap;
 
 /**
  * Representation of a pair of coordinates.
@@ -25,6 +29,35 @@ struct Position {
     }
 };
 
+/**
+ * Integer coordinates of a cell of the grid.
+ * 
+ * Used by the map and the planner, which only deal with cells. Position is
+ * for continuous coordinates (the robot, the sensors, the walls); converting
+ * between the two is explicit: toPosition gives a cell's Position, and
+ * getNearestCell gives the id of the cell nearest to a Position, from which
+ * computeCellCoord gives its CellCoord.
+*/
+struct CellCoord {
+    short x;
+    short y;
+
+    constexpr bool operator==(const CellCoord& t_other) const { return x == t_other.x && y == t_other.y; }
+    constexpr bool operator!=(const CellCoord& t_other) const { return !(*this == t_other); }
+
+    /**
+     * Both coordinates in a single integer, to hash or sort cells.
+    */
+    constexpr uint32_t packed() const { return (uint32_t)(uint16_t)x << 16 | (uint16_t)y; }
+
+    constexpr Position toPosition() const { return Position{(double)x, (double)y}; }
+
+    std::string toString() const
+    {
+        return "(" + std::to_string(x) + ", " + std::to_string(y) + ")";
+    }
+};
+
 /**
  * Validate a pair of coordinates.
  * 
@@ -32,7 +65,12 @@ struct Position {
  * @param t_y The y coordinate.
  * @return True if the coordinates are valid, false otherwise.
 */
-bool validateCellCoordinates(const int& t_x, const int& t_y);
+template<class Grid = DefaultGrid>
+constexpr bool validateCellCoordinates(const int& t_x, const int& t_y)
+{
+    return t_x >= -Grid::HALF_WIDTH && t_x <= Grid::HALF_WIDTH && (t_x % 2) == 0
+            && t_y >= -Grid::HALF_HEIGHT && t_y <= Grid::HALF_HEIGHT && (t_y % 2) == 0;
+}
 
 /**
  * Validate an identifier.
@@ -40,7 +78,24 @@ bool validateCellCoordinates(const int& t_x, const int& t_y);
  * @param t_id The identifier.
  * @return True if the identifier is valid, false otherwise.
 */
-bool validateCellId(const int& t_id);
+template<class Grid = DefaultGrid>
+constexpr bool validateCellId(const int& t_id)
+{
+    return t_id >= 0 && t_id < Grid::SIZE &&                          // between limits
+           (GridTables<Grid>::VALID[t_id >> 5] >> (t_id & 31) & 1u); // a cell, not a link
+}
+
+/**
+ * Validate the coordinates of a cell.
+ * 
+ * @param t_cell The coordinates.
+ * @return True if the coordinates are valid, false otherwise.
+*/
+template<class Grid = DefaultGrid>
+constexpr bool validateCellCoordinates(const CellCoord& t_cell)
+{
+    return validateCellCoordinates<Grid>(t_cell.x, t_cell.y);
+}
 
 /**
  * Compute an identifier from a pair of coordinates.
@@ -51,7 +106,25 @@ bool validateCellId(const int& t_id);
  * @param t_y The y coordinate.
  * @return The identifier.
 */
-int computeCellId(const int& t_x, const int& t_y);
+template<class Grid = DefaultGrid>
+constexpr int computeCellId(const int& t_x, const int& t_y)
+{
+    return (t_x + Grid::HALF_WIDTH) + (t_y + Grid::HALF_HEIGHT)*Grid::COLS;
+}
+
+/**
+ * Compute an identifier from the coordinates of a cell.
+ * 
+ * It is assumed that the coordinates are valid.
+ * 
+ * @param t_cell The coordinates.
+ * @return The identifier.
+*/
+template<class Grid = DefaultGrid>
+constexpr int computeCellId(const CellCoord& t_cell)
+{
+    return computeCellId<Grid>(t_cell.x, t_cell.y);
+}
 
 /**
  * Compute the coordinates of a cell from its identifier.
@@ -61,7 +134,25 @@ int computeCellId(const int& t_x, const int& t_y);
  * @param t_id The identifier.
  * @return The coordinates.
 */
-Position computeCellCoordinates(const int& t_id);
+template<class Grid = DefaultGrid>
+constexpr CellCoord computeCellCoord(const int& t_id)
+{
+    return CellCoord{GridTables<Grid>::X[t_id], GridTables<Grid>::Y[t_id]};
+}
+
+/**
+ * Compute the position of the center of a cell from its identifier.
+ * 
+ * It is assumed that the identifier is valid.
+ * 
+ * @param t_id The identifier.
+ * @return The position, in the continuous coordinates of the robot.
+*/
+template<class Grid = DefaultGrid>
+constexpr Position computeCellCoordinates(const int& t_id)
+{
+    return computeCellCoord<Grid>(t_id).toPosition();
+}
 
 /**
  * Returns the position of the line in the line sensor.
@@ -128,4 +219,15 @@ double distance(double x1, double y1, double x2, double y2);
 
 }
 
+namespace std
+{
+
+template<>
+struct hash<agent::CellCoord>
+{
+    size_t operator()(const agent::CellCoord& t_cell) const { return t_cell.packed(); }
+};
+
+}
+
 #endif // AGENT_UTILS_H
\ No newline at end of file
@@ -62,6 +62,9 @@ typedef unsigned char bool;
  *  Parameters : 
  *          name - Robot name
  *          host - Host where simulator is running 
+ *                 ("host[:port]" for UDP, "unix:/path" or "unixseq:/path"
+ *                  for a simulator listening on a Unix domain socket,
+ *                  "shm:/name" for a simulator sharing memory segment name)
  *  Returns -1 in case of error
  */
 extern int           InitRobot(char *name,int id, char *host);
@@ -86,6 +89,19 @@ extern int           InitRobot2(char *name,int id, double IRSensorAngles[4], cha
  */
 extern int           InitRobotBeacon(char *name, int id, double height, char *host);
 
+/*! Sets the registration deadline, in milliseconds, for the following
+ *  InitRobot* calls (default 5000, also read from the
+ *  ROBSOCK_REGISTER_TIMEOUT environment variable).
+ *  The register message is resent with exponential backoff until the
+ *  simulator replies, so agents may be started before the simulator.
+ */
+extern void          SetRegisterTimeout(int timeoutMs);
+
+/*! Gets the time taken by registration and the time from its start
+ *  until the first sensor packet, in milliseconds (-1 if not yet known)
+ */
+extern void          GetStartupTimes(double *registerMs, double *firstPacketMs);
+
 
 /**************************************************************************/
 /************* Sensors ****************************************************/
@@ -97,6 +113,64 @@ extern int           InitRobotBeacon(char *name, int id, double height, char *ho
  */
 extern int           ReadSensors(void);
 
+/*! Hands the robot socket over to a background I/O thread that receives
+ *  and parses Measures and sends queued actions, so the agent can keep
+ *  computing while the next packet is in flight. ReadSensors() keeps
+ *  working and returns as soon as a new cycle is available.
+ *  Also enabled by InitRobot* when the ROBSOCK_NETTHREAD environment
+ *  variable is set to a non-zero value.
+ *  Returns -1 in case of error
+ */
+extern int           StartNetworkThread(void);
+
+/*! Network thread mode only: takes the newest sensor values if a new
+ *  cycle has arrived since the last call, never blocks.
+ *  Returns 1 if a new cycle was taken, 0 if not, -1 in case of error
+ */
+extern int           PollSensors(void);
+
+/*! Network thread mode only: waits up to timeoutMs milliseconds
+ *  (forever if negative) for a new cycle.
+ *  Returns 1 if a new cycle was taken, 0 on timeout, -1 in case of error
+ */
+extern int           WaitSensors(int timeoutMs);
+
+/*! Records every sensor reading taken and every action sent into file,
+ *  a binary log that can be played back later with no simulator by
+ *  giving "replay:file" as host, or setting ROBSOCK_REPLAY=file.
+ *  Also started by InitRobot* when ROBSOCK_RECORD=file is set in the
+ *  environment ("%d" in file is replaced by the robot id).
+ *  Returns -1 in case of error
+ */
+extern int           StartRecording(const char *file);
+extern void          StopRecording(void);
+
+/*! Times every cycle, from the Measures packet reaching the kernel to the
+ *  first action sent, and writes percentiles of each phase to stderr
+ *  at Finish. Also enabled by InitRobot* when ROBSOCK_LATENCY is set to
+ *  a non-zero value.
+ *  Returns -1 in case of error
+ */
+extern int           EnableLatencyStats(void);
+
+/*! Adds a phase of the agent's cycle to the latency statistics and
+ *  returns its id, to be given to EndLatencyPhase when the phase ends.
+ *  Returns -1 if the statistics are not enabled, which EndLatencyPhase
+ *  ignores.
+ */
+extern int           AddLatencyPhase(const char *name);
+extern void          EndLatencyPhase(int phase);
+
+/*! Time the last ReadSensors took to parse the Measures, in microseconds
+ *  (0 when they are parsed by the network thread or not parsed at all)
+ */
+extern double        GetParseTime(void);
+
+/*! Number of cycles whose Measures were lost or superseded before
+ *  the agent read them, since the robot was initialized
+ */
+extern unsigned int  GetMissedCycles(void);
+
 /*  The following functions access values that have been read by ReadSensors() 
  *  they do not read new values 
  */
@@ -294,8 +368,128 @@ bool GetBumperRequestable();
 
 void ReadMap(char *filename, void *vmap);
 
+/**************************************************************************/
+/************* Handle-based interface *************************************/
+/**************************************************************************/
+
+/*  Every function above has a counterpart with the H suffix that takes
+ *  the robot handle as first argument, so that one process can drive
+ *  several robots at the same time. Each handle owns its own link
+ *  (socket, measures and simulation parameters).
+ *  The functions without suffix act on the default handle, which is set
+ *  by InitRobot, InitRobot2 and InitRobotBeacon.
+ */
+typedef struct RobLinkHandle *RobHandle;
+
+/*! Same as InitRobot, InitRobot2 and InitRobotBeacon
+ *  Returns 0 (a null handle) in case of error
+ */
+extern RobHandle     InitRobotH(char *name, int id, char *host);
+extern RobHandle     InitRobot2H(char *name, int id, double IRSensorAngles[4], char *host);
+extern RobHandle     InitRobotBeaconH(char *name, int id, double height, char *host);
+
+/*! Registers n robots concurrently, robot i with name names[i] and id ids[i]
+ *  (and IR sensor angles IRSensorAngles[i], unless IRSensorAngles is 0).
+ *  handles[i] is set to 0 for robots that failed to register.
+ *  Returns the number of robots registered
+ */
+extern int           InitRobotsH(int n, char *names[], int ids[], double IRSensorAngles[][4],
+                                 char *host, RobHandle handles[]);
+
+/*! Disconnects the robot and releases the handle */
+extern void          CloseRobotH(RobHandle h);
+
+/*! Disconnects the robot of the default handle */
+extern void          CloseRobot(void);
+
+/*! Gets/sets the handle used by the functions without suffix */
+extern RobHandle     GetDefaultRobot(void);
+extern void          SetDefaultRobot(RobHandle h);
+
+/*! Same as ReadSensors, but returns -1 instead of exiting the process
+ *  in case of error or timeout
+ */
+extern int                  ReadSensorsH(RobHandle h);
+
+extern void                 GetStartupTimesH(RobHandle h, double *registerMs, double *firstPacketMs);
+extern int                  StartNetworkThreadH(RobHandle h);
+extern int                  PollSensorsH(RobHandle h);
+extern int                  WaitSensorsH(RobHandle h, int timeoutMs);
+extern int                  StartRecordingH(RobHandle h, const char *file);
+extern void                 StopRecordingH(RobHandle h);
+extern int                  EnableLatencyStatsH(RobHandle h);
+extern int                  AddLatencyPhaseH(RobHandle h, const char *name);
+extern void                 EndLatencyPhaseH(RobHandle h, int phase);
+extern double               GetParseTimeH(RobHandle h);
+extern unsigned int         GetMissedCyclesH(RobHandle h);
+extern unsigned int         GetTimeH(RobHandle h);
+extern bool                 IsObstacleReadyH(RobHandle h, int id);
+extern double               GetObstacleSensorH(RobHandle h, int id);
+extern int                  GetNumberOfBeaconsH(RobHandle h);
+extern bool                 IsBeaconReadyH(RobHandle h, int id);
+extern struct beaconMeasure GetBeaconSensorH(RobHandle h, int id);
+extern bool                 IsLineSensorReadyH(RobHandle h);
+extern void                 GetLineSensorH(RobHandle h, bool *lineVals);
+extern bool                 IsCompassReadyH(RobHandle h);
+extern double               GetCompassSensorH(RobHandle h);
+extern bool                 NewMessageFromH(RobHandle h, int from);
+extern char *               GetMessageFromH(RobHandle h, int from);
+extern bool                 IsGPSReadyH(RobHandle h);
+extern bool                 IsGPSDirReadyH(RobHandle h);
+extern double               GetXH(RobHandle h);
+extern double               GetYH(RobHandle h);
+extern double               GetDirH(RobHandle h);
+extern bool                 IsGroundReadyH(RobHandle h);
+extern int                  GetGroundSensorH(RobHandle h);
+extern bool                 IsBumperReadyH(RobHandle h);
+extern bool                 GetBumperSensorH(RobHandle h);
+extern bool                 IsScoreReadyH(RobHandle h);
+extern int                  GetScoreSensorH(RobHandle h);
+extern void                 RequestGroundSensorH(RobHandle h);
+extern void                 RequestCompassSensorH(RobHandle h);
+extern void                 RequestBeaconSensorH(RobHandle h, int id);
+extern void                 RequestObstacleSensorH(RobHandle h, int id);
+extern void                 RequestSensorsH(RobHandle h, int nReqs, ...);
+extern bool                 GetStartButtonH(RobHandle h);
+extern bool                 GetStopButtonH(RobHandle h);
+extern bool                 GetFinishedH(RobHandle h);
+extern bool                 GetReturningLedH(RobHandle h);
+extern bool                 GetVisitingLedH(RobHandle h);
+extern void                 DriveMotorsH(RobHandle h, double lPow, double rPow);
+extern void                 SetReturningLedH(RobHandle h, bool val);
+extern void                 SetVisitingLedH(RobHandle h, bool val);
+extern void                 FinishH(RobHandle h);
+extern void                 ResetH(RobHandle h);
+extern void                 SayH(RobHandle h, char *msg);
+extern int                  GetCycleTimeH(RobHandle h);
+extern int                  GetFinalTimeH(RobHandle h);
+extern int                  GetKeyTimeH(RobHandle h);
+extern unsigned int         GetNumberRequestsPerCycleH(RobHandle h);
+extern double               GetNoiseObstacleSensorH(RobHandle h);
+extern double               GetNoiseBeaconSensorH(RobHandle h);
+extern double               GetNoiseCompassSensorH(RobHandle h);
+extern double               GetNoiseMotorsH(RobHandle h);
+extern double               GetBeaconApertureH(RobHandle h);
+extern unsigned int         GetBeaconLatencyH(RobHandle h);
+extern unsigned int         GetGroundLatencyH(RobHandle h);
+extern unsigned int         GetIRLatencyH(RobHandle h);
+extern unsigned int         GetBumperLatencyH(RobHandle h);
+extern bool                 GetBeaconRequestableH(RobHandle h);
+extern bool                 GetGroundRequestableH(RobHandle h);
+extern bool                 GetIRRequestableH(RobHandle h);
+extern bool                 GetBumperRequestableH(RobHandle h);
+
 #ifdef __cplusplus
 }
+
+class CLatencyStats;
+
+/*! The latency statistics of a robot, to read the histogram of each
+ *  phase (see robSock/clatency.h). 0 if they are not enabled
+ */
+extern const CLatencyStats *GetLatencyStats(void);
+extern const CLatencyStats *GetLatencyStatsH(RobHandle h);
+
 #endif
 
 #ifdef CIBERQTAPP
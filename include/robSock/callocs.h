@@ -0,0 +1,51 @@
+/* callocs.h
+ *
+ * Where the heap is hit. When robSock is built with
+ * ROBSOCK_WITH_ALLOC_TRACKING, it replaces the global operator new and
+ * delete with versions that count each allocation, in all and per thread.
+ * malloc called directly, as for exception objects, is not counted.
+ *
+ * The latency statistics (clatency.h) then also count the allocations of
+ * the thread running the cycle in each phase of it, and report them with
+ * the times. The first cycle, which sets the agent up, is left out.
+ *
+ * One allocation in ROBSOCK_ALLOC_SAMPLE (64 by default, 0 for none) has
+ * its call stack kept, in a fixed table of distinct stacks. At exit the
+ * stacks seen most are written to the file named by the ROBSOCK_ALLOCS
+ * environment variable, as "<count> <bytes>" lines each followed by the
+ * frames, indented. Nothing is written when it is not set.
+ *
+ * ROBSOCK_WITH_ALLOC_TRACKING defines ROBSOCK_ALLOC_TRACKING for robSock
+ * and for everything that links it.
+ */
+
+#ifndef _CIBER_ALLOCS_
+#define _CIBER_ALLOCS_
+
+#ifdef ROBSOCK_ALLOC_TRACKING
+
+#include <stdint.h>
+
+#define ALLOC_STACK_DEPTH 16
+#define ALLOC_STACKS      1024
+
+class CAllocs
+{
+public:
+    /*! Allocations, and their bytes, of every thread so far. */
+    static uint64_t count(void);
+    static uint64_t bytes(void);
+
+    /*! Allocations of the calling thread so far. */
+    static uint64_t threadCount(void);
+
+    /*! Writes the sampled stacks, called at exit. */
+    static void flush(void);
+
+private:
+    static bool on;
+};
+
+#endif
+
+#endif
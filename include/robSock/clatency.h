@@ -0,0 +1,118 @@
+/* clatency.h
+ *
+ * Where the time of each cycle goes, from the Measures packet reaching
+ * the kernel to the action being sent.
+ *
+ * A cycle is split in consecutive phases, each timed from the end of the
+ * previous one:
+ *   wakeup   kernel receipt to ReadSensors getting the packet
+ *   parse    Measures parsed
+ *   ...      phases the agent marks itself (AddLatencyPhase)
+ *   send     last mark to the first action of the cycle being sent
+ * and the cycle line times the whole of it. A phase the agent does not
+ * reach in some cycle is counted in the next one marked.
+ *
+ * Each phase keeps a histogram of log-linear buckets (8 per power of two,
+ * so percentiles are within 12%), updated with relaxed atomics: marking a
+ * phase takes a clock read and three atomic adds.
+ *
+ * Built with allocation tracking (callocs.h), each phase also counts the
+ * allocations its thread made in it, from the second cycle on.
+ */
+
+#ifndef _CIBER_LATENCY_
+#define _CIBER_LATENCY_
+
+#include <atomic>
+#include <string>
+#include <stdint.h>
+
+#define LAT_BUCKETS    384
+#define LAT_MAX_PHASES 16
+
+/* phases timed by robSock, the agent's come after them */
+enum { LAT_WAKEUP, LAT_PARSE, LAT_SEND, LAT_CYCLE, LAT_AGENT };
+
+class CLatencyHistogram
+{
+public:
+    CLatencyHistogram();
+
+    void add(long long ns);
+
+    inline uint64_t count() const { return n.load(std::memory_order_relaxed); }
+    inline long long max() const { return maxNs.load(std::memory_order_relaxed); }
+    inline long long total() const { return sumNs.load(std::memory_order_relaxed); }
+
+    /*! Adds the values of another histogram to this one. */
+    void merge(const CLatencyHistogram &other);
+
+    /*! Upper bound of the bucket holding the p-th quantile (0 < p <= 1), in ns. */
+    long long percentile(double p) const;
+
+private:
+    static int bucket(long long ns);
+    static long long upper(int b);
+
+    std::atomic<uint32_t> counts[LAT_BUCKETS];
+    std::atomic<uint64_t> n;
+    std::atomic<long long> maxNs;
+    std::atomic<long long> sumNs;
+};
+
+class CLatencyStats
+{
+public:
+    /*! cycleTimeMs is the simulation cycle, the budget a cycle is compared to. */
+    CLatencyStats(unsigned int cycleTimeMs);
+
+    /*! Adds an agent phase. Returns its id, -1 if there are too many. */
+    int addPhase(const char *name);
+
+    /*! A cycle's Measures were received at recvNs, and reached the kernel
+     *  at kernelNs (0 if unknown). Both on CLOCK_MONOTONIC. */
+    void received(long long kernelNs, long long recvNs);
+    void parsed(void);
+
+    /*! The agent finished phase id. */
+    void mark(int id);
+
+    /*! An action was sent, only the first of each cycle counts. */
+    void sent(void);
+
+    /*! The histogram of a phase, LAT_CYCLE for whole cycles. */
+    inline const CLatencyHistogram &phase(int id) const { return hist[id]; }
+
+    /*! Allocations made in a phase, in all and at most in one cycle.
+     *  Always 0 without allocation tracking. */
+    inline uint64_t allocs(int id) const { return allocCount[id].load(std::memory_order_relaxed); }
+    inline uint64_t maxAllocs(int id) const { return allocMax[id].load(std::memory_order_relaxed); }
+
+    /*! The cycles whose allocations were counted. */
+    inline uint64_t allocCycles(void) const { return allocCycleCount.load(std::memory_order_relaxed); }
+
+    /*! Logs the percentiles of each phase. */
+    void dump(void) const;
+
+private:
+    /*! Counts the allocations since the last phase ended in phase id. */
+    void countAllocs(int id);
+
+    CLatencyHistogram hist[LAT_MAX_PHASES];
+    std::atomic<uint64_t> allocCount[LAT_MAX_PHASES];
+    std::atomic<uint64_t> allocMax[LAT_MAX_PHASES];
+    std::atomic<uint64_t> allocCycleCount;
+    std::string names[LAT_MAX_PHASES];
+    int nPhases;
+    unsigned int cycleTime;
+
+    long long cycleStart;       // CLOCK_MONOTONIC, in ns
+    long long last;             // end of the last phase timed
+    bool inCycle;               // received, no action sent yet
+
+    uint64_t allocLast;         // allocations of the thread when the last phase ended
+    uint64_t allocCycleStart;   // ... and when the cycle started
+    bool allocOn;               // past the first cycle
+};
+
+#endif
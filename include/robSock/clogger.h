@@ -0,0 +1,149 @@
+/* clogger.h
+ *
+ * Diagnostics of robSock and the agent, kept off the control loop.
+ *
+ * ROBSOCK_LOG("format", args...) takes the printf format and arguments
+ * of a message but does not format it: it copies the arguments into
+ * fixed size records in a lock-free ring, and a background thread drains
+ * the ring every few milliseconds, and once more at exit.
+ *
+ * The drained records are formatted and written to stderr, or, when
+ * ROBSOCK_LOG_FILE is set, written as they are to that file, along with
+ * the formats they use, for logdump to turn into text later.
+ *
+ * Arguments may be integers, floating point numbers, C strings or
+ * std::string; strings are copied, up to LOG_MAX_STRING bytes each.
+ * Width and precision given as '*' are not supported.
+ */
+
+#ifndef _CIBER_LOGGER_
+#define _CIBER_LOGGER_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <type_traits>
+
+#define LOG_MAX_ARGS   7
+#define LOG_MAX_STRING 1024
+#define LOG_RING_SLOTS 4096
+
+#define LOG_MAGIC "CIBRTXT1"
+
+/* record ids above the formats */
+#define LOG_FORMAT_DEF 0xffffffffu     // args: id, line; text: file, format
+#define LOG_DROPPED    0xfffffffeu     // args: messages lost to a full ring
+
+/* argument types, 2 bits each in CLogRecord::types */
+enum { LOG_ARG_INT, LOG_ARG_UINT, LOG_ARG_DOUBLE, LOG_ARG_STRING };
+
+struct CLogRecord
+{
+    int64_t  stamp;             // CLOCK_REALTIME, in ns
+    uint32_t id;                // format, or LOG_FORMAT_DEF / LOG_DROPPED
+    uint32_t types;
+    uint32_t nArgs;
+    uint32_t nText;             // records after this one holding its strings
+    union {
+        int64_t  i;
+        uint64_t u;
+        double   d;             // strings: their length, text in the next records
+    } args[LOG_MAX_ARGS];
+};
+
+static_assert(sizeof(CLogRecord) == 80, "log record layout changed");
+
+class CLogger
+{
+public:
+    /*! Registers the format of a ROBSOCK_LOG call site, returns its id. */
+    static uint32_t define(const char *format, const char *file, int line);
+
+    template<typename... Args>
+    static void log(uint32_t id, const Args&... args)
+    {
+        static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many arguments to log");
+
+        CLogRecord r;
+        r.id = id;
+        r.types = 0;
+        r.nArgs = sizeof...(Args);
+        r.nText = 0;
+
+        CLogText text;
+        text.n = 0;
+        pack(r, text, 0, args...);
+        push(r, text);
+    }
+
+    /*! Formats a record, strings holds its string arguments one after
+     *  the other, each ending in a NUL. */
+    static std::string format(const char *fmt, const CLogRecord &r, const char *strings);
+
+    /*! Writes out everything logged so far. */
+    static void flush(void);
+
+private:
+    struct CLogText {
+        int n;
+        const char *s[LOG_MAX_ARGS];
+        uint32_t len[LOG_MAX_ARGS];
+    };
+
+    static inline void pack(CLogRecord &, CLogText &, int) {}
+
+    template<typename T, typename... Rest>
+    static inline void pack(CLogRecord &r, CLogText &text, int i, const T &arg, const Rest&... rest)
+    {
+        packArg(r, text, i, arg);
+        pack(r, text, i + 1, rest...);
+    }
+
+    template<typename T>
+    static inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+    packArg(CLogRecord &r, CLogText &, int i, const T &arg)
+    {
+        if(std::is_signed<T>::value) {
+            r.args[i].i = (int64_t)arg;
+            r.types |= LOG_ARG_INT << (2 * i);
+        }
+        else {
+            r.args[i].u = (uint64_t)arg;
+            r.types |= LOG_ARG_UINT << (2 * i);
+        }
+    }
+
+    template<typename T>
+    static inline typename std::enable_if<std::is_floating_point<T>::value>::type
+    packArg(CLogRecord &r, CLogText &, int i, const T &arg)
+    {
+        r.args[i].d = arg;
+        r.types |= LOG_ARG_DOUBLE << (2 * i);
+    }
+
+    static inline void packArg(CLogRecord &r, CLogText &text, int i, const char *arg)
+    {
+        if(arg == 0) arg = "(null)";
+        uint32_t len = 0;
+        while(len < LOG_MAX_STRING && arg[len] != '\0') len++;
+        r.args[i].u = len;
+        r.types |= LOG_ARG_STRING << (2 * i);
+        text.s[text.n] = arg;
+        text.len[text.n++] = len;
+    }
+
+    static inline void packArg(CLogRecord &r, CLogText &text, int i, const std::string &arg)
+    {
+        packArg(r, text, i, arg.c_str());
+    }
+
+    static void push(CLogRecord &r, const CLogText &text);
+};
+
+#define ROBSOCK_LOG(fmt, ...) do { \
+        static const uint32_t robsockLogId = CLogger::define(fmt, __FILE__, __LINE__); \
+        CLogger::log(robsockLogId, ##__VA_ARGS__); \
+    } while(0)
+
+#endif
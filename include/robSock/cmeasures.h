@@ -22,7 +22,7 @@
 
 #include "RobSock.h"
 #include <vector>
-#include <QString>
+#include <string>
 
 #define NUM_IR_SENSORS 4
 
@@ -71,7 +71,7 @@ public:
     bool gpsDirReady;
 
 
-    QString  hearMessage[10];
+    std::string  hearMessage[10];
 };
 
 #endif
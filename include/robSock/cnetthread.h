@@ -0,0 +1,109 @@
+/* cnetthread.h
+ *
+ * Background network I/O for CRobLink.
+ *
+ * When enabled, a dedicated thread owns the robot transport: it waits on
+ * epoll, drains every pending datagram, parses the newest Measures
+ * message and publishes it through a triple buffer. Actions
+ * produced by the agent are queued and sent by the same thread, in order:
+ * nothing else writes to the transport while it runs.
+ * The agent thread polls or waits (futex with timeout) for a new cycle.
+ *
+ * Linux only.
+ */
+
+#ifndef _CIBER_NETTHREAD_
+#define _CIBER_NETTHREAD_
+
+#include <atomic>
+#include <thread>
+
+#include "cmeasures.h"
+#include "ctransport.h"
+
+#define NETTHREAD_ACTION_SLOTS   16
+#define NETTHREAD_ACTION_MAXSIZE 2048
+
+class CNetThread
+{
+public:
+    CNetThread(CTransport *transport, int nBeacons);
+    ~CNetThread();
+
+    /*! Starts the I/O thread. Returns false if epoll/eventfd setup fails
+     *  or the transport can not be polled. */
+    bool start(void);
+
+    /*! Stops the I/O thread and releases its descriptors. */
+    void stop(void);
+
+    /*! Copies the newest snapshot into m if a new cycle has arrived since
+     *  the last call. Never blocks.
+     *  Returns 1 if m was updated, 0 if no new cycle, -1 on error.
+     */
+    int poll(CMeasures &m);
+
+    /*! Same as poll, but waits up to timeoutMs for a new cycle
+     *  (timeoutMs < 0 waits forever).
+     *  Returns 1 if m was updated, 0 on timeout, -1 on error.
+     */
+    int wait(CMeasures &m, int timeoutMs);
+
+    /*! Queues an action message to be sent by the I/O thread, waiting
+     *  for room while the queue is full.
+     *  Returns false, and counts the action as lost, if the message is
+     *  too big or the I/O thread has stopped.
+     */
+    bool send(const char *xml, int n);
+
+    /*! Number of actions that could not be queued. */
+    inline unsigned int lostActions() const { return actionsLost.load(std::memory_order_relaxed); }
+
+    /*! Number of Measures messages published so far. */
+    inline unsigned int cycles() const { return published.load(std::memory_order_acquire); }
+
+    /*! Number of Measures messages received but superseded by a newer one
+     *  before the agent consumed them. */
+    inline unsigned int superseded() const { return dropped.load(std::memory_order_relaxed); }
+
+    /*! CLOCK_MONOTONIC time (ns) at which the first Measures message was
+     *  published, 0 if none yet. */
+    inline long long firstPacketNs() const { return first.load(std::memory_order_acquire); }
+
+    /*! Size of the datagram that produced the last consumed snapshot. */
+    inline int lastSize() const { return frontSize; }
+
+private:
+    void run(void);
+    void flushActions(void);
+    bool take(CMeasures &m);
+
+    static const int DIRTY = 4;
+
+    CTransport *transport;
+    int nBeacons;
+
+    CMeasures buffers[3];
+    int sizes[3];
+    int back, front, frontSize;
+    std::atomic<int> middle;            // buffer index, or'ed with DIRTY when fresh
+
+    std::atomic<int> published;         // futex word, incremented on each publish
+    std::atomic<unsigned int> dropped;
+    std::atomic<long long> first;
+    std::atomic<bool> failed;
+
+    struct ActionSlot {
+        int  len;
+        char xml[NETTHREAD_ACTION_MAXSIZE];
+    };
+    ActionSlot actions[NETTHREAD_ACTION_SLOTS];
+    std::atomic<unsigned int> actionHead, actionTail;
+    std::atomic<unsigned int> actionsLost;
+
+    int epollfd, wakefd;
+    std::atomic<bool> running;
+    std::thread thread;
+};
+
+#endif
@@ -0,0 +1,57 @@
+/* creplaybackend.h
+ *
+ * Plays a log written by CRobRecorder back to the agent, with no
+ * simulator: each ReadSensors takes the next recorded Measures, as fast
+ * as the agent asks for them.
+ *
+ * The actions the agent sends are checked against the recorded ones and
+ * every mismatch is reported as a divergence: a different action, one the
+ * log does not have, or one the log has and the agent did not send.
+ * Sensor requests, Say and Reset never reach a backend and are not
+ * checked. With ROBSOCK_REPLAY_STRICT=1 the replay stops at the first
+ * divergence, so ReadSensors fails.
+ */
+
+#ifndef _CIBER_REPLAYBACKEND_
+#define _CIBER_REPLAYBACKEND_
+
+#include "crobbackend.h"
+#include "crobrecord.h"
+
+#include <stddef.h>
+
+#include <string>
+
+class CReplayBackend : public CRobBackend
+{
+public:
+    CReplayBackend(const char *file);
+
+    /*! Reports how the agent followed the log. */
+    ~CReplayBackend();
+
+    virtual bool registerRobot(const char *name, int id, CSimParam &param);
+    virtual bool readSensors(CMeasures &m);
+
+    virtual void driveMotors(double lPow, double rPow);
+    virtual void setEndLed(bool on);
+    virtual void setReturningLed(bool on);
+    virtual void setVisitingLed(bool on);
+
+    inline unsigned int divergences() const { return nDiverged; }
+
+private:
+    void check(int type, double lPow, double rPow, bool on);
+    void diverged(const CRobLogRecord *recorded, int type, double lPow, double rPow, bool on);
+
+    std::string file;
+    CRobLog *log;
+    size_t next;                // record after the last one played or matched
+    unsigned int cycles;
+    unsigned int lastTime;
+    unsigned int nDiverged;
+    unsigned int firstDivergence;
+    bool strict;
+};
+
+#endif
@@ -0,0 +1,49 @@
+/* crobbackend.h
+ *
+ * In-process alternative to a simulator on the network: CRobLink hands
+ * its calls straight to a backend, which fills CMeasures itself, with no
+ * socket and no XML in between.
+ *
+ * The backend is used when
+ *   - the host given to InitRobot* is "sim:" or "sim:labfile",
+ *   - ROBSOCK_BACKEND=sim is set in the environment, or
+ *   - the program is linked with the robSockSim objects, unless
+ *     ROBSOCK_BACKEND=udp is set.
+ * Otherwise CRobLink talks to a simulator through its CTransport.
+ *
+ * A recorded log is played back instead (see CReplayBackend) when the
+ * host is "replay:logfile" or ROBSOCK_REPLAY=logfile is set.
+ */
+
+#ifndef _CIBER_ROBBACKEND_
+#define _CIBER_ROBBACKEND_
+
+#include "cmeasures.h"
+#include "csimparam.h"
+
+class CRobBackend
+{
+public:
+    virtual ~CRobBackend() {}
+
+    /*! Creates the backend selected for host, 0 to use the network. */
+    static CRobBackend *create(const char *host);
+
+    /*! Makes the in-process backend the default (see robSockSim). */
+    static void setDefault(bool inProcess);
+
+    /*! Registers the robot. Fills param and returns false if refused. */
+    virtual bool registerRobot(const char *name, int id, CSimParam &param) = 0;
+
+    /*! Gets the measures of the next cycle. Returns false once the
+     *  simulation is over. */
+    virtual bool readSensors(CMeasures &m) = 0;
+
+    /*! As the CRobLink calls, setting a LED also stops the motors. */
+    virtual void driveMotors(double lPow, double rPow) = 0;
+    virtual void setEndLed(bool on) = 0;
+    virtual void setReturningLed(bool on) = 0;
+    virtual void setVisitingLed(bool on) = 0;
+};
+
+#endif
@@ -20,17 +20,24 @@
 #ifndef _CIBER_ROBLINK_
 #define _CIBER_ROBLINK_
 
+#ifdef CIBERQTAPP
 #include <qobject.h>
+#endif
 #include <assert.h>
 
 #include <stdarg.h>
 
 #include "cmeasures.h"
 #include "csimparam.h"
-#include "netif.h"
+#include "ctransport.h"
 
 #include "structureparser.h"
 
+class CNetThread;
+class CRobBackend;
+class CRobRecorder;
+class CLatencyStats;
+
 #include <iostream>
 
 using std::cerr;
@@ -73,13 +80,13 @@ public:
 	inline bool   collisionReady() { return measures.collisionReady; }
     inline bool   collision() { return measures.collision; }
 	inline bool   lineSensorReady() { return measures.lineSensorReady; }
-    inline vector<bool>   lineSensor() { return measures.lineSensor; }
+    inline const vector<bool> &lineSensor() { return measures.lineSensor; }
 	inline bool   scoreReady() { return measures.scoreReady; }
     inline int    score() { return measures.score; }
     inline bool   gpsReady() { return measures.gpsReady; }
     inline bool   gpsDirReady() { return measures.gpsDirReady; }
-	inline bool   newMessage(int from) { return measures.hearMessage[from-1]!=QString(); }
-	inline QString   message(int from) { return measures.hearMessage[from-1]; }
+	inline bool   newMessage(int from) { return !measures.hearMessage[from-1].empty(); }
+	inline const std::string &message(int from) { return measures.hearMessage[from-1]; }
 
 	void requestGround();
 	void requestCompass();
@@ -120,6 +127,54 @@ public:
 	inline double posy() { return measures.y; }
 	inline double posdir() { return measures.dir; }
 
+	/*! Hands the socket over to a background I/O thread (see CNetThread).
+	 *  Returns false if the thread could not be started. */
+	bool startNetThread(void);
+	inline bool netThreadActive() { return netThread != 0; }
+
+	/*! Threaded mode only: takes the newest measures if a new cycle arrived.
+	 *  Returns 1 if measures were updated, 0 if not, -1 on error. */
+	int PollSensors(void);
+
+	/*! Threaded mode only: waits up to timeoutMs for a new cycle.
+	 *  Returns 1 if measures were updated, 0 on timeout, -1 on error. */
+	int WaitSensors(int timeoutMs);
+
+	/*! Time taken by registration and from its start until the first sensor
+	 *  packet, in milliseconds (-1 if not yet known). */
+	inline double registerTime() { return registerMs; }
+	inline double firstPacketTime() { return firstPacketMs; }
+	inline int registerTries() { return registerAttempts; }
+
+	/*! Deadline for registration, in milliseconds, used by robots created
+	 *  afterwards. The register message is resent with exponential backoff
+	 *  until the server replies or the deadline expires. */
+	static inline void setRegisterTimeout(int ms) { registerTimeout = ms; }
+
+	/*! Records every measures taken and action sent into file, a binary
+	 *  log that CReplayBackend plays back (see crobrecord.h).
+	 *  Returns false if the file can not be written. */
+	bool startRecording(const char *file);
+	void stopRecording(void);
+	inline bool recording() { return recorder != 0; }
+
+	/*! Times each cycle, from the Measures reaching the kernel to the
+	 *  first action sent, split in phases (see clatency.h). The results
+	 *  are logged at Finish, and kept in latencyStats(). */
+	bool enableLatencyStats(void);
+	int addLatencyPhase(const char *name);
+	void endLatencyPhase(int id);
+	inline const CLatencyStats *latencyStats() { return latency; }
+
+	/*! Time the last Measures took to parse, in ns (0 when parsed on the
+	 *  I/O thread or not parsed at all), and cycles whose Measures never
+	 *  reached the agent, from gaps in the simulation time. */
+	inline long long parseTime() { return parseNs; }
+	inline unsigned int missedCycles() { return missed; }
+
+	/*! Parses a Measures message into m. Returns false on parse error. */
+	static bool parse_measures(const char *xml, int len, unsigned int nBeacons, CMeasures &m);
+
 #ifdef CIBERQTAPP
 signals:
     void NewMessage();
@@ -131,14 +186,38 @@ protected:
      void send_register_message(char *robot_name, int robId);
      void send_register_message(char *robot_name, int robId, double IRSensorAngles[]);
      void send_robotbeacon_register_message(char *rob_name,int rob_id, double height);
-     void parse_server_reply(void);
+     void register_robot(char *xml, int n);
+     void register_backend(char *rob_name, int rob_id);
+     bool parse_server_reply(const char *xml, int n);
+     void send_action(char *xml, int n);
+     void init_startup_times(void);
+     void note_first_packet(long long arrival);
+     void note_cycle(void);
+     void dump_latency(void);
 
 private:
 	CMeasures measures;	// measures sent by simulator
 	CSimParam simParam;	// simulation parameters sent after registration
     int Status;	
 
-    Port port;			// communication port
+    CTransport *transport;	// communication with the simulator
+    CRobBackend *backend;	// in-process simulation, replaces the transport
+    CNetThread *netThread;	// background I/O, 0 when reading synchronously
+    CRobRecorder *recorder;	// log of measures and actions, 0 when not recording
+    CLatencyStats *latency;	// cycle timing, 0 when not enabled
+    bool latencyDumped;
+
+    std::string robName;
+    int robId;
+
+    static int registerTimeout;	// registration deadline, in ms
+    long long registerStart;	// CLOCK_MONOTONIC, in ns
+    int registerAttempts;
+    double registerMs, firstPacketMs;
+
+    long long parseNs;		// last Measures parse, in ns
+    int lastTime;		// time of the last Measures taken, -1 before the first
+    unsigned int missed;	// cycles skipped between Measures taken
   
 };
 
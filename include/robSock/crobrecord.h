@@ -0,0 +1,157 @@
+/* crobrecord.h
+ *
+ * Binary log of what a robot saw and did: every Measures it took and
+ * every action it sent, each in a fixed size record stamped with the time
+ * since the recording started.
+ *
+ * A log is a CRobLogHeader, holding the simulation parameters, followed
+ * by CRobLogRecord entries, all in the host byte order, so a reader maps
+ * the file and indexes the records directly (see CRobLog).
+ * Beacons, messages heard and the text of Say are not kept.
+ */
+
+#ifndef _CIBER_ROBRECORD_
+#define _CIBER_ROBRECORD_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "cmeasures.h"
+#include "csimparam.h"
+
+#define ROBLOG_MAGIC "CIBRLOG1"
+
+/* record types */
+enum {
+    ROBLOG_MEASURES = 1,
+    ROBLOG_DRIVE,               // DriveMotors
+    ROBLOG_END_LED,             // Finish
+    ROBLOG_RETURNING_LED,
+    ROBLOG_VISITING_LED,
+    ROBLOG_REQUEST,             // any sensor request
+    ROBLOG_SAY,
+    ROBLOG_RESET
+};
+
+/* flags of ROBLOG_MEASURES records */
+#define ROBLOG_COMPASS_READY    0x00001
+#define ROBLOG_IR_READY(i)      (0x00002 << (i))
+#define ROBLOG_GROUND_READY     0x00020
+#define ROBLOG_COLLISION_READY  0x00040
+#define ROBLOG_COLLISION        0x00080
+#define ROBLOG_LINE_READY       0x00100
+#define ROBLOG_GPS_READY        0x00200
+#define ROBLOG_GPS_DIR_READY    0x00400
+#define ROBLOG_SCORE_READY      0x00800
+#define ROBLOG_START            0x01000
+#define ROBLOG_STOP             0x02000
+#define ROBLOG_END              0x04000
+#define ROBLOG_RETURNING        0x08000
+#define ROBLOG_VISITING         0x10000
+
+/* flags of the LED records */
+#define ROBLOG_ON               0x00001
+
+struct CRobLogHeader
+{
+    char     magic[8];          // ROBLOG_MAGIC, without the NUL
+    uint32_t headerSize;        // sizeof(CRobLogHeader)
+    uint32_t recordSize;        // sizeof(CRobLogRecord)
+    int32_t  robotId;
+    uint32_t reserved0;
+    char     robotName[32];
+    int64_t  startTime;         // CLOCK_REALTIME when the recording started, in ns
+
+    /* CSimParam */
+    double   obstNoise, beaconNoise, motorsNoise, compassNoise, beaconAperture;
+    uint32_t simTimeFinal, keyTime, cycleTime, nBeacons;
+    uint32_t obstLatency, beaconLatency, groundLatency, compassLatency, collisionLatency;
+    uint32_t requestable;       // bit 0 obst, 1 beacon, 2 ground, 3 compass, 4 collision
+    uint32_t nReqPerCycle;
+
+    uint32_t reserved[11];
+};
+
+struct CRobLogSensors
+{
+    double compass;
+    double ir[NUM_IR_SENSORS];
+    double x, y, dir;
+};
+
+struct CRobLogMotors
+{
+    double lPow, rPow;
+};
+
+struct CRobLogRecord
+{
+    int64_t  stamp;             // ns since the recording started
+    uint32_t type;              // ROBLOG_*
+    uint32_t flags;
+    uint32_t time;              // simulation time; for actions, that of the last measures
+    int32_t  ground;
+    uint32_t score;
+    uint16_t lineBits;          // bit i set when line sensor element i is on the line
+    uint16_t lineCount;
+    union {
+        CRobLogSensors sensors; // ROBLOG_MEASURES
+        CRobLogMotors  motors;  // ROBLOG_DRIVE, 0 for the LEDs (they stop the robot)
+    };
+};
+
+static_assert(sizeof(CRobLogHeader) == 192, "log header layout changed");
+static_assert(sizeof(CRobLogRecord) == 96, "log record layout changed");
+
+/* Writes a log. Records are buffered and reach the file when the
+ * buffer fills, on flush() and when the recorder is deleted. */
+class CRobRecorder
+{
+public:
+    /*! Creates file. Returns 0 if it can not be written. */
+    static CRobRecorder *open(const char *file, const char *name, int id, const CSimParam &param);
+    ~CRobRecorder();
+
+    void measures(const CMeasures &m);
+    void action(int type, double lPow = 0.0, double rPow = 0.0, bool on = false);
+
+    void flush(void);
+
+private:
+    CRobRecorder(FILE *f);
+
+    FILE *fp;
+    long long start;            // CLOCK_MONOTONIC, in ns
+    unsigned int lastTime;
+};
+
+/* A log mapped in memory, read only. */
+class CRobLog
+{
+public:
+    /*! Maps file. Returns 0 if it can not be read or is not a log. */
+    static CRobLog *open(const char *file);
+    ~CRobLog();
+
+    inline const CRobLogHeader &header() const { return *hdr; }
+    inline size_t size() const { return count; }
+    inline const CRobLogRecord &operator[](size_t i) const { return records[i]; }
+
+    /*! The simulation parameters the robot was registered with. */
+    void params(CSimParam &param) const;
+
+    /*! Restores the measures of a ROBLOG_MEASURES record. */
+    static void unpack(const CRobLogRecord &rec, CMeasures &m);
+
+private:
+    CRobLog() {}
+
+    void *base;
+    size_t length;
+    const CRobLogHeader *hdr;
+    const CRobLogRecord *records;
+    size_t count;
+};
+
+#endif
@@ -0,0 +1,113 @@
+/* cshmring.h
+ *
+ * Shared memory channel between robots and a simulator on the same host.
+ *
+ * The simulator creates a named segment (shm_open) holding a fixed number
+ * of robot slots. A robot claims a free slot and from then on exchanges
+ * messages through two single-producer/single-consumer rings in it:
+ * Actions from the robot to the simulator, Measures the other way.
+ * A reader spins briefly and then sleeps on a futex in the ring; a writer
+ * only issues a wake when the reader is sleeping, so a busy exchange
+ * does not need any system call.
+ *
+ * A slot is FREE until a robot claims it. The simulator marks it ATTACHED
+ * when it accepts the robot's registration. The robot marks it CLOSED
+ * when it is done, and the simulator then reclaims it, emptying its rings
+ * and making it FREE again; it does the same for a slot whose robot
+ * process has died.
+ *
+ * Linux only.
+ */
+
+#ifndef _CIBER_SHMRING_
+#define _CIBER_SHMRING_
+
+#include <atomic>
+#include <stdint.h>
+
+#define SHM_MAX_ROBOTS 8
+#define SHM_RING_SLOTS 16
+#define SHM_MSGMAXSIZE 4096
+
+class CShmRing
+{
+public:
+    void reset(void);
+
+    /*! Appends a message. Returns false if the ring is full or n is too big. */
+    bool push(const void *buf, int n);
+
+    /*! Takes the oldest message. Returns its size, or -1 if the ring is empty. */
+    int pop(void *buf, int size);
+
+    inline bool empty() const
+        { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_relaxed); }
+
+    /*! Waits up to timeoutMs (forever if negative) for a message.
+     *  Returns 1 if one is ready, 0 on timeout. */
+    int wait(int timeoutMs);
+
+private:
+    alignas(64) std::atomic<uint32_t> head;     // written by the producer
+    alignas(64) std::atomic<uint32_t> tail;     // written by the consumer
+    alignas(64) std::atomic<int> seq;           // futex word, bumped on push
+    std::atomic<int> sleepers;
+
+    struct Slot {
+        int  len;
+        char data[SHM_MSGMAXSIZE];
+    };
+    alignas(64) Slot slots[SHM_RING_SLOTS];
+};
+
+enum { SHM_SLOT_FREE, SHM_SLOT_CLAIMED, SHM_SLOT_ATTACHED, SHM_SLOT_CLOSED };
+
+struct CShmRobot
+{
+    std::atomic<int> state;     // SHM_SLOT_*
+    std::atomic<int> pid;       // process that claimed the slot, 0 until it is known
+    CShmRing actions;           // robot -> simulator
+    CShmRing measures;          // simulator -> robot
+};
+
+class CShmSegment
+{
+public:
+    /*! Simulator side: creates (or recreates) the segment called name. */
+    static CShmSegment *create(const char *name);
+
+    /*! Robot side: maps an existing segment, 0 if there is none. */
+    static CShmSegment *open(const char *name);
+
+    static void release(CShmSegment *seg);
+    static void remove(const char *name);
+
+    /*! Robot side: claims a free slot. Returns its index, or -1. */
+    int claim(void);
+
+    /*! Simulator side: true if the robot of a claimed slot closed it or
+     *  its process is gone. */
+    bool abandoned(int slot);
+
+    /*! Simulator side: empties a slot and makes it free again. */
+    void reclaim(int slot);
+
+    /*! Notifies the simulator that a slot changed or a message was sent. */
+    void ring(void);
+
+    /*! Simulator side: waits up to timeoutMs for a ring() after the
+     *  doorbell was read as seen. Returns the current doorbell value. */
+    int waitDoorbell(int seen, int timeoutMs);
+    inline int doorbellValue() const { return doorbell.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<uint32_t> magic;        // set last by create()
+    uint32_t size;
+    std::atomic<int> doorbell;
+    std::atomic<int> sleepers;
+
+public:
+    CShmRobot robots[SHM_MAX_ROBOTS];
+};
+
+#endif
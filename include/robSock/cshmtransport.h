@@ -0,0 +1,44 @@
+/* cshmtransport.h
+ *
+ * Shared memory transport ("shm:/name"), for a simulator stand-in running
+ * on the same host (see CShmSegment, and bin/simulator --listen shm:/name). Messages never go through the
+ * kernel, so a cycle takes microseconds instead of a loopback round trip.
+ *
+ * The segment is looked up on send until the simulator has created it,
+ * so robots may be started first. There is no descriptor to poll, so the
+ * network thread can not be used with this transport.
+ */
+
+#ifndef _CIBER_SHMTRANSPORT_
+#define _CIBER_SHMTRANSPORT_
+
+#include <string>
+
+#include "ctransport.h"
+#include "cshmring.h"
+
+class CShmTransport : public CTransport
+{
+public:
+    CShmTransport(const char *name);
+    ~CShmTransport();
+
+    bool init(void);
+    bool send(const void *buf, int n);
+    int  recv(void *buf, int size);
+    int  wait(int timeoutMs);
+    bool setRecvTimeout(int ms) { recvTimeoutMs = ms; return true; }
+    int  drain(char *buf, int size, unsigned int *superseded);
+    bool reliable(void) { return true; }
+    int  fd(void) { return -1; }
+
+private:
+    bool attach(void);
+
+    std::string name;
+    int recvTimeoutMs;
+    CShmSegment *segment;
+    CShmRobot *robot;
+};
+
+#endif
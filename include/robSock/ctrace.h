@@ -0,0 +1,70 @@
+/* ctrace.h
+ *
+ * Timeline of the robot's cycle, for chrome://tracing or Perfetto.
+ *
+ * ROBSOCK_TRACE_SCOPE("name") times the rest of the enclosing block as
+ * one event. Events go to a ring buffer owned by the calling thread, the
+ * newest TRACE_RING_EVENTS of each thread are kept, and at exit they are
+ * written as Chrome trace JSON to the file named by the ROBSOCK_TRACE
+ * environment variable. Nothing is recorded when it is not set.
+ *
+ * Scopes compile to nothing unless robSock is built with
+ * ROBSOCK_WITH_TRACE, which defines ROBSOCK_TRACE for it and for
+ * everything that links it.
+ */
+
+#ifndef _CIBER_TRACE_
+#define _CIBER_TRACE_
+
+#ifdef ROBSOCK_TRACE
+
+#include <time.h>
+
+#define TRACE_RING_EVENTS (1 << 16)
+
+class CTrace
+{
+public:
+    /*! True if the events are written somewhere. */
+    static inline bool enabled() { return on; }
+
+    static inline long long now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    /*! Adds an event to the calling thread's ring. name must be a
+     *  string literal, or live until the process ends. */
+    static void event(const char *name, long long start, long long end);
+
+    /*! Writes the events recorded so far, called at exit. */
+    static void flush(void);
+
+private:
+    static bool on;
+};
+
+class CTraceScope
+{
+public:
+    inline CTraceScope(const char *n) : name(n), start(CTrace::enabled() ? CTrace::now() : 0) {}
+    inline ~CTraceScope() { if(start) CTrace::event(name, start, CTrace::now()); }
+
+private:
+    const char *name;
+    long long start;
+};
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define ROBSOCK_TRACE_SCOPE(name) CTraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#else
+
+#define ROBSOCK_TRACE_SCOPE(name) do {} while(0)
+
+#endif
+
+#endif
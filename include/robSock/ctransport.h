@@ -0,0 +1,96 @@
+/* ctransport.h
+ *
+ * Datagram transport used by CRobLink to talk to the simulator.
+ *
+ * The implementation is selected by the host string given to InitRobot*:
+ *   "host[:port]"      UDP (default, see Port)
+ *   "unix:/path"       AF_UNIX SOCK_DGRAM socket bound at /path
+ *   "unixseq:/path"    AF_UNIX SOCK_SEQPACKET socket listening at /path
+ *   "shm:/name"        shared memory segment created with shm_open
+ */
+
+#ifndef _CIBER_TRANSPORT_
+#define _CIBER_TRANSPORT_
+
+#include "netif.h"
+
+class CTransport
+{
+public:
+    virtual ~CTransport() {}
+
+    /*! Creates the transport selected by host, 0 if host is malformed
+     *  (an empty or too long path or name). port is the UDP port used
+     *  when host does not name one. */
+    static CTransport *create(const char *host, int port);
+
+    /*! Opens the transport. Returns false on error. */
+    virtual bool init(void) = 0;
+
+    /*! Sends one datagram. Returns false on error. */
+    virtual bool send(const void *buf, int n) = 0;
+
+    /*! Receives one datagram, waiting up to the receive timeout.
+     *  Returns its size, or -1 on error or timeout. */
+    virtual int recv(void *buf, int size) = 0;
+
+    /*! Waits up to timeoutMs for a datagram.
+     *  Returns 1 if one is ready, 0 on timeout, -1 on error. */
+    virtual int wait(int timeoutMs) = 0;
+
+    virtual bool setRecvTimeout(int ms) = 0;
+
+    /*! Receives every pending datagram without blocking and keeps only the
+     *  newest one in buf. Adds the number of older ones to superseded.
+     *  Returns the size of the newest, 0 if none was pending, -1 on error. */
+    virtual int drain(char *buf, int size, unsigned int *superseded) = 0;
+
+    /*! Called once registration is accepted: from then on talk to the
+     *  endpoint that sent the reply (the simulator's per robot socket). */
+    virtual void acceptPeer(void) {}
+
+    /*! True if datagrams can not be lost, so registration is not resent. */
+    virtual bool reliable(void) { return false; }
+
+    /*! Descriptor that becomes readable when a datagram arrives,
+     *  -1 if the transport can not be polled. */
+    virtual int fd(void) = 0;
+
+    /*! Asks the kernel to stamp received datagrams with their arrival
+     *  time. Returns false if the transport can not. */
+    virtual bool enableTimestamps(void) { return false; }
+
+    /*! When the datagram last returned by recv() reached the kernel, on
+     *  CLOCK_MONOTONIC in ns, 0 if unknown. */
+    virtual long long lastRecvTime(void) { return 0; }
+
+protected:
+    /* drain() for transports built on a socket; on connected sockets an
+     * empty read is the end of the connection and makes it fail */
+    static int drainSocket(int fd, char *buf, int size, unsigned int *superseded,
+                           bool connected = false);
+};
+
+/* UDP transport, the protocol spoken by the CiberRato simulator */
+class CUdpTransport : public CTransport
+{
+public:
+    CUdpTransport(int port, char *host) : port(port, host, 0) {}
+
+    bool init(void) { return port.init(); }
+    bool send(const void *buf, int n) { return port.send_info(const_cast<void *>(buf), n); }
+    int  recv(void *buf, int size) { return port.recv_info(buf, size); }
+    int  wait(int timeoutMs) { return port.wait_info(timeoutMs); }
+    bool setRecvTimeout(int ms) { return port.SetRcvTimeout(ms / 1000, (ms % 1000) * 1000); }
+    int  drain(char *buf, int size, unsigned int *superseded)
+            { return drainSocket(port.socketfd, buf, size, superseded); }
+    void acceptPeer(void) { port.SetRemote(port.GetLastSender()); }
+    int  fd(void) { return port.socketfd; }
+    bool enableTimestamps(void) { return port.EnableTimestamps(); }
+    long long lastRecvTime(void);
+
+private:
+    Port port;
+};
+
+#endif
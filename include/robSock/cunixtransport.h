@@ -0,0 +1,51 @@
+/* cunixtransport.h
+ *
+ * AF_UNIX transport, for a simulator running on the same host.
+ *
+ * With SOCK_DGRAM the client socket is autobound to an abstract address
+ * so the server can reply, and after registration it talks to the
+ * socket that sent the reply, as with UDP.
+ * With SOCK_SEQPACKET the connection itself identifies the robot and
+ * message boundaries are kept; it is (re)connected on send until the
+ * server accepts it, so robots may be started before the server.
+ */
+
+#ifndef _CIBER_UNIXTRANSPORT_
+#define _CIBER_UNIXTRANSPORT_
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "ctransport.h"
+
+class CUnixTransport : public CTransport
+{
+public:
+    CUnixTransport(const char *path, int type);
+    ~CUnixTransport();
+
+    bool init(void);
+    bool send(const void *buf, int n);
+    int  recv(void *buf, int size);
+    int  wait(int timeoutMs);
+    bool setRecvTimeout(int ms);
+    int  drain(char *buf, int size, unsigned int *superseded);
+    void acceptPeer(void);
+    bool reliable(void) { return type == SOCK_SEQPACKET; }
+    int  fd(void) { return socketfd; }
+
+private:
+    bool connectServer(void);
+
+    int type;                       // SOCK_DGRAM or SOCK_SEQPACKET
+    int socketfd;
+    bool connected;
+    int recvTimeoutMs;
+
+    struct sockaddr_un remote;
+    socklen_t remoteLen;
+    struct sockaddr_un lastSender;
+    socklen_t lastSenderLen;
+};
+
+#endif
@@ -30,10 +30,13 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <time.h>
 
 #else
 
 #include <WinSock2.h>
+#include <WS2tcpip.h>
 
 #endif
 
@@ -58,6 +61,9 @@ class Port {
 		sockaddr_in     GetLastSender(void);
 		void            SetRemote(sockaddr_in rem_addr);
 		bool            SetRcvTimeout(int sec, int usec);
+		int             wait_info(int timeoutMs);
+		bool            EnableTimestamps(void);
+		bool            GetLastTimestamp(struct timespec *ts);
 
 
 		int		socketfd ;			/* socket discriptor */
@@ -69,6 +75,8 @@ class Port {
 		char		host[256] ;			/* remote host name */
 		int		portnum ;			/* remote port number */
 		int		localport ;			/* local port number */
+		bool		timestamps ;			/* kernel receive timestamps enabled */
+		struct timespec	last_stamp ;			/* when the last message reached the kernel (CLOCK_REALTIME) */
 } ;
 
 #endif
@@ -24,18 +24,18 @@
 #define STRUCTURE_PARSER_H
 
 
-#include <qxml.h>
+#include <string.h>
+#include <string>
 
+#include "xmlreader.h"
 #include "csimparam.h"
 #include "cmeasures.h"
 
-class QString;
-
 #include <iostream>
 
 using std::cerr;
 
-class StructureParser : public QXmlDefaultHandler
+class StructureParser : public XmlHandler
 {
 private:
 	CSimParam simParam;
@@ -50,17 +50,16 @@ public:
     }
     bool startDocument();
     bool endDocument();
-    bool startElement(const QString&, const QString&, const QString&, const QXmlAttributes&);
-    bool endElement(const QString&, const QString&, const QString&);
-	bool characters(const QString& data);
-	void setDocumentLocator(QXmlLocator*);
+    bool startElement(const std::string&, const XmlAttributes&);
+    bool endElement(const std::string&);
+	bool characters(const std::string& data);
     virtual bool startCDATA();
     virtual bool endCDATA();
 
 	inline CSimParam *getSimParam() { return &simParam; }
 	inline CMeasures *getMeasures() { return &measures; }
 private:
-     QString activeTag;
+     std::string activeTag;
      unsigned int hearFrom;
      bool cdata;
 };                   
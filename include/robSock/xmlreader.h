@@ -0,0 +1,82 @@
+/* xmlreader.h
+ *
+ * Minimal SAX-style XML reader used to parse the messages exchanged
+ * with the simulator and the lab description files.
+ *
+ * Supports elements, attributes (single or double quoted), character
+ * data, CDATA sections, comments, processing instructions and the five
+ * predefined entities plus numeric character references.
+ * DTDs are skipped, namespaces are not interpreted.
+ */
+
+#ifndef _CIBER_XMLREADER_
+#define _CIBER_XMLREADER_
+
+#include <string>
+#include <vector>
+#include <utility>
+
+class XmlAttributes
+{
+public:
+    /*! Returns the value of attribute name, or 0 if it is not present. */
+    const std::string *value(const char *name) const;
+
+    inline int count() const { return n; }
+    inline const std::string &name(int i) const { return attrs[i].first; }
+    inline const std::string &value(int i) const { return attrs[i].second; }
+
+private:
+    friend class XmlReader;
+
+    /* storage is reused between elements to avoid reallocations */
+    std::pair<std::string,std::string> &append(void);
+    inline void clear() { n = 0; }
+
+    std::vector< std::pair<std::string,std::string> > attrs;
+    int n{0};
+};
+
+class XmlHandler
+{
+public:
+    virtual ~XmlHandler() {}
+
+    /* returning false from any callback aborts the parse */
+    virtual bool startDocument() { return true; }
+    virtual bool endDocument() { return true; }
+    virtual bool startElement(const std::string &, const XmlAttributes &) { return true; }
+    virtual bool endElement(const std::string &) { return true; }
+    virtual bool characters(const std::string &) { return true; }
+    virtual bool startCDATA() { return true; }
+    virtual bool endCDATA() { return true; }
+};
+
+class XmlReader
+{
+public:
+    XmlReader() : handler(0), depth(0) {}
+
+    inline void setContentHandler(XmlHandler *h) { handler = h; }
+
+    /*! Parses a document held in memory.
+     *  Returns false if it is not well formed or the handler aborted. */
+    bool parse(const char *data, size_t len);
+    bool parse(const char *data);
+
+    /*! Parses a document stored in a file. */
+    bool parseFile(const char *filename);
+
+private:
+    bool parseElement(const char *&p, const char *end);
+    bool parseEndElement(const char *&p, const char *end);
+    bool decode(const char *b, const char *e, std::string &out);
+
+    XmlHandler *handler;
+    XmlAttributes attributes;
+    std::vector<std::string> open;  // stack of open elements
+    int depth;
+    std::string tag, text;
+};
+
+#endif
@@ -0,0 +1,91 @@
+/* clab.h
+ *
+ * Arena, starting grid and simulation parameters, loaded from the same
+ * XML files given to the CiberRato simulator (--param, --lab, --grid).
+ *
+ * Lab rows come in two flavours, told apart by where the characters are:
+ *
+ *  - wall mazes (challenges 1 to 3): <Row Pos Pattern> with 3 characters
+ *    per cell, decoded by StructureParser into '|' and '-' walls;
+ *  - line mazes (challenge 4): <Row Pos Pattern> with a cell at every even
+ *    row and column and the strips between them ('-', '|', '/', '\') at
+ *    the odd positions, as in the map files written by the agent.
+ *    Digits at a cell position mark a target at that cell.
+ *
+ * Row 0 is the bottom of the arena. Cells are 2 units wide and, as in the
+ * real lab, line maze cells leave a 1 unit border around the arena.
+ */
+
+#ifndef _CIBER_LAB_
+#define _CIBER_LAB_
+
+#include <string>
+#include <vector>
+
+#include "robSock/csimparam.h"
+
+/* strips are drawn 0.2 wide, as assumed by the agent (MapWall) */
+#define LAB_LINE_WIDTH 0.2
+#define LAB_WALL_WIDTH 0.1
+#define LAB_TARGET_RADIUS 0.5
+
+struct CLabSegment
+{
+    double x0, y0, x1, y1;
+};
+
+struct CLabTarget
+{
+    double x, y, radius;
+};
+
+struct CLabPose
+{
+    double x, y, dir;   // dir in degrees, as in the grid file
+};
+
+class CLab
+{
+public:
+    CLab();
+
+    /*! Each returns false if the file can not be read or is malformed. */
+    bool loadParameters(const char *filename);
+    bool loadLab(const char *filename);
+    bool loadGrid(const char *filename);
+
+    /*! Same as loadLab, from a document held in memory. */
+    bool parseLab(const char *xml, size_t len);
+
+    /*! True if (x,y) is on a strip. */
+    bool onLine(double x, double y) const;
+
+    /*! True if a robot of the given radius at (x,y) hits a wall or leaves the arena. */
+    bool collides(double x, double y, double radius) const;
+
+    /*! Index of the target (x,y) is in, -1 if none. */
+    int targetAt(double x, double y) const;
+
+    /*! Starting pose of the robot registered with id (1 based). */
+    CLabPose startPose(int id) const;
+
+    std::string name;
+    double width, height;
+    std::vector<CLabSegment> lines;     // strips on the floor
+    std::vector<CLabSegment> walls;
+    std::vector<CLabTarget> targets;
+    std::vector<CLabPose> grid;
+
+    CSimParam param;
+    bool gps;               // send GPS measures
+    double lineNoise;       // % of line sensor elements read wrong
+
+private:
+    void indexLines(void);
+
+    /* lines near each 1x1 square of the arena, so onLine only checks a few */
+    int binCols, binRows;
+    std::vector< std::vector<int> > lineBins;
+};
+
+#endif
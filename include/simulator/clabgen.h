@@ -0,0 +1,77 @@
+/* clabgen.h
+ *
+ * Random line mazes, for labs other than the course's. A maze is a tree
+ * of links grown from the starting cell over a grid of cells, with loops
+ * added on top of it and dead ends closed until few enough are left.
+ * Links join 8-connected neighbors, but two diagonals never cross, as a
+ * lab file can not draw them both. The same options and seed always give
+ * the same maze.
+ *
+ * The maze is written as CiberRato lab and grid files (see clab.h) and as
+ * its ground-truth graph: one line per target and per link, in the cell
+ * coordinates of the agent (2 units per cell, relative to the start, y up):
+ *   target <id> <x> <y>
+ *   link <x0> <y0> <x1> <y1>
+ *
+ * Mazes of up to 25x11 cells, the start in the middle, fit the agent's
+ * map, and of up to 49x21 its map of agent::LargeGrid (agent/grid.h).
+ * Larger ones are for the simulator only.
+ */
+
+#ifndef _CIBER_LABGEN_
+#define _CIBER_LABGEN_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+struct CLabGenOptions
+{
+    CLabGenOptions();
+
+    int cols, rows;         // cells of the grid, 13x6 as the course lab
+    double cover;           // fraction of the cells the lines reach
+    double diagonal;        // share of diagonal links in the tree
+    double loops;           // fraction of the other possible links added to the tree
+    int deadEnds;           // at most this many dead ends, -1 for as many as the tree has
+    int targets;            // targets besides the start (1 to 9)
+    unsigned int seed;
+};
+
+class CLabGen
+{
+public:
+    /*! Generates the maze. */
+    explicit CLabGen(const CLabGenOptions &options);
+
+    std::string labXml(const std::string &name) const;
+    std::string gridXml(void) const;
+    std::string graph(void) const;
+
+    inline int nCols() const { return cols; }
+    inline int nRows() const { return rows; }
+
+    /*! Cells are numbered row * nCols() + col, row 0 at the bottom. */
+    inline int startCell() const { return start; }
+    inline const std::vector< std::pair<int,int> > &getLinks() const { return links; }
+    inline const std::vector<int> &getTargets() const { return targets; }    // the start first
+
+    /*! Cells with a single link. */
+    int deadEnds(void) const;
+
+private:
+    /*! Directions 0 to 7 go counterclockwise from east. */
+    int neighbor(int cell, int dir) const;
+    bool canLink(int cell, int dir) const;
+    void link(int cell, int dir);
+
+    int cols, rows;
+    int start;
+    std::vector<bool> reached;
+    std::vector<unsigned char> linked;  // a bit per direction
+    std::vector< std::pair<int,int> > links;
+    std::vector<bool> crossings;        // a diagonal is drawn in the square at its lower left cell
+    std::vector<int> targets;
+};
+
+#endif
@@ -0,0 +1,83 @@
+/* cscore.h
+ *
+ * Scores of the files written by the challenge 4 agent against the lab it
+ * ran in:
+ *
+ *  - the map (.map, see PerceivedMap::writeMapToFile): 21 rows of 49
+ *    characters, the starting cell in the middle, cells at even rows and
+ *    columns, links ('-', '|', '/', '\') between them and target ids on
+ *    their cells. It scores +1 for every link drawn as in the lab and -1
+ *    for every other link drawn, so the lab itself scores its number of
+ *    links;
+ *  - the path (.path, see PerceivedMap::writePathToFile): one "x y" cell
+ *    per line, relative to the start. It scores the length of the
+ *    shortest closed tour through every target over its own length, 1
+ *    for the best path, and 0 if it leaves the lines, misses a target or
+ *    does not start and end at the start.
+ *
+ * The lab is drawn once, with the shortest tour, when the scorer is made,
+ * so scoring a run only reads its two files.
+ *
+ * These are not the rules of the simulator's mapping_score.awk and
+ * planning_score.awk, which are not in this tree, and their scores have
+ * not been compared. They rank runs against one another (mainBatch,
+ * bench-map); the official scores are the scripts', as test-run.sh and
+ * loop.sh report them.
+ */
+
+#ifndef _CIBER_SCORE_
+#define _CIBER_SCORE_
+
+#include <stddef.h>
+
+#include "clab.h"
+
+#define SCORE_ROWS 21
+#define SCORE_COLS 49
+
+/* a map as drawn in a .map file */
+struct CScoreMap
+{
+    CScoreMap();
+
+    /*! Missing characters are blanks. Returns false if the file can not be read. */
+    bool read(const char *filename);
+    void parse(const char *text, size_t len);
+
+    /*! Draws the lab around the starting pose of robot 1. */
+    void draw(const CLab &lab);
+
+    char cells[SCORE_ROWS][SCORE_COLS];
+};
+
+class CScorer
+{
+public:
+    /*! Takes the ground truth from lab, with its grid. */
+    explicit CScorer(const CLab &lab);
+
+    inline const CScoreMap &truth() const { return lab; }
+
+    int mapScore(const CScoreMap &map) const;
+    inline int bestMapScore() const { return nLinks; }
+
+    /*! Returns 0 if the file can not be read. */
+    double pathScore(const char *filename) const;
+    double pathScore(const char *text, size_t len) const;
+
+    /*! Length of the shortest closed tour through the targets, in cells. */
+    inline double bestTour() const { return tour; }
+
+private:
+    bool linked(int cell, int drow, int dcol) const;
+    void distancesFrom(int cell, double *dist) const;
+
+    CScoreMap lab;
+    int nLinks;
+    int targets[10];        // cell of each target, row * SCORE_COLS + col, the start first
+    int nTargets;
+    signed char targetAt[SCORE_ROWS * SCORE_COLS];     // index in targets, -1 if none
+    double tour;
+};
+
+#endif
@@ -0,0 +1,43 @@
+/* csimbackend.h
+ *
+ * In-process backend for CRobLink (see CRobBackend): every robot gets a
+ * world of its own, advanced one cycle each time the agent reads its
+ * sensors, so an episode runs as fast as the agent can think.
+ *
+ * The world is read from the files named by ROBSOCK_SIM_PARAM,
+ * ROBSOCK_SIM_LAB (unless the host names the lab) and ROBSOCK_SIM_GRID.
+ * Each file is parsed once per process. ROBSOCK_SIM_NOISE, if set,
+ * scales every noise level of the parameter file (0 for a noiseless
+ * world). Robots get consecutive noise seeds, starting at
+ * ROBSOCK_SIM_SEED (or the current time).
+ */
+
+#ifndef _CIBER_SIMBACKEND_
+#define _CIBER_SIMBACKEND_
+
+#include "robSock/crobbackend.h"
+#include "csimulator.h"
+
+class CSimBackend : public CRobBackend
+{
+public:
+    /*! labFile, if given, overrides ROBSOCK_SIM_LAB. */
+    CSimBackend(const char *labFile);
+    ~CSimBackend();
+
+    bool registerRobot(const char *name, int id, CSimParam &param);
+    bool readSensors(CMeasures &m);
+
+    void driveMotors(double lPow, double rPow);
+    void setEndLed(bool on);
+    void setReturningLed(bool on);
+    void setVisitingLed(bool on);
+
+private:
+    std::string labFile;
+    CSimulator *sim;
+    bool first;         // no cycle has been read yet
+    bool over;          // the last cycle has been read
+};
+
+#endif
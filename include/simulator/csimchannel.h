@@ -0,0 +1,77 @@
+/* csimchannel.h
+ *
+ * The simulator's side of a robot transport (see robSock/ctransport.h).
+ *
+ * The channel is selected by the same strings robots are given:
+ *   "unix:/path"       AF_UNIX SOCK_DGRAM socket bound at /path
+ *   "unixseq:/path"    AF_UNIX SOCK_SEQPACKET socket listening at /path
+ *   "shm:/name"        shared memory segment created with shm_open
+ *   ""                 UDP on the server port, as the CiberRato simulator
+ *
+ * Each robot that sends a registration gets a link, the endpoint the
+ * simulator answers it from and later exchanges Measures and Actions on.
+ * Links are numbered from 0 and never reused.
+ */
+
+#ifndef _CIBER_SIMCHANNEL_
+#define _CIBER_SIMCHANNEL_
+
+#include <string>
+#include <vector>
+
+#include "robSock/netif.h"
+
+class CSimChannel
+{
+public:
+    virtual ~CSimChannel() {}
+
+    /*! Creates the channel selected by address, 0 if address is malformed.
+     *  port is the UDP server port. */
+    static CSimChannel *create(const std::string &address, int port);
+
+    /*! Opens the channel. Returns false on error. */
+    virtual bool init(void) = 0;
+
+    /*! Waits up to timeoutMs (forever if negative) for a registration or
+     *  a message from a robot. Returns false on error. */
+    virtual bool wait(int timeoutMs) = 0;
+
+    /*! Takes a pending registration message without blocking. Returns its
+     *  size, 0 if none is pending. link is set to the robot's link: a new
+     *  one, or the one of an earlier registration the robot resent. */
+    virtual int registration(char *buf, int size, int &link) = 0;
+
+    /*! Answers the registration of link. A refused link is closed. */
+    virtual void reply(int link, const char *buf, int n, bool accepted) = 0;
+
+    /*! Takes the next message of link without blocking. Returns its size,
+     *  0 if none is pending, -1 once the robot is gone. */
+    virtual int recv(int link, char *buf, int size) = 0;
+
+    /*! Sends a message to link. Returns false on error. */
+    virtual bool send(int link, const char *buf, int n) = 0;
+};
+
+/* UDP channel: robots register on the server port and are answered from
+ * a port of their own; a resent registration comes from the same sender */
+class CSimUdpChannel : public CSimChannel
+{
+public:
+    CSimUdpChannel(int port) : server(port) {}
+    ~CSimUdpChannel();
+
+    bool init(void) { return server.init(); }
+    bool wait(int timeoutMs);
+    int  registration(char *buf, int size, int &link);
+    void reply(int link, const char *buf, int n, bool accepted);
+    int  recv(int link, char *buf, int size);
+    bool send(int link, const char *buf, int n);
+
+private:
+    Port server;
+    std::vector<Port *> ports;          // per link, 0 until accepted or once refused
+    std::vector<sockaddr_in> remotes;   // where each link registered from
+};
+
+#endif
@@ -0,0 +1,85 @@
+/* csimrobot.h
+ *
+ * A simulated robot: motors, pose and the sensors used in the line maze
+ * challenge (line sensor, compass, ground and collision).
+ *
+ * The motion model is the one described in the assignment, and mirrored
+ * by the agent's MovementModel: each motor output is an IIR filter of the
+ * requested power with multiplicative N(1,sigma) noise, the robot then
+ * translates along its heading and rotates by the difference of the two
+ * outputs over its diameter. A move that collides is replaced by the
+ * rotation alone.
+ */
+
+#ifndef _CIBER_SIMROBOT_
+#define _CIBER_SIMROBOT_
+
+#include <string>
+#include <random>
+
+#include "robSock/RobSock.h"
+#include "robSock/cmeasures.h"
+#include "clab.h"
+
+#define ROBOT_DIAMETER 1.0
+#define MAX_POWER 0.15
+
+/* line sensor geometry, in robot diameters (see the assignment) */
+#define LINE_SENSOR_DIST 0.438
+#define LINE_SENSOR_SEP  0.08
+
+class CSimRobot
+{
+public:
+    CSimRobot(int id, const std::string &name, const CLabPose &start);
+
+    /*! Applies an Actions message. Returns false if it is malformed. */
+    bool actions(const char *xml, int n);
+
+    /*! Same as the LeftMotor and RightMotor Actions attributes. */
+    void setMotors(double lPow, double rPow);
+    inline void setEndLed(bool on) { endLed = on; }
+    inline void setReturningLed(bool on) { returningLed = on; }
+    inline void setVisitingLed(bool on) { visitingLed = on; }
+
+    /*! Moves the robot one cycle with the last requested powers. */
+    void move(const CLab &lab, std::mt19937 &rng);
+
+    /*! Reads the sensors at the current pose. */
+    void sense(const CLab &lab, std::mt19937 &rng);
+
+    /*! Writes the Measures message for cycle time into buf, with its
+     *  terminating NUL. Returns its size. */
+    int measures(char *buf, int size, const CLab &lab, unsigned int time, bool started) const;
+
+    /*! Fills m as if it had been parsed from that message. */
+    void measures(CMeasures &m, const CLab &lab, unsigned int time, bool started) const;
+
+    inline int id() const { return robotId; }
+    inline const std::string &name() const { return robotName; }
+    inline bool finished() const { return endLed; }
+    inline double x() const { return posX; }
+    inline double y() const { return posY; }
+    inline double dir() const { return posDir; }
+    inline unsigned int collisions() const { return nCollisions; }
+
+    /*! Forgets the requested powers, the motors wind down. */
+    inline void stopMotors() { inL = inR = 0.0; }
+
+private:
+    int robotId;
+    std::string robotName;
+
+    double posX, posY, posDir;      // dir in radians, (-pi, pi]
+    double inL, inR;                // requested powers
+    double outL, outR;              // effective powers
+    bool endLed, returningLed, visitingLed;
+
+    bool collision;
+    unsigned int nCollisions;
+    double compass;                 // degrees
+    int ground;
+    bool line[N_LINE_ELEMENTS];
+};
+
+#endif
@@ -0,0 +1,57 @@
+/* csimserver.h
+ *
+ * Serves a CSimulator with the CiberRato protocol: robots register on the
+ * server's channel (UDP by default, see csimchannel.h) and are answered
+ * on a link of their own, which then carries their Measures and Actions.
+ * A robot whose link goes away no longer takes part.
+ *
+ * In real time mode a cycle lasts CycleTime milliseconds, as in the
+ * CiberRato simulator. In unthrottled mode the next cycle starts as soon
+ * as every robot has sent its actions for the current one.
+ */
+
+#ifndef _CIBER_SIMSERVER_
+#define _CIBER_SIMSERVER_
+
+#include <string>
+#include <vector>
+
+#include "csimchannel.h"
+#include "csimulator.h"
+
+#define SIM_MAX_ROBOTS 8
+
+/* unthrottled mode: how long a silent robot may hold the others, in ms */
+#define SIM_ACTION_TIMEOUT 1000
+
+class CSimServer
+{
+public:
+    /*! Serves sim on the channel selected by address (see csimchannel.h),
+     *  UDP on port when it is empty. */
+    CSimServer(CSimulator &sim, const std::string &address, int port);
+    ~CSimServer();
+
+    /*! Opens the channel. Returns false on error or if address is malformed. */
+    bool init(void);
+
+    /*! Waits for nRobots (at most SIM_MAX_ROBOTS) to register. */
+    void waitRobots(int nRobots);
+
+    /*! Starts the simulation and runs it until it is over. */
+    void run(bool unthrottled);
+
+private:
+    void registration(void);
+    void receiveActions(int i, bool *acted);
+    void collectActions(bool unthrottled);
+    void sendMeasures(void);
+
+    CSimulator &sim;
+    CSimChannel *channel;
+    std::vector<int> links;             // the channel's link of each robot
+    std::vector<bool> reported;         // robot has seen its EndLed
+    std::vector<bool> gone;             // robot's link went away
+};
+
+#endif
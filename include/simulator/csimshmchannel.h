@@ -0,0 +1,43 @@
+/* csimshmchannel.h
+ *
+ * Shared memory channel, the simulator's end of CShmTransport: it creates
+ * the segment (see robSock/cshmring.h) and serves the robots that claim
+ * its slots. A slot's first message is the robot's registration.
+ *
+ * Robots ring the segment's doorbell when they claim a slot or send, so
+ * waiting is a futex wait. The slots of robots that closed them or died
+ * are reclaimed whenever the channel looks at them, and their links are
+ * gone. The segment is removed when the channel is closed.
+ */
+
+#ifndef _CIBER_SIMSHMCHANNEL_
+#define _CIBER_SIMSHMCHANNEL_
+
+#include "robSock/cshmring.h"
+#include "csimchannel.h"
+
+class CSimShmChannel : public CSimChannel
+{
+public:
+    CSimShmChannel(const char *name);
+    ~CSimShmChannel();
+
+    bool init(void);
+    bool wait(int timeoutMs);
+    int  registration(char *buf, int size, int &link);
+    void reply(int link, const char *buf, int n, bool accepted);
+    int  recv(int link, char *buf, int size);
+    bool send(int link, const char *buf, int n);
+
+private:
+    bool reclaimed(int slot);
+
+    std::string name;
+    CShmSegment *segment;
+    int doorbell;                       // the doorbell value last seen
+
+    std::vector<int> slots;             // per link, -1 once it is gone
+    int slotLinks[SHM_MAX_ROBOTS];      // per slot, its link or -1
+};
+
+#endif
@@ -0,0 +1,64 @@
+/* csimulator.h
+ *
+ * The simulated world: a lab and the robots in it, advanced one cycle at
+ * a time. It does no I/O, CSimServer puts it on the network.
+ */
+
+#ifndef _CIBER_SIMULATOR_
+#define _CIBER_SIMULATOR_
+
+#include <string>
+#include <vector>
+#include <random>
+
+#include "clab.h"
+#include "csimrobot.h"
+
+/* cycles after SimTime left for robots to report they finished */
+#define SIM_GRACE_CYCLES 50
+
+class CSimulator
+{
+public:
+    /*! lab must outlive the simulator. seed makes the noise repeatable. */
+    CSimulator(const CLab &lab, unsigned int seed);
+
+    /*! Adds a robot at grid position id. Returns its index,
+     *  or -1 if the simulation has already started. */
+    int addRobot(int id, const std::string &name);
+
+    inline int nRobots() const { return robots.size(); }
+    inline CSimRobot &robot(int i) { return robots[i]; }
+    inline const CLab &getLab() const { return lab; }
+
+    /*! Presses the Start button. */
+    inline void start() { running = true; }
+    inline bool started() const { return running; }
+
+    /*! Moves every robot one cycle and reads their sensors. */
+    void step(void);
+
+    inline unsigned int time() const { return cycle; }
+
+    /*! True once every robot has finished, or some time after SimTime. */
+    bool over(void) const;
+
+    /*! Writes the registration Reply, with its terminating NUL, into buf.
+     *  Returns its size. */
+    int reply(char *buf, int size, bool accepted) const;
+
+    /*! Writes robot i's Measures for the current cycle into buf. */
+    inline int measures(int i, char *buf, int size) const
+        { return robots[i].measures(buf, size, lab, cycle, running); }
+    inline void measures(int i, CMeasures &m) const
+        { robots[i].measures(m, lab, cycle, running); }
+
+private:
+    const CLab &lab;
+    std::vector<CSimRobot> robots;
+    std::mt19937 rng;
+    unsigned int cycle;
+    bool running;
+};
+
+#endif
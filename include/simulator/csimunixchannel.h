@@ -0,0 +1,52 @@
+/* csimunixchannel.h
+ *
+ * AF_UNIX channel, the simulator's end of CUnixTransport.
+ *
+ * With SOCK_DGRAM the server socket is bound at the path, robots register
+ * on it and are answered from an autobound socket of their own, as with
+ * UDP. With SOCK_SEQPACKET each accepted connection is a link, and the
+ * robot is gone once it closes it.
+ *
+ * The path is unlinked when the channel is opened and when it is closed.
+ */
+
+#ifndef _CIBER_SIMUNIXCHANNEL_
+#define _CIBER_SIMUNIXCHANNEL_
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "csimchannel.h"
+
+class CSimUnixChannel : public CSimChannel
+{
+public:
+    CSimUnixChannel(const char *path, int type);
+    ~CSimUnixChannel();
+
+    bool init(void);
+    bool wait(int timeoutMs);
+    int  registration(char *buf, int size, int &link);
+    void reply(int link, const char *buf, int n, bool accepted);
+    int  recv(int link, char *buf, int size);
+    bool send(int link, const char *buf, int n);
+
+private:
+    struct Link {
+        int fd;                     // the robot's socket or connection, -1 if none
+        struct sockaddr_un remote;  // SOCK_DGRAM: where the robot registered from
+        socklen_t remoteLen;
+        bool registered;            // SOCK_SEQPACKET: its registration was taken
+        bool gone;
+    };
+
+    void acceptConnections(void);
+    void close(int link);
+
+    int type;                       // SOCK_DGRAM or SOCK_SEQPACKET
+    struct sockaddr_un local;
+    int serverfd;
+    std::vector<Link> links;
+};
+
+#endif
@@ -26,8 +26,9 @@ run() {
 }
 
 silent_mode=0
+batch_mode=0
 
-while getopts "c:s" op
+while getopts "c:sb" op
 do
     case $op in
         "c")
@@ -36,6 +37,9 @@ do
         "s")
             silent_mode=1
             ;;
+        "b")
+            batch_mode=1
+            ;;
         default)
             echo "ERROR: unknown parameter"
             ;;
@@ -72,6 +76,18 @@ case $challenge in
         done
         ;;
     4)
+        if [ "$batch_mode" != 0 ]; then
+            # every run in-process, several at a time (see src/mainBatch.cpp), scored by
+            # bin/score, which is not yet known to agree with the awk scripts below
+            mkdir -p "$BATCH_DIR"
+            if [ "$silent_mode" != 0 ]; then
+                $BIN_DIR/mainBatch $SIMULATOR_ARGS_C4 --seeds 1-$NUM_RUNS --out "$BATCH_DIR" --csv "$BATCH_DIR/report.csv" >/dev/null
+            else
+                $BIN_DIR/mainBatch $SIMULATOR_ARGS_C4 --seeds 1-$NUM_RUNS --out "$BATCH_DIR" --csv "$BATCH_DIR/report.csv"
+            fi
+            exit
+        fi
+
         # remove old scores and failed runs
         rm $SCORES_FILE >/dev/null 2>&1 || true
         rm -r $FAILED_DIR >/dev/null 2>&1 || true 
@@ -99,7 +115,7 @@ case $challenge in
             
             score=$(echo $line | cut -d' ' -f2)
             total_path_score=$(echo "scale=2;$total_path_score + $score" | bc)
-        done < scores.txt
+        done < $SCORES_FILE
 
         total_map_score=$(echo "scale=2;$total_map_score / $NUM_RUNS" | bc -l)
         total_path_score=$(echo "scale=2;$total_path_score / $NUM_RUNS" | bc -l)
@@ -0,0 +1,79 @@
+/* arena.cpp
+ */
+
+#include "agent/arena.h"
+#include "agent/metrics.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace agent
+{
+
+// blocks arenas took from the heap when their buffer was full (see metrics.h)
+static Counter& s_blocks = Metrics::global().counter("arena.blocks");
+
+static inline size_t alignUp(size_t t_n, size_t t_align)
+{
+    return (t_n + t_align - 1) & ~(t_align - 1);
+}
+
+/*** Arena implementation ***/
+
+Arena::Arena(size_t t_capacity)
+    : m_buffer(static_cast<char*>(::operator new(t_capacity))), m_capacity(t_capacity)
+{
+}
+
+Arena::~Arena()
+{
+    reset();
+    ::operator delete(m_buffer);
+}
+
+void* Arena::allocate(size_t t_bytes, size_t t_align)
+{
+    // the buffer and the blocks are aligned for any type, offsets within them are aligned here
+    assert(t_align > 0 && (t_align & (t_align - 1)) == 0 && t_align <= alignof(std::max_align_t));
+
+    size_t start = alignUp(m_offset, t_align);
+    if(start + t_bytes <= m_capacity)
+    {
+        m_used += start + t_bytes - m_offset;
+        m_offset = start + t_bytes;
+        return m_buffer + start;
+    }
+
+    // full: a block of its own, until the next reset
+    size_t header = alignUp(sizeof(Block), alignof(std::max_align_t));
+    Block* block = static_cast<Block*>(::operator new(header + t_bytes));
+    block->next = m_blocks;
+    m_blocks = block;
+    m_used += t_bytes + t_align;
+    s_blocks.add();
+
+    return reinterpret_cast<char*>(block) + header;
+}
+
+void Arena::reset()
+{
+    if(m_blocks != nullptr)
+    {
+        while(m_blocks != nullptr)
+        {
+            Block* next = m_blocks->next;
+            ::operator delete(m_blocks);
+            m_blocks = next;
+        }
+
+        // grow the buffer to hold all that was used, at least doubling it
+        ::operator delete(m_buffer);
+        m_capacity = std::max(2*m_capacity, m_used);
+        m_buffer = static_cast<char*>(::operator new(m_capacity));
+    }
+
+    m_offset = 0;
+    m_used = 0;
+}
+
+} // namespace agent
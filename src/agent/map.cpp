@@ -1,12 +1,12 @@
 #include "agent/map.h"
+#include "agent/metrics.h"
 #include "agent/utils.h"
+#include "robSock/clogger.h"
+#include "robSock/ctrace.h"
 
 #include <algorithm>
 #include <cmath>
 #include <stdexcept>
-#include <map>
-#include <queue>
-#include <set>
 #include <fstream>
 #include <limits>
 #include <iostream>
@@ -14,44 +14,68 @@
 namespace agent
 {
 
+// work done by the map (see metrics.h)
+static Counter& s_astarExpanded = Metrics::global().counter("map.astar.expanded");
+static Counter& s_bfsLayers = Metrics::global().counter("map.bfs.layers");
+static Counter& s_unlinked = Metrics::global().counter("map.unlinked");
+static Gauge& s_cells = Metrics::global().gauge("map.cells");
+
 /*** MapWall implementation ***/
 
-void MapWall::update(const int& t_id, const double& t_dir)
+// unit vectors perpendicular to each direction (rotated by 90 degrees)
+static const double s_normalX[N_DIRECTIONS] = {0.0, -M_SQRT1_2, -1.0, -M_SQRT1_2, 0.0, M_SQRT1_2, 1.0, M_SQRT1_2};
+static const double s_normalY[N_DIRECTIONS] = {1.0, M_SQRT1_2, 0.0, -M_SQRT1_2, -1.0, -M_SQRT1_2, 0.0, M_SQRT1_2};
+
+// euclidean distance between two cells
+static inline double cellDistance(const CellCoord& t_c1, const CellCoord& t_c2)
 {
-    if(!validateCellId(t_id))
+    int dx = t_c2.x - t_c1.x, dy = t_c2.y - t_c1.y;
+    return std::sqrt((double)(dx*dx + dy*dy));
+}
+
+// the character of a link in the map file, by direction
+static const char s_linkChar[N_DIRECTIONS] = {'-', '/', '|', '\\', '-', '/', '|', '\\'};
+
+template<class Grid>
+void BasicMapWall<Grid>::update(const int& t_id, const int& t_dir)
+{
+    if(!validateCellId<Grid>(t_id))
         throw std::invalid_argument("Map::wall::update - t_id=" + std::to_string(t_id) + " is not a valid identifier");    
 
-    m_corners.clear();
+    // next cell
+    int nid = t_dir >= 0 && t_dir < N_DIRECTIONS ? neighborCellId<Grid>(t_id, t_dir) : -1;
+    if(nid < 0)
+        throw std::invalid_argument("Map::wall::update - no cell next to " + std::to_string(t_id) + " in direction " + std::to_string(t_dir));
+
+    m_nCorners = 0;
 
-    // compute next cell coordinates
-    double dir = t_dir;
-    Position c1 = computeCellCoordinates(t_id);
-    Position c2{c1.x + 2*round(cos(dir)), c1.y + 2*round(sin(dir))};
+    Position c1 = computeCellCoordinates<Grid>(t_id);
+    Position c2 = computeCellCoordinates<Grid>(nid);
 
-    // rotate direction by 90 degrees to compute the wall corners
-    dir+=M_PI/2;
-    if(dir > M_PI) dir -= 2*M_PI;
-    else if(dir < -M_PI) dir += 2*M_PI;
+    // the wall corners, half a width to each side of the line
+    double dx = PATH_WALL_WIDTH*0.5*s_normalX[t_dir];
+    double dy = PATH_WALL_WIDTH*0.5*s_normalY[t_dir];
 
     // add corners
     bool ret = true;
-    ret &= addCorner(c1.x + PATH_WALL_WIDTH*0.5*cos(dir), c1.y + PATH_WALL_WIDTH*0.5*sin(dir));
-    ret &= addCorner(c1.x - PATH_WALL_WIDTH*0.5*cos(dir), c1.y - PATH_WALL_WIDTH*0.5*sin(dir));
-    ret &= addCorner(c2.x - PATH_WALL_WIDTH*0.5*cos(dir), c2.y - PATH_WALL_WIDTH*0.5*sin(dir));
-    ret &= addCorner(c2.x + PATH_WALL_WIDTH*0.5*cos(dir), c2.y + PATH_WALL_WIDTH*0.5*sin(dir));
+    ret &= addCorner(c1.x + dx, c1.y + dy);
+    ret &= addCorner(c1.x - dx, c1.y - dy);
+    ret &= addCorner(c2.x - dx, c2.y - dy);
+    ret &= addCorner(c2.x + dx, c2.y + dy);
 
     if(!ret) throw std::logic_error("Something went wrong when updating wall");
 
     // cells that define the wall
-    m_cells = std::make_pair(t_id, computeCellId(c2.x, c2.y));
+    m_cells = std::make_pair(t_id, nid);
 }
 
-bool MapWall::isInside(const double& t_x, const double& t_y) const
+template<class Grid>
+bool BasicMapWall<Grid>::isInside(const double& t_x, const double& t_y) const
 {
-    if(m_corners.size() < 4)
+    if(m_nCorners < 4)
         throw std::logic_error("Wall is not fully defined");
 
-    int n = m_corners.size();
+    int n = m_nCorners;
     bool inside = false;
     
     for(int i = 0, j = n-1; i < n; j = i++)
@@ -66,139 +90,108 @@ bool MapWall::isInside(const double& t_x, const double& t_y) const
     return inside;
 }
 
-bool MapWall::addCorner(const double& t_x, const double& t_y)
+template<class Grid>
+bool BasicMapWall<Grid>::addCorner(const double& t_x, const double& t_y)
 {
-    if(m_corners.size() >= 4) return false;
+    if(m_nCorners >= 4) return false;
 
     // round the corners to the nearest decimal
     Position corner;
     corner.x = t_x;
     corner.y = t_y;
 
-    m_corners.push_back(corner);
+    m_corners[m_nCorners++] = corner;
     return true;
 }
 
 
-/*** MapCell implementation ***/
-
-MapCell::MapCell(int t_id)
-    : m_id(t_id)
-{
-    if(!validateCellId(t_id))
-        throw std::invalid_argument("MapCell::MapCell - t_id=" + std::to_string(t_id) + " is not a valid identifier");
-}
-
-bool MapCell::linkNeighbor(int t_id)
-{
-    if(!validateCellId(t_id))
-        throw std::invalid_argument("MapCell::linkNeighbor - t_id=" + std::to_string(t_id) + " is not a valid identifier");
-
-    Position c = computeCellCoordinates(m_id);
-    Position n = computeCellCoordinates(t_id);
-
-    // check if t_id is a neighbor
-    int dist = sqrt(pow(c.x - n.x, 2) + pow(c.y - n.y, 2)); // euclidean distance (casted to integer)
-    if(dist != 2)
-        throw std::invalid_argument("MapCell::linkNeighbor - t_id=" + std::to_string(t_id) +" is not a neighbor of " + std::to_string(m_id) + " (distance=" + std::to_string(dist) + ")");
-
-    // (check if cell is already expanded) or t_id is already a neighbor
-    if(isExpanded() || std::find(m_neighbors.begin(), m_neighbors.end(), t_id) != m_neighbors.end())
-        return false;
-
-    // add the neighbor
-    m_neighbors.push_back(t_id);
-
-    int x = (int)c.x;
-    int y = (int)c.y;
-    // corner cells are expanded with 3 neighbors
-    bool corner_full = (x == -24 || x == 24) && (y == -10 || y == 10) && m_neighbors.size() >= 3;
-    // margin cells are expanded with 5 neighbors
-    bool margin_full = (x == -24 || x == 24 || y == -10 || y == 10) && m_neighbors.size() >= 5;
-    // middle cells are expanded with 8 neighbors
-    bool middle_full = m_neighbors.size() >= 8;
-
-    if(corner_full || margin_full || middle_full)
-        setExpanded(true);
-
-    return true;
-}
+/*** PerceivedMap implementation: public methods ***/
 
-bool MapCell::unlinkNeighbor(int t_id)
+template<class Grid>
+BasicPerceivedMap<Grid>::BasicPerceivedMap()
 {
-    if(!validateCellId(t_id))
-        throw std::invalid_argument("MapCell::unlinkNeighbor - t_id=" + std::to_string(t_id) + " is not a valid identifier");
-
-    // check if t_id is a neighbor
-    if(std::find(m_neighbors.begin(), m_neighbors.end(), t_id) == m_neighbors.end())
-        return false;
-
-    // remove the neighbor
-    m_neighbors.erase(std::remove_if(m_neighbors.begin(), m_neighbors.end(),
-                [&t_id](const int& nei) {
-                    return t_id == nei;
-                }
-            ), m_neighbors.end()
-    );
-
-    return true;
+    // a path goes through each cell at most once, so it never grows past this
+    m_path.reserve(N_CELLS);
 }
 
-
-/*** PerceivedMap implementation: public methods ***/
-
-void PerceivedMap::reset()
+template<class Grid>
+void BasicPerceivedMap<Grid>::reset()
 {
-    m_list.clear();
+    m_known.clear();
+    m_expanded.clear();
+    for(CellBoard<Grid>& links : m_links)
+        links.clear();
+    for(uint8_t& mask : m_linkMask)
+        mask = 0;
+    for(uint32_t& order : m_linkOrder)
+        order = 0;
+    m_nCells = 0;
+    m_start = -1;
     m_path.clear();
     m_next = -1;
     m_complete = false;
+    s_cells.set(0);
 }
 
-bool PerceivedMap::addCell(int t_id)
+template<class Grid>
+bool BasicPerceivedMap<Grid>::addCell(int t_id)
 {
     // Validate coordinates
-    if(!validateCellId(t_id)) 
+    if(!validateCellId<Grid>(t_id)) 
         throw std::invalid_argument("PerceivedMap::addCell - t_id=" + std::to_string(t_id) +" is not a valid identifier");
 
     // Check if cell is already in map
-    for(MapCell& l_c : m_list)
-    {
-        if(l_c.getId() == t_id)
-        {
-            return false;
-        }
-    }
+    if(m_known.test(t_id))
+        return false;
 
     // Add cell to map
-    MapCell c {t_id};
-    m_list.push_back(c);
+    m_known.set(t_id);
+    if(m_nCells++ == 0)
+        m_start = t_id;
+    s_cells.set(m_nCells);
     
     return true;
 }
 
-void PerceivedMap::unlinkNeighbor(int t_id1, int t_id2)
+template<class Grid>
+void BasicPerceivedMap<Grid>::unlinkNeighbor(int t_id1, int t_id2)
 {
     // Validate coordinates
-    if(!validateCellId(t_id1)) 
+    if(!validateCellId<Grid>(t_id1)) 
         throw std::invalid_argument("PerceivedMap::removeCell - t_id1=" + std::to_string(t_id1) +" is not a valid identifier");
 
-    if(!validateCellId(t_id2)) 
+    if(!validateCellId<Grid>(t_id2)) 
         throw std::invalid_argument("PerceivedMap::removeCell - t_id2=" + std::to_string(t_id2) +" is not a valid identifier");
 
     // Check if cell is in map
     if(!cellInLocalMap(t_id1) || !cellInLocalMap(t_id2))
         return;
     
-    getCell(t_id1).unlinkNeighbor(t_id2);
+    int dir = neighborDirection<Grid>(t_id1, t_id2);
+    int c = CellBoard<Grid>::index(t_id1);
+    uint8_t& mask = m_linkMask[c];
+    if(dir >= 0 && (mask >> dir & 1))
+    {
+        // drop dir from the order, the later links move down one place
+        uint32_t& order = m_linkOrder[c];
+        int p = 0;
+        while((order >> 4*p & 0xf) != (uint32_t)dir) p++;
+        uint64_t low = order & ((uint64_t{1} << 4*p) - 1);
+        order = low | (uint64_t{order} >> 4*(p+1)) << 4*p;
+
+        mask &= ~(1 << dir);
+        m_links[dir].reset(t_id1);
+        s_unlinked.add();
+    }
 }
 
-bool PerceivedMap::linkNeighbor(int t_id1, int t_id2)
+template<class Grid>
+bool BasicPerceivedMap<Grid>::linkNeighbor(int t_id1, int t_id2)
 {
     // Validate identifiers
-    if(!validateCellId(t_id1))
+    if(!validateCellId<Grid>(t_id1))
         throw std::invalid_argument("PerceivedMap::linkNeighbors - " + std::to_string(t_id1) + " is not a valid identifier");
-    if(!validateCellId(t_id2))
+    if(!validateCellId<Grid>(t_id2))
         throw std::invalid_argument("PerceivedMap::linkNeighbors - " + std::to_string(t_id2) + " is not a valid identifier");
     
     if(!cellInLocalMap(t_id1))
@@ -206,32 +199,55 @@ bool PerceivedMap::linkNeighbor(int t_id1, int t_id2)
     if(!cellInLocalMap(t_id2))
         throw std::invalid_argument("PerceivedMap::linkNeighbors - " + std::to_string(t_id2) + " is not in map");
     
-    return getCell(t_id1).linkNeighbor(t_id2);
+    int dir = neighborDirection<Grid>(t_id1, t_id2);
+    if(dir < 0)
+        throw std::invalid_argument("PerceivedMap::linkNeighbors - " + std::to_string(t_id2) + " is not a neighbor of " + std::to_string(t_id1));
+
+    // (check if cell is already expanded) or t_id2 is already a neighbor
+    int c = CellBoard<Grid>::index(t_id1);
+    uint8_t& mask = m_linkMask[c];
+    if(m_expanded.test(t_id1) || (mask >> dir & 1))
+        return false;
+
+    m_linkOrder[c] |= (uint32_t)dir << 4*__builtin_popcount(mask);
+    mask |= 1 << dir;
+    m_links[dir].set(t_id1);
+
+    // a cell is expanded once linked to all the neighbors it has in the grid:
+    // 3 in the corners, 5 in the margins and 8 in the middle
+    uint8_t possible = 0;
+    for(int d = 0; d < N_DIRECTIONS; d++)
+        if(neighborCellId<Grid>(t_id1, d) >= 0)
+            possible |= 1 << d;
+
+    if(mask == possible)
+        m_expanded.set(t_id1);
+
+    return true;
 }
 
-bool PerceivedMap::isNeighbor(const int& t_id1, const int& t_id2)
+template<class Grid>
+bool BasicPerceivedMap<Grid>::isNeighbor(const int& t_id1, const int& t_id2)
 {
     // Validate identifiers
-    if(!validateCellId(t_id1))
+    if(!validateCellId<Grid>(t_id1))
         throw std::invalid_argument("PerceivedMap::areNeighbors - " + std::to_string(t_id1) + " is not a valid identifier");
-    if(!validateCellId(t_id2))
+    if(!validateCellId<Grid>(t_id2))
         throw std::invalid_argument("PerceivedMap::areNeighbors - " + std::to_string(t_id2) + " is not a valid identifier");
 
     // Check if cells are in map
     if(!cellInLocalMap(t_id1) || !cellInLocalMap(t_id2))
         return false;
 
-    for(int nei : getCell(t_id1).getNeighbors())
-        if(nei == t_id2)
-            return true;
-    
-    return false;
+    int dir = neighborDirection<Grid>(t_id1, t_id2);
+    return dir >= 0 && m_links[dir].test(t_id1);
 }
 
-void PerceivedMap::setCellExpanded(const int& t_id, bool t_expanded)
+template<class Grid>
+void BasicPerceivedMap<Grid>::setCellExpanded(const int& t_id, bool t_expanded)
 {
     // Validate identifier
-    if(!validateCellId(t_id))
+    if(!validateCellId<Grid>(t_id))
         throw std::invalid_argument("PerceivedMap::setCellExpanded - " + std::to_string(t_id) + " is not a valid identifier");
 
     // Check if cell is in map
@@ -239,26 +255,33 @@ void PerceivedMap::setCellExpanded(const int& t_id, bool t_expanded)
         throw std::invalid_argument("PerceivedMap::setCellExpanded - " + std::to_string(t_id) + " is not in map");
     
     // set cell expansion
-    getCell(t_id).setExpanded(t_expanded);
+    if(t_expanded)
+        m_expanded.set(t_id);
+    else
+        m_expanded.reset(t_id);
 }
 
-bool PerceivedMap::cellIsExpanded(const int& t_id)
+template<class Grid>
+bool BasicPerceivedMap<Grid>::cellIsExpanded(const int& t_id)
 {
     // Validate identifier
-    if(!validateCellId(t_id))
+    if(!validateCellId<Grid>(t_id))
         throw std::invalid_argument("PerceivedMap::cellIsExpanded - " + std::to_string(t_id) + " is not a valid identifier");
 
     // Check if cell is in map
     if(!cellInLocalMap(t_id))
         throw std::invalid_argument("PerceivedMap::cellIsExpanded - " + std::to_string(t_id) + " is not in map");
 
-    return getCell(t_id).isExpanded();
+    return m_expanded.test(t_id);
 }
 
-int PerceivedMap::getNextCell(const int& id)
+template<class Grid>
+int BasicPerceivedMap<Grid>::getNextCell(const int& id)
 {
+    ROBSOCK_TRACE_SCOPE("getNextCell");
+
     // Validate identifier
-    if(!validateCellId(id))
+    if(!validateCellId<Grid>(id))
         throw std::invalid_argument("PerceivedMap::getNextCell - " + std::to_string(id) + " is not a valid identifier");
 
     // Check if cell is in map
@@ -272,23 +295,21 @@ int PerceivedMap::getNextCell(const int& id)
         if(!computePathWithoutGoal(id))
         {
             // double check if path is empty
-            for(MapCell& c : m_list)
-            {
-                if(!c.isExpanded() && c.getNeighbors().size() > 0) {
+            (m_known - m_expanded).forEach([this](int t_open) {
+                if(m_linkMask[CellBoard<Grid>::index(t_open)] != 0) {
                     // print neighbors
-                    std::cout << "Neighbors of " << computeCellCoordinates(c.getId()).toString() << ": ";
-                    for(const int& n : c.getNeighbors())
-                        std::cout << computeCellCoordinates(n).toString() << " ";
-                    std::cout << std::endl;
+                    ROBSOCK_LOG("Neighbors of %s:", computeCellCoord<Grid>(t_open).toString());
+                    for(const int& n : getNeighbors(t_open))
+                        ROBSOCK_LOG("    %s", computeCellCoord<Grid>(n).toString());
 
-                    throw std::logic_error("Something went wrong! Map marked as fully expanded but cell " + computeCellCoordinates(c.getId()).toString() + " is not expanded");
+                    throw std::logic_error("Something went wrong! Map marked as fully expanded but cell " + computeCellCoord<Grid>(t_open).toString() + " is not expanded");
                 }
-            }
+            });
 
-            m_complete = m_list.size() > 1;
+            m_complete = m_nCells > 1;
 
             // return to starting point
-            if(!computePath(id, m_list[0].getId()))
+            if(!computePath(id, m_start))
                 throw std::logic_error("Something went wrong! Map fully expanded but no path was computed");
             
             return m_path.back();
@@ -305,19 +326,20 @@ int PerceivedMap::getNextCell(const int& id)
     return m_next;
 }
 
-bool PerceivedMap::isComplete()
+template<class Grid>
+bool BasicPerceivedMap<Grid>::isComplete()
 {
     if(!m_complete) {
-        for(const MapCell& c : m_list)
-            if(!c.isExpanded()) return false;
+        if((m_known - m_expanded).any()) return false;
     
-        m_complete |= m_list.size() > 0;
+        m_complete |= m_nCells > 0;
     }
 
     return m_complete;
 }
 
-void PerceivedMap::writeToFile(const std::string& t_fname, const std::vector<int>& t_checkpoints)
+template<class Grid>
+void BasicPerceivedMap<Grid>::writeToFile(const std::string& t_fname, const std::vector<int>& t_checkpoints)
 {
     // TODO: check if map is complete, check if checkpoints are valid, check if fname is valid.
 
@@ -326,225 +348,233 @@ void PerceivedMap::writeToFile(const std::string& t_fname, const std::vector<int
 }
 
 // TODO: remove this function
-std::string PerceivedMap::toString() const
+template<class Grid>
+std::string BasicPerceivedMap<Grid>::toString() const
 {
     std::string text{};
-    for(const MapCell& c : m_list)
-    {
-        text += "(" + std::to_string(
-                (int)(computeCellCoordinates(c.getId()).x)
-            ) + "," + std::to_string(
-                (int)(computeCellCoordinates(c.getId()).y)
-        ) + ") : ";
-        for(const int& n : c.getNeighbors())
-        {
-            text += "(" + std::to_string(
-                    (int)(computeCellCoordinates(n).x)
-                ) + "," + std::to_string(
-                    (int)(computeCellCoordinates(n).y)
-                ) + ") ";
-        }
+    m_known.forEach([this, &text](int t_id) {
+        text += "(" + std::to_string(cellX<Grid>(t_id)) + "," + std::to_string(cellY<Grid>(t_id)) + ") : ";
+        for(const int& n : getNeighbors(t_id))
+            text += "(" + std::to_string(cellX<Grid>(n)) + "," + std::to_string(cellY<Grid>(n)) + ") ";
         text += "\n";
-    }
+    });
     return text;
 }
 
 
+template<class Grid>
+std::vector<int> BasicPerceivedMap<Grid>::getNeighbors(const int& t_id) const
+{
+    checkInMap(t_id, "getNeighbors");
+
+    std::vector<int> neighbors;
+    neighbors.reserve(N_DIRECTIONS);
+    forEachLinked(t_id, [&neighbors](int t_nei) { neighbors.push_back(t_nei); });
+    return neighbors;
+}
+
+
 /*** PerceivedMap implementation: private methods ***/
 
-MapCell& PerceivedMap::getCell(const int& t_id)
+template<class Grid>
+bool BasicPerceivedMap<Grid>::cellInLocalMap(const int& t_id) const
 {
-    // it is assumed that cell is in local map
-    return *find_if(m_list.begin(), m_list.end(),
-                [&t_id](const MapCell c) {
-                    return t_id == c.getId();
-                }
-            );
+    return m_known.test(t_id);
 }
 
-bool PerceivedMap::cellInLocalMap(const int& t_id) const
+template<class Grid>
+void BasicPerceivedMap<Grid>::checkInMap(const int& t_id, const char* t_caller) const
 {
-    return find_if(m_list.begin(), m_list.end(),
-                [&t_id](const MapCell c) {
-                    return t_id == c.getId();
-                }
-            ) != m_list.end();
+    // Validate identifier
+    if(!validateCellId<Grid>(t_id))
+        throw std::invalid_argument(std::string("PerceivedMap::") + t_caller + " - " + std::to_string(t_id) + " is not a valid identifier");
+
+    // Check if cell is in map
+    if(!cellInLocalMap(t_id))
+        throw std::invalid_argument(std::string("PerceivedMap::") + t_caller + " - " + std::to_string(t_id) + " is not in map");
 }
 
-double PerceivedMap::distanceBetweenCells(const int& t_id1, const int& t_id2)
+template<class Grid>
+double BasicPerceivedMap<Grid>::distanceBetweenCells(const int& t_id1, const int& t_id2)
 {
-    std::set<int> openSet{t_id1};
+    if(!search(t_id1, t_id2))
+        return std::numeric_limits<int>::max();
 
-    std::map<int,int> cameFrom;
-    
-    std::map<int,double> gScore;
-    gScore[t_id1] = 0;
+    int dist = 0;
+    for(int current = t_id2, prev; (prev = m_cameFrom[CellBoard<Grid>::index(current)]) >= 0; current = prev)
+        dist += cellDistance(computeCellCoord<Grid>(current), computeCellCoord<Grid>(prev));
+    return dist;
+}
 
-    std::map<int,double> fScore;
-    fScore[t_id1] = computeHeuristic(t_id1, t_id2);
+template<class Grid>
+bool BasicPerceivedMap<Grid>::computePathWithoutGoal(const int& t_start)
+{
+    CellBoard<Grid> open = m_known - m_expanded;
 
-    while(!openSet.empty())
+    // distance layers: cells reached in 0, 1, 2, ... steps
+    ArenaVector<CellBoard<Grid>> layers(1, CellBoard<Grid>(), m_scratch);
+    layers[0].set(t_start);
+    CellBoard<Grid> visited = layers[0];
+
+    while(!(layers.back() & open).any())
     {
-        int current = *openSet.begin();
-        int key = 0;
+        // one step of the wavefront, along the links in each direction
+        CellBoard<Grid> next;
+        for(int d = 0; d < N_DIRECTIONS; d++)
+            next |= (layers.back() & m_links[d]).shifted(d);
+        next -= visited;
+        s_bfsLayers.add();
+
+        if(!next.any())
+            return false;
 
-        for(const int& id : openSet)
-            if(fScore[id] < fScore[current])
-                current = id;
+        visited |= next;
+        layers.push_back(next);
+    }
 
-        if(current == t_id2)
-        {
-            int dist = 0;
-            while(cameFrom.find(current) != cameFrom.end())
-            {
-                Position p1 = computeCellCoordinates(current);
-                Position p2 = computeCellCoordinates(cameFrom[current]);
-                dist+=distance(p1.x, p1.y, p2.x, p2.y);
-                current = cameFrom[current];
-            }
-            return dist;
-        }
+    // keep only the cells of each layer on a shortest path to an open cell:
+    // a cell linked in direction d to a kept cell of the next layer
+    layers.back() &= open;
+    for(int k = (int)layers.size() - 2; k >= 0; k--)
+    {
+        CellBoard<Grid> before;
+        for(int d = 0; d < N_DIRECTIONS; d++)
+            before |= layers[k+1].shifted((d + N_DIRECTIONS/2) % N_DIRECTIONS) & m_links[d];
+        layers[k] &= before;
+    }
 
-        openSet.erase(current);
-        for(const int& t_neighbor : getCell(current).getNeighbors())
+    // order the kept cells as a queue would pop them, each layer in the order
+    // of the cells that reach it first, in the order of their links; every
+    // cell reaching a kept cell is kept, so the order is the queue's
+    ArenaVector<int> order(1, t_start, m_scratch);
+    ArenaVector<int> from(1, -1, m_scratch);    // index in order of the cell reached from
+    size_t begin = 0;
+    for(size_t k = 1; k < layers.size(); k++)
+    {
+        size_t end = order.size();
+        for(size_t i = begin; i < end; i++)
         {
-            double tentative_gScore = gScore.at(current) + computeEdgeWeight(current, t_neighbor);
-
-            try { gScore.at(t_neighbor); }
-            catch(std::out_of_range& e) { gScore[t_neighbor] = std::numeric_limits<int>::max(); }
-
-            if(tentative_gScore < gScore.at(t_neighbor))
-            {
-                cameFrom[t_neighbor] = current;
-                gScore[t_neighbor] = tentative_gScore;
-                fScore[t_neighbor] = gScore.at(t_neighbor) + computeHeuristic(t_neighbor, t_id2);
-                openSet.insert(t_neighbor);
-            }
+            forEachLinked(order[i], [&](int t_nei) {
+                if(!layers[k].test(t_nei)) return;
+                layers[k].reset(t_nei);
+                order.push_back(t_nei);
+                from.push_back(i);
+            });
         }
+        begin = end;
     }
 
-    return std::numeric_limits<int>::max();
+    // the first open cell popped, and the path back through the cells reaching it first
+    m_path.clear();
+    for(int i = begin; i >= 0; i = from[i])
+        m_path.push_back(order[i]);
+
+    return true;
 }
 
-bool PerceivedMap::computePathWithoutGoal(const int& t_start)
+template<class Grid>
+bool BasicPerceivedMap<Grid>::search(const int& t_start, const int& t_goal)
 {
-    std::map<int,bool> visited;
-    visited[t_start] = true;
-
-    std::queue<int> queue;
-    queue.push(t_start);
-    
-    std::map<int,int> cameFrom;
+    typedef CellBoard<Grid> Board;
 
-    while(!queue.empty())
+    // a new search: the scratch of the cells not visited since is stale
+    if(++m_search == 0)
     {
-        int v = queue.front();
-        queue.pop();
-
-        if (!cellIsExpanded(v))
-        {
-            reconstructPath(cameFrom, v);
-            return true;
-        }
-
-        for(const int& nei : getCell(v).getNeighbors())
-        {
-            if(!visited[nei])
-            {
-                visited[nei] = true;
-                cameFrom[nei] = v;
-                queue.push(nei);
-            }
-        }
+        for(uint32_t& visit : m_visit)
+            visit = 0;
+        m_search = 1;
     }
 
-    return false;
-}
-
-bool PerceivedMap::computePath(const int& t_start, const int& t_goal)
-{
-    std::set<int> openSet{t_start};
+    Board openSet;
+    openSet.set(t_start);
 
-    std::map<int,int> cameFrom;
-    
-    std::map<int,double> gScore;
-    gScore[t_start] = 0;
-
-    std::map<int,double> fScore;
-    fScore[t_start] = computeHeuristic(t_start, t_goal);
+    int s = Board::index(t_start);
+    m_visit[s] = m_search;
+    m_cameFrom[s] = -1;
+    m_gScore[s] = 0;
+    m_fScore[s] = computeHeuristic(t_start, t_goal);
 
-    while(!openSet.empty())
+    while(openSet.any())
     {
-        int current = *openSet.begin();
-        int key = 0;
-        for(const int& id : openSet)
-        {
-            if(fScore[id] < fScore[current])
+        // the open cell with the lowest score, the lowest identifier on ties
+        int current = -1;
+        double best = 0;
+        openSet.forEach([this, &current, &best](int t_id) {
+            double f = m_fScore[Board::index(t_id)];
+            if(current < 0 || f < best)
             {
-                current = id;
+                current = t_id;
+                best = f;
             }
-        }
+        });
 
         if(current == t_goal)
-        {    
-            reconstructPath(cameFrom, current);
             return true;
-        }
 
-        openSet.erase(current);
-        for(const int& t_neighbor : getCell(current).getNeighbors())
-        {
-            double tentative_gScore = gScore.at(current) + computeEdgeWeight(current, t_neighbor);
+        openSet.reset(current);
+        s_astarExpanded.add();
 
-            try { gScore.at(t_neighbor); }
-            catch(std::out_of_range& e) { gScore[t_neighbor] = std::numeric_limits<double>::max(); }
+        int c = Board::index(current);
+        forEachLinked(current, [&](int neighbor) {
+            int n = Board::index(neighbor);
+            double tentative_gScore = m_gScore[c] + computeEdgeWeight(current, neighbor);
 
-            if(tentative_gScore < gScore.at(t_neighbor))
+            if(m_visit[n] != m_search || tentative_gScore < m_gScore[n])
             {
-                cameFrom[t_neighbor] = current;
-                gScore[t_neighbor] = tentative_gScore;
-                fScore[t_neighbor] = gScore.at(t_neighbor) + computeHeuristic(t_neighbor, t_goal);
-                openSet.insert(t_neighbor);
+                m_visit[n] = m_search;
+                m_cameFrom[n] = current;
+                m_gScore[n] = tentative_gScore;
+                m_fScore[n] = tentative_gScore + computeHeuristic(neighbor, t_goal);
+                openSet.set(neighbor);
             }
-        }
+        });
     }
 
     return false;
 }
 
-double PerceivedMap::computeHeuristic(const int& t_start, const int& t_goal) const
+template<class Grid>
+bool BasicPerceivedMap<Grid>::computePath(const int& t_start, const int& t_goal)
+{
+    ROBSOCK_TRACE_SCOPE("computePath");
+
+    if(!search(t_start, t_goal))
+        return false;
+
+    reconstructPath(t_goal);
+    return true;
+}
+
+template<class Grid>
+double BasicPerceivedMap<Grid>::computeHeuristic(const int& t_start, const int& t_goal) const
 {
-    Position p1 = computeCellCoordinates(t_start);
-    Position p2 = computeCellCoordinates(t_goal);
-    return distance(p1.x, p1.y, p2.x, p2.y);
+    return cellDistance(computeCellCoord<Grid>(t_start), computeCellCoord<Grid>(t_goal));
 }
 
-double PerceivedMap::computeEdgeWeight(const int& t_start, const int& t_goal) const
+template<class Grid>
+double BasicPerceivedMap<Grid>::computeEdgeWeight(const int& t_start, const int& t_goal) const
 {
-    Position p1 = computeCellCoordinates(t_start);
-    Position p2 = computeCellCoordinates(t_goal);
-    return distance(p1.x, p1.y, p2.x, p2.y);
+    return cellDistance(computeCellCoord<Grid>(t_start), computeCellCoord<Grid>(t_goal));
 }
 
-void PerceivedMap::reconstructPath(std::map<int,int>& t_cameFrom, const int& t_current)
+template<class Grid>
+void BasicPerceivedMap<Grid>::reconstructPath(const int& t_current)
 {
     m_path.clear();
     m_path.push_back(t_current);
 
-    int current = t_current;
-    while(t_cameFrom.find(current) != t_cameFrom.end())
-    {
-        current = t_cameFrom[current];
+    for(int current = m_cameFrom[CellBoard<Grid>::index(t_current)]; current >= 0;
+        current = m_cameFrom[CellBoard<Grid>::index(current)])
         m_path.push_back(current);
-    }
 }
 
-void PerceivedMap::writeMapToFile(const std::string& t_fname, const std::vector<int>& t_checkpoints) const
+template<class Grid>
+void BasicPerceivedMap<Grid>::writeMapToFile(const std::string& t_fname, const std::vector<int>& t_checkpoints) const
 {
-    char map[21][49];
-    for(int i = 0; i < 21; i++)
+    char map[Grid::ROWS][Grid::COLS];
+    for(int i = 0; i < Grid::ROWS; i++)
     {
-        for(int j = 0; j < 49; j++)
+        for(int j = 0; j < Grid::COLS; j++)
         {
             map[i][j] = ' ';
         }
@@ -553,46 +583,25 @@ void PerceivedMap::writeMapToFile(const std::string& t_fname, const std::vector<
     // starting point must be first in t_checkpoints
     for(int i = 0; i < t_checkpoints.size(); i++)
     {
-        Position c = computeCellCoordinates(t_checkpoints[i]);
-        map[10 - (int)c.y][24 + (int)c.x] = '0' + i;
+        int id = t_checkpoints[i];
+        map[Grid::HALF_HEIGHT - cellY<Grid>(id)][Grid::HALF_WIDTH + cellX<Grid>(id)] = '0' + i;
     }
 
-    // draw the map representation
-    for(const MapCell& cell : m_list)
-    {
-        Position c = computeCellCoordinates(cell.getId());
-        int row = 10 - (int)c.y; // 10 - y
-        int column = 24 + (int)c.x; // 24 + x
-
-        for(const int& nid : cell.getNeighbors())
+    // draw the map representation, each link half way to the neighbor
+    m_known.forEach([this, &map](int t_id) {
+        for(uint8_t mask = m_linkMask[CellBoard<Grid>::index(t_id)]; mask; mask &= mask - 1)
         {
-            Position n = computeCellCoordinates(nid);
-
-            if(c.x < n.x)
-            {
-                if(c.y < n.y) map[row - 1][column + 1] = '/';
-                else if(c.y > n.y) map[row + 1][column + 1] = '\\';
-                else map[row][column + 1] = '-';
-            }
-            else if (c.x > n.x)
-            {
-                if(c.y < n.y) map[row - 1][column - 1] = '\\';
-                else if(c.y > n.y) map[row + 1][column - 1] = '/';
-                else map[row][column - 1] = '-';
-            }
-            else
-            {
-                if(c.y < n.y) map[row - 1][column] = '|';
-                else if(c.y > n.y) map[row + 1][column] = '|';
-            }
+            int dir = __builtin_ctz(mask);
+            int link = t_id + GridTables<Grid>::DELTA[dir]/2;
+            map[Grid::HALF_HEIGHT - cellY<Grid>(link)][Grid::HALF_WIDTH + cellX<Grid>(link)] = s_linkChar[dir];
         }
-    }
+    });
 
     // convert to string
     std::string text{};
-    for(int i = 0; i < 21; i++)
+    for(int i = 0; i < Grid::ROWS; i++)
     {
-        for(int j = 0; j < 49; j++)
+        for(int j = 0; j < Grid::COLS; j++)
             text += map[i][j];
 
         text += '\n';
@@ -606,8 +615,11 @@ void PerceivedMap::writeMapToFile(const std::string& t_fname, const std::vector<
 }
 
 // TODO: rewrite function to a more readable version
-void PerceivedMap::writePathToFile(const std::string& t_fname, const std::vector<int>& t_checkpoints)
+template<class Grid>
+void BasicPerceivedMap<Grid>::writePathToFile(const std::string& t_fname, const std::vector<int>& t_checkpoints)
 {
+    ROBSOCK_TRACE_SCOPE("writePathToFile");
+
     if(t_checkpoints.empty()) return;
 
     // store distances between checkpoints
@@ -652,8 +664,8 @@ void PerceivedMap::writePathToFile(const std::string& t_fname, const std::vector
         it++; // skip first element (current cell)
         for(; it != m_path.rend(); ++it)
         {
-            Position c = computeCellCoordinates(*it);
-            text += std::to_string((int)c.x) + " " + std::to_string((int)c.y) + '\n';
+            CellCoord c = computeCellCoord<Grid>(*it);
+            text += std::to_string(c.x) + " " + std::to_string(c.y) + '\n';
         }
     };
 
@@ -662,8 +674,8 @@ void PerceivedMap::writePathToFile(const std::string& t_fname, const std::vector
     std::string text;
     
     // write first cell
-    Position fc = computeCellCoordinates(first);
-    text += std::to_string((int)fc.x) + " " + std::to_string((int)fc.y) + '\n';
+    CellCoord fc = computeCellCoord<Grid>(first);
+    text += std::to_string(fc.x) + " " + std::to_string(fc.y) + '\n';
     
     // write the rest of the path
     for(int i = 1; i < best_path.size(); i++)
@@ -682,4 +694,10 @@ void PerceivedMap::writePathToFile(const std::string& t_fname, const std::vector
     file.close();
 }
 
+// the grids the library is built for (see utils.h)
+template class BasicMapWall<DefaultGrid>;
+template class BasicPerceivedMap<DefaultGrid>;
+template class BasicMapWall<LargeGrid>;
+template class BasicPerceivedMap<LargeGrid>;
+
 } // namespace agent
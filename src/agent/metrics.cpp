@@ -0,0 +1,153 @@
+/* metrics.cpp
+ */
+
+#include "agent/metrics.h"
+#include "robSock/clogger.h"
+
+#include <chrono>
+#include <sstream>
+
+#include <time.h>
+
+namespace agent
+{
+
+static long long nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*** ScopedTimer implementation ***/
+
+ScopedTimer::ScopedTimer(Timer& t_timer)
+    : m_timer(t_timer), m_start(nowNs())
+{
+}
+
+ScopedTimer::~ScopedTimer()
+{
+    m_timer.record(nowNs() - m_start);
+}
+
+
+/*** Metrics implementation ***/
+
+Metrics& Metrics::global()
+{
+    // never destroyed, so metrics can be updated while the process exits
+    static Metrics* metrics = new Metrics;
+    return *metrics;
+}
+
+Counter& Metrics::counter(const std::string& t_name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_ptr<Counter>& c = m_counters[t_name];
+    if(!c) c.reset(new Counter);
+    return *c;
+}
+
+Gauge& Metrics::gauge(const std::string& t_name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_ptr<Gauge>& g = m_gauges[t_name];
+    if(!g) g.reset(new Gauge);
+    return *g;
+}
+
+Timer& Metrics::timer(const std::string& t_name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_ptr<Timer>& t = m_timers[t_name];
+    if(!t) t.reset(new Timer);
+    return *t;
+}
+
+std::string Metrics::snapshot() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string text;
+    char line[256];
+
+    for(const auto& c : m_counters)
+    {
+        snprintf(line, sizeof(line), "counter %s %llu\n",
+                 c.first.c_str(), (unsigned long long)c.second->value());
+        text += line;
+    }
+
+    for(const auto& g : m_gauges)
+    {
+        snprintf(line, sizeof(line), "gauge %s %g\n", g.first.c_str(), g.second->value());
+        text += line;
+    }
+
+    // durations in microseconds
+    for(const auto& t : m_timers)
+    {
+        const Timer& tm = *t.second;
+        snprintf(line, sizeof(line), "timer %s count=%llu total=%.1f p50=%.1f p90=%.1f p99=%.1f max=%.1f\n",
+                 t.first.c_str(), (unsigned long long)tm.count(), tm.total() / 1e3,
+                 tm.percentile(0.5) / 1e3, tm.percentile(0.9) / 1e3,
+                 tm.percentile(0.99) / 1e3, tm.max() / 1e3);
+        text += line;
+    }
+
+    return text;
+}
+
+void Metrics::dump() const
+{
+    std::istringstream lines(snapshot());
+    std::string line;
+    while(std::getline(lines, line))
+        ROBSOCK_LOG("metrics: %s", line);
+}
+
+bool Metrics::startPeriodicDump(const std::string& t_fname, int t_intervalMs)
+{
+    stopPeriodicDump();
+
+    std::lock_guard<std::mutex> lock(m_dumpMutex);
+    m_dumpFile = fopen(t_fname.c_str(), "w");
+    if(m_dumpFile == nullptr) return false;
+
+    m_dumpStart = nowNs();
+    m_dumpStop = false;
+    if(t_intervalMs <= 0) return true;
+
+    m_dumpThread = std::thread([this, t_intervalMs]() {
+        std::unique_lock<std::mutex> lock(m_dumpMutex);
+        while(!m_dumpWake.wait_for(lock, std::chrono::milliseconds(t_intervalMs),
+                                   [this]() { return m_dumpStop; }))
+            writeSnapshot();
+    });
+    return true;
+}
+
+void Metrics::stopPeriodicDump()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_dumpMutex);
+        m_dumpStop = true;
+    }
+    m_dumpWake.notify_all();
+    if(m_dumpThread.joinable()) m_dumpThread.join();
+
+    std::lock_guard<std::mutex> lock(m_dumpMutex);
+    if(m_dumpFile == nullptr) return;
+    writeSnapshot();
+    fclose(m_dumpFile);
+    m_dumpFile = nullptr;
+}
+
+void Metrics::writeSnapshot()
+{
+    // m_dumpMutex is held
+    fprintf(m_dumpFile, "# metrics %lld\n%s\n", (nowNs() - m_dumpStart) / 1000000, snapshot().c_str());
+    fflush(m_dumpFile);
+}
+
+} // namespace agent
@@ -33,30 +33,6 @@ double getLinePos()
     return posOverLine;
 }
 
-bool validateCellCoordinates(const int& t_x, const int& t_y)
-{
-    return t_x >= -24 && t_x <= 24 && (t_x % 2) == 0 
-            && t_y >= -10 && t_y <= 10 && (t_y % 2) == 0;
-}
-
-bool validateCellId(const int& t_id)
-{
-    return t_id >= 0 && t_id < (21*49) &&           // between limits
-           (t_id % 2) == 0 && (t_id / 49) % 2 == 0; // even column and even row
-}
-
-int computeCellId(const int& t_x, const int& t_y)
-{
-    return (t_x+24)+(t_y+10)*49;
-}
-
-Position computeCellCoordinates(const int& t_id)
-{
-    double x = (double)((t_id % 49)-24);
-    double y = (double)((t_id / 49)-10);
-    return Position{x,y};
-}
-
 int getNearestCell(double t_x, double t_y)
 {
     // TODO: re-write function
@@ -116,72 +92,6 @@ double addRad(double t_a1, double t_a2)
     return a;
 }
 
-/** helper functions for checkIntersection **/
-
-// To find orientation of ordered triplet (p, q, r). 
-// The function returns following values 
-// 0 --> p, q and r are collinear 
-// 1 --> Clockwise 
-// 2 --> Counterclockwise
-// adapted from GeeksForGeeks
-static int orientation(Position p, Position q, Position r) 
-{ 
-    int val = (q.y - p.y) * (r.x - q.x) - 
-              (q.x - p.x) * (r.y - q.y); 
-  
-    if (val == 0) return 0;  // collinear 
-  
-    return (val > 0)? 1: 2; // clock or counterclock wise 
-} 
-
-// Given three collinear points p, q, r, the function checks if 
-// point q lies on line segment 'pr'
-// adapted from GeeksForGeeks
-static bool onSegment(Position p, Position q, Position r) 
-{ 
-    if (q.x <= std::max(p.x, r.x) && q.x >= std::min(p.x, r.x) && 
-        q.y <= std::max(p.y, r.y) && q.y >= std::min(p.y, r.y)) 
-       return true; 
-  
-    return false; 
-}
-
-/** end of helper functions for checkIntersection **/
-
-bool checkIntersection(std::pair<Position,Position> l1, std::pair<Position,Position> l2)
-{
-    Position p1 = l1.first;
-    Position q1 = l1.second;
-    Position p2 = l2.first;
-    Position q2 = l2.second;
-
-    // Find the four orientations needed for general and 
-    // special cases
-    int o1 = orientation(p1, q1, p2); 
-    int o2 = orientation(p1, q1, q2); 
-    int o3 = orientation(p2, q2, p1); 
-    int o4 = orientation(p2, q2, q1); 
-  
-    // General case 
-    if (o1 != o2 && o3 != o4) 
-        return true; 
-  
-    // Special Cases 
-    // p1, q1 and p2 are collinear and p2 lies on segment p1q1 
-    if (o1 == 0 && onSegment(p1, p2, q1)) return true; 
-  
-    // p1, q1 and q2 are collinear and q2 lies on segment p1q1 
-    if (o2 == 0 && onSegment(p1, q2, q1)) return true; 
-  
-    // p2, q2 and p1 are collinear and p1 lies on segment p2q2 
-    if (o3 == 0 && onSegment(p2, p1, q2)) return true; 
-  
-     // p2, q2 and q1 are collinear and q1 lies on segment p2q2 
-    if (o4 == 0 && onSegment(p2, q1, q2)) return true; 
-  
-    return false; // Doesn't fall in any of the above cases 
-}
-
 std::vector<int> getPossibleNeighbors(const int& t_id)
 {
     std::vector<int> neighbors{};
@@ -189,14 +99,10 @@ std::vector<int> getPossibleNeighbors(const int& t_id)
     // check if the cell is valid
     if(!validateCellId(t_id)) return neighbors;
 
-    // get cell coordinates
-    Position pos = computeCellCoordinates(t_id);
-
-    // get possible neighbors
-    for(int i = 0; i < 8; i++) {
-        int x = pos.x + 2*round(cos(M_PI/4*i));
-        int y = pos.y +  2*round(sin(M_PI/4*i));
-        neighbors.push_back(computeCellId(x, y));
+    // get possible neighbors, none past the borders
+    for(int i = 0; i < N_DIRECTIONS; i++) {
+        int nid = neighborCellId(t_id, i);
+        if(nid >= 0) neighbors.push_back(nid);
     }
 
     return neighbors;
@@ -1,11 +1,21 @@
 #include "agentC4.h"
+#include "agent/metrics.h"
 #include "agent/utils.h"
 #include "robSock/RobSock.h"
+#include "robSock/clogger.h"
+#include "robSock/ctrace.h"
 
 #include <iostream>
 
 #include <unistd.h>
 
+// work done by the agent and robSock each cycle (see agent/metrics.h)
+static agent::Counter& s_findNeighborsMisses = agent::Metrics::global().counter("agent.findNeighbors.misses");
+static agent::Counter& s_candidatesTried = agent::Metrics::global().counter("agent.findAndCorrect.candidates");
+static agent::Timer& s_findAndCorrect = agent::Metrics::global().timer("agent.findAndCorrect");
+static agent::Timer& s_parse = agent::Metrics::global().timer("robsock.parse");
+static agent::Gauge& s_missedCycles = agent::Metrics::global().gauge("robsock.missedCycles");
+
 int AgentC4::run()
 {
     int state=STOP,
@@ -18,9 +28,14 @@ int AgentC4::run()
     nid = m_perceivedMap.getNextCell(cid); // get next cell
 
     while(!GetFinished()) {
+        m_scratch.reset();
         ReadSensors();
+        if(GetParseTime() > 0) s_parse.record(GetParseTime() * 1e3);
+        s_missedCycles.set(GetMissedCycles());
+
         m_compassFilter.update(GetCompassSensor(), m_dir_var);
         m_movModel.correct(m_compassFilter.degrees() * (M_PI/180.0));
+        EndLatencyPhase(m_phaseLocalization);
 
         // check if simulation has finished
         if(GetTime() >= GetFinalTime() || state == FINISHED) {
@@ -49,6 +64,7 @@ int AgentC4::run()
             case INIT:
             {
                 findAndCorrect();
+                EndLatencyPhase(m_phaseMapping);
 
                 float dir = m_movModel.getDir();
                 if(dir > -(M_PI/4) && dir < 0) {
@@ -64,6 +80,7 @@ int AgentC4::run()
             case RUN:
             {
                 findAndCorrect();
+                EndLatencyPhase(m_phaseMapping);
 
                 std::pair<double,double> powers = move(cid,nid);
                 lPow = powers.first;
@@ -90,12 +107,17 @@ int AgentC4::run()
             }
         }
 
+        EndLatencyPhase(m_phaseControl);
+
         if(state != STOP)
         {
             driveMotorsExt(lPow,rPow);
         }
     }
 
+    // the run has finished, leave its fingerprint
+    agent::Metrics::global().dump();
+
     return m_perceivedMap.isComplete() ? 0 : 1;
 }
 
@@ -105,7 +127,7 @@ int AgentC4::write()
         m_perceivedMap.writeToFile(m_outfile, m_checkpoints);
     }
     catch(const std::exception& e) {
-        std::cerr << e.what() << std::endl;
+        ROBSOCK_LOG("%s", e.what());
         return 1;
     }
 
@@ -117,6 +139,7 @@ int AgentC4::reset()
     m_movModel.reset();
     m_perceivedMap.reset();
     m_controller.reset();
+    m_scratch.reset();
     m_checkpoints.clear();
     return 0;
 }
@@ -126,7 +149,9 @@ int AgentC4::init()
     ReadSensors(); // initialize sensors
 
     int cid = agent::computeCellId(0, 0); // compute cell id of the starting cell
+    m_perceivedMap.setScratch(&m_scratch); // planner temporaries come from the cycle's arena
     m_perceivedMap.addCell(cid); // add starting cell to the perceived map
+    m_checkpoints.reserve(10); // the labs mark their targets with a digit
     m_checkpoints.push_back(cid); // add starting cell to the checkpoints | TODO: check if this assumption is correct
 
     // initialize controller
@@ -143,6 +168,12 @@ int AgentC4::init()
     m_dir_var = noise*noise;
     m_compassFilter.init(0.0, 0.0);
 
+    // phases of the cycle, timed if latency statistics are enabled
+    m_phaseLocalization = AddLatencyPhase("localization");
+    m_phaseMapping = AddLatencyPhase("mapping");
+    m_phasePlanning = AddLatencyPhase("planning");
+    m_phaseControl = AddLatencyPhase("control");
+
     // initialize movement model
     driveMotorsExt(0.0, 0.0);
 
@@ -166,14 +197,14 @@ std::pair<double,double> AgentC4::move(int& t_cid, int& t_nid)
         // search for edge case where a neighbor was found
         // but the neighbor cell did not detect that linkage
         // when it was expanded.
-        for(int nei : m_perceivedMap.getNeighbors(t_cid)) {
+        m_perceivedMap.forEachNeighbor(t_cid, [&](int nei) {
+            if(t_nid != t_cid) return; // the first one found
             if(m_perceivedMap.cellIsExpanded(nei) && !m_perceivedMap.isNeighbor(nei, t_cid)) {
                 t_nid = nei;
                 wasExpanded = true;
                 m_perceivedMap.setCellExpanded(t_nid, false);
-                break;
             }
-        }
+        });
     
         if(t_nid == t_cid) { // if no edge case was found, then get the next cell
             t_nid = m_perceivedMap.getNextCell(t_cid);
@@ -181,6 +212,7 @@ std::pair<double,double> AgentC4::move(int& t_cid, int& t_nid)
 
         np = agent::computeCellCoordinates(t_nid);
     }
+    EndLatencyPhase(m_phasePlanning);
 
     // get direction to next cell
     double theta = atan2(np.y-m_movModel.getY(), np.x-m_movModel.getX());
@@ -236,57 +268,54 @@ std::pair<double,double> AgentC4::move(int& t_cid, int& t_nid)
 
 void AgentC4::findAndCorrect()
 {
+    ROBSOCK_TRACE_SCOPE("findAndCorrect");
+    agent::ScopedTimer timer(s_findAndCorrect);
+
     double og_x = m_movModel.getX();
     double og_y = m_movModel.getY();
 
     double error = 1.5/100.0;
 
-    std::vector<agent::Position> possible_pos;
+    agent::ArenaVector<agent::Position> possible_pos{&m_scratch};
 
-    bool success = false;
     int iter = 0;
-    while(!success)
+    while(!findNeighbors())
     {
-        try
+        s_findNeighborsMisses.add();
+
+        // update to new position
+        if(!possible_pos.empty())
         {
-            findNeighbors();
-            success = true;
+            agent::Position p = possible_pos.front();
+            m_movModel.correct(p.x, p.y);
+            s_candidatesTried.add();
+            possible_pos.erase(possible_pos.begin());
+            continue;
         }
-        catch(const std::runtime_error& e)
+        
+        // compute possible positions
+        for(double offset = iter*error; offset < (iter+1)*error; offset += 0.001)
         {
-            // update to new position
-            if(!possible_pos.empty())
+            for(double angle = 0; angle < 2*M_PI; angle += (M_PI/4))
             {
-                agent::Position p = possible_pos.front();
-                m_movModel.correct(p.x, p.y);
-                possible_pos.erase(possible_pos.begin());
-                continue;
+                double x = og_x + offset*cos(angle);
+                double y = og_y + offset*sin(angle);
+                possible_pos.push_back(agent::Position{x,y});
             }
-            
-            // compute possible positions
-            for(double offset = iter*error; offset < (iter+1)*error; offset += 0.001)
-            {
-                for(double angle = 0; angle < 2*M_PI; angle += (M_PI/4))
-                {
-                    double x = og_x + offset*cos(angle);
-                    double y = og_y + offset*sin(angle);
-                    possible_pos.push_back(agent::Position{x,y});
-                }
-            }
-
-            // erase first possible position (already checked)
-            possible_pos.erase(possible_pos.begin());
-            iter++;
         }
+
+        // erase first possible position (already checked)
+        possible_pos.erase(possible_pos.begin());
+        iter++;
     }
 }
 
 bool AgentC4::findNeighbors()
 {
+    ROBSOCK_TRACE_SCOPE("findNeighbors");
+
     using namespace agent;
 
-    bool any_nei = false;
-    
     // read line sensor
     bool line[7];
     GetLineSensor(line);
@@ -296,14 +325,15 @@ bool AgentC4::findNeighbors()
     for(int i = 0; i < 7; i++) {
         ret |= line[i];
     }
-    if(!ret) return false;    
+    if(!ret) return true; // nothing to map, nothing to correct
 
     // robot position
     double x = m_movModel.getX();
     double y = m_movModel.getY();
     double dir = m_movModel.getDir();
 
-    std::vector<std::pair<int,int>> neighbors;
+    agent::ArenaVector<std::pair<int,int>> neighbors{&m_scratch};
+    neighbors.reserve(7);
 
     // nearest cell for each sensor
     for(int i = 0; i < 7; i++) {
@@ -320,31 +350,20 @@ bool AgentC4::findNeighbors()
              found = false;   // a wall is found (but might not be a valid one)
 
         // check if the sensor is inside one of the possible walls for the nearest cell
-        for(int i = 0; i < 8; i++) {
-            tmpw.update(nearest, (M_PI/4)*i);
+        for(int i = 0; i < N_DIRECTIONS; i++) {
+            if(neighborCellId(nearest, i) < 0) continue; // no wall past the border
+            tmpw.update(nearest, i);
             if(!tmpw.isInside(sensorPos.x, sensorPos.y)) continue;
 
             // check for intersections in any of the links already defined in the map
             // this code avoid a special case of when a robot is traversing diagonally and
             // one of the sensors is closer to a cell that is not a neighbor
-            if(fmod(M_PI/4*i, M_PI/2) != 0) {
-                std::pair<int,int> cells = tmpw.getCells();
-                Position c1 = computeCellCoordinates(cells.first);
-                Position c2 = computeCellCoordinates(cells.second);
-                
-                // rotate 90 degrees
-                if(c1.x > c2.x) {
-                    c1.x -= 2;
-                    c2.x += 2;
-                }
-                else {
-                    c1.x += 2;
-                    c2.x -= 2;
-                }
+            if(i % 2 != 0) {
+                // the crossing diagonal links the neighbors on each side of this one
+                int id1 = neighborCellId(nearest, (i + N_DIRECTIONS - 1) % N_DIRECTIONS);
+                int id2 = neighborCellId(nearest, (i + 1) % N_DIRECTIONS);
 
                 // check if linkage exists
-                int id1 = computeCellId(c1.x, c1.y);
-                int id2 = computeCellId(c2.x, c2.y);
                 if(m_perceivedMap.isNeighbor(id1,id2) || m_perceivedMap.isNeighbor(id2,id1)) {
                     in_wall = false;
                     found = true;
@@ -369,12 +388,10 @@ bool AgentC4::findNeighbors()
             found = true;
         }
 
-        // throw error to correct position
-        if(!found && !in_wall) { // check if wall is always found
-            throw std::runtime_error("no wall found"); // this should never happen on a simulation without noise
+        // no wall found, the position must be corrected
+        if(!found && !in_wall) {
+            return false; // this should never happen on a simulation without noise
         }
-
-        any_nei |= found;
     }
 
     // add neighbors to the map
@@ -384,7 +401,7 @@ bool AgentC4::findNeighbors()
         m_perceivedMap.linkNeighbor(nei.first, nei.second);
     }
 
-    return any_nei;
+    return true;
 }
 
 void AgentC4::driveMotorsExt(double t_lPow, double t_rPow)
@@ -2,6 +2,7 @@
 #define AGENT_C4_H
 
 #include "agent/agent.h"
+#include "agent/arena.h"
 #include "agent/map.h"
 #include "agent/pose.h"
 #include "agent/controller.h"
@@ -42,7 +43,8 @@ private:
     /**
      * @brief Find neighbors of the current cell and updates the perceived map.
      * 
-     * @return true if neighbors are found
+     * @return false if an active sensor is on no wall of its nearest cell,
+     *         so the position must be corrected; the map is then left as is
     */
     bool findNeighbors();
     
@@ -59,10 +61,17 @@ private:
     agent::CompassFilter m_compassFilter{};
     double m_pos_var{(1.5/100.0)*(1.5/100.0)},  // variance of the motors
            m_dir_var{(2.0)*(2.0)};              // variance of the direction
+    agent::Arena m_scratch{};                   // temporaries of a cycle, reset when it starts
     agent::PerceivedMap m_perceivedMap{};
     agent::Controller m_controller{};
     std::vector<int> m_checkpoints;
 
+    // latency phases (see AddLatencyPhase), -1 when not timed
+    int m_phaseLocalization{-1},
+        m_phaseMapping{-1},
+        m_phasePlanning{-1},
+        m_phaseControl{-1};
+
 };
 
 #endif // AGENT_C4_H
\ No newline at end of file
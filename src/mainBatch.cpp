@@ -0,0 +1,413 @@
+/* mainBatch.cpp
+ *
+ * Runs many episodes of AgentC4, each in a process of its own against the
+ * in-process simulator (see simulator/csimbackend.h), as many at a time as
+ * there are cores. Every combination of lab, noise level and seed is one
+ * episode. Each is scored against its lab and the results are written to
+ * one CSV or JSON report, with a summary per lab and noise level.
+ *
+ * The map and path scores are those of simulator/cscore.h, each lab is
+ * scored once before the episodes are started. They compare episodes with
+ * one another; they are not the simulator's awk scores.
+ */
+
+#include "robSock/RobSock.h"
+#include "robSock/clatency.h"
+#include "challenges/agentC4.h"
+#include "simulator/clab.h"
+#include "simulator/cscore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+struct Job
+{
+    std::string lab, grid;
+    double noise;
+    unsigned int seed;
+    std::string name;       // of the files written for the episode
+    const CScorer* scorer;
+};
+
+enum Status { EP_OK, EP_INCOMPLETE, EP_ERROR, EP_CRASH };
+
+static const char* statusNames[] = {"ok", "incomplete", "error", "crash"};
+
+/* sent from the episode's process to the runner, through a pipe */
+struct Result
+{
+    int status;
+    unsigned int cycles;        // simulation time when the agent stopped
+    double computeMs;           // time the agent took to compute its cycles
+    double wallMs;
+    int mapScore, mapBest;
+    double pathScore;
+};
+
+static double nowMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+
+/*** Episodes ***/
+
+/**
+ * Run one episode and score it, in the calling process.
+ *
+ * @param t_job The episode.
+ * @param t_dir Where its map, path and log are written.
+ * @return The results.
+*/
+static Result runEpisode(const Job& t_job, const std::string& t_dir)
+{
+    Result r;
+    memset(&r, 0, sizeof(r));
+    r.status = EP_ERROR;
+    double start = nowMs();
+
+    std::string base = t_dir + "/" + t_job.name;
+
+    // the agent's messages go to the episode's log
+    int log = open((base + ".log").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(log >= 0)
+    {
+        dup2(log, STDOUT_FILENO);
+        dup2(log, STDERR_FILENO);
+        close(log);
+    }
+
+    char noise[32];
+    snprintf(noise, sizeof(noise), "%g", t_job.noise);
+    setenv("ROBSOCK_SIM_NOISE", noise, 1);
+    setenv("ROBSOCK_SIM_SEED", std::to_string(t_job.seed).c_str(), 1);
+    if(!t_job.grid.empty()) setenv("ROBSOCK_SIM_GRID", t_job.grid.c_str(), 1);
+
+    double irSensorAngles[4] = {0.0, 60.0, -60.0, 180.0};
+    char name[] = "batchAgent";
+    std::string host = "sim:" + t_job.lab;
+    if(InitRobot2(name, 1, irSensorAngles, const_cast<char*>(host.c_str())) != 0)
+        return r;
+    EnableLatencyStats();
+
+    AgentC4 agent(base);
+    int ret = 1;
+    try {
+        ret = agent.run();
+    }
+    catch(std::exception& e)
+    {
+        std::cerr << "ERROR: during agent.run(): " << e.what() << std::endl;
+    }
+
+    if(agent.write() != 0) return r;
+    r.status = ret == 0 ? EP_OK : EP_INCOMPLETE;
+    r.cycles = GetTime();
+    r.computeMs = GetLatencyStats()->phase(LAT_CYCLE).total() / 1e6;
+    CloseRobot();
+
+    CScoreMap map;
+    map.read((base + ".map").c_str());
+    r.mapScore = t_job.scorer->mapScore(map);
+    r.mapBest = t_job.scorer->bestMapScore();
+    r.pathScore = t_job.scorer->pathScore((base + ".path").c_str());
+
+    r.wallMs = nowMs() - start;
+    return r;
+}
+
+/* the name of a file, without its directory and extension */
+static std::string stem(const std::string& t_fname)
+{
+    std::string s = t_fname.substr(t_fname.find_last_of('/') + 1);
+    return s.substr(0, s.find('.'));
+}
+
+/**
+ * Run the jobs, each in a process of its own, at most t_parallel at a time.
+ *
+ * @return The results, in the order of the jobs.
+*/
+static std::vector<Result> runJobs(const std::vector<Job>& t_jobs, const std::string& t_dir, int t_parallel)
+{
+    std::vector<Result> results(t_jobs.size());
+    std::map<pid_t, std::pair<size_t,int>> running;     // pid -> job, read end of its pipe
+    size_t next = 0, done = 0;
+
+    while(next < t_jobs.size() || !running.empty())
+    {
+        while(next < t_jobs.size() && (int)running.size() < t_parallel)
+        {
+            int fds[2];
+            if(pipe(fds) != 0) break;
+
+            pid_t pid = fork();
+            if(pid == 0)
+            {
+                close(fds[0]);
+                Result r = runEpisode(t_jobs[next], t_dir);
+                ssize_t n = write(fds[1], &r, sizeof(r));
+                exit(n == sizeof(r) ? 0 : 1);
+            }
+            close(fds[1]);
+            if(pid < 0)
+            {
+                close(fds[0]);
+                break;
+            }
+            running[pid] = std::make_pair(next++, fds[0]);
+        }
+        if(running.empty()) break;
+
+        int status;
+        pid_t pid = wait(&status);
+        if(pid < 0) break;
+        auto it = running.find(pid);
+        if(it == running.end()) continue;
+
+        Result& r = results[it->second.first];
+        if(read(it->second.second, &r, sizeof(r)) != sizeof(r))
+        {
+            memset(&r, 0, sizeof(r));
+            r.status = EP_CRASH;
+        }
+        close(it->second.second);
+
+        done++;
+        if(isatty(STDERR_FILENO)) fprintf(stderr, "\r%zu/%zu episodes", done, t_jobs.size());
+        running.erase(it);
+    }
+    if(isatty(STDERR_FILENO)) fprintf(stderr, "\n");
+
+    // jobs that could not be started
+    for(size_t i = next; i < t_jobs.size(); i++) results[i].status = EP_ERROR;
+    return results;
+}
+
+
+/*** Report ***/
+
+static void writeCsv(std::ostream& t_out, const std::vector<Job>& t_jobs, const std::vector<Result>& t_results)
+{
+    t_out << "lab,noise,seed,status,map_score,map_best,path_score,cycles,compute_ms,wall_ms\n";
+    for(size_t i = 0; i < t_jobs.size(); i++)
+    {
+        const Job& j = t_jobs[i];
+        const Result& r = t_results[i];
+        char line[512];
+        snprintf(line, sizeof(line), "%s,%g,%u,%s,%d,%d,%.4f,%u,%.3f,%.1f\n",
+                 j.lab.c_str(), j.noise, j.seed, statusNames[r.status], r.mapScore, r.mapBest,
+                 r.pathScore, r.cycles, r.computeMs, r.wallMs);
+        t_out << line;
+    }
+}
+
+static void writeJson(std::ostream& t_out, const std::vector<Job>& t_jobs, const std::vector<Result>& t_results)
+{
+    t_out << "[\n";
+    for(size_t i = 0; i < t_jobs.size(); i++)
+    {
+        const Job& j = t_jobs[i];
+        const Result& r = t_results[i];
+        char line[1024];
+        snprintf(line, sizeof(line),
+                 "  {\"lab\": \"%s\", \"noise\": %g, \"seed\": %u, \"status\": \"%s\", \"map_score\": %d, "
+                 "\"map_best\": %d, \"path_score\": %.4f, \"cycles\": %u, \"compute_ms\": %.3f, \"wall_ms\": %.1f}%s\n",
+                 j.lab.c_str(), j.noise, j.seed, statusNames[r.status], r.mapScore, r.mapBest,
+                 r.pathScore, r.cycles, r.computeMs, r.wallMs, i + 1 < t_jobs.size() ? "," : "");
+        t_out << line;
+    }
+    t_out << "]\n";
+}
+
+/* mean and half width of its 95% confidence interval */
+static void meanCi(const std::vector<double>& t_v, double& t_mean, double& t_ci)
+{
+    t_mean = t_ci = 0.0;
+    if(t_v.empty()) return;
+    for(double v : t_v) t_mean += v;
+    t_mean /= t_v.size();
+    if(t_v.size() < 2) return;
+
+    double ss = 0.0;
+    for(double v : t_v) ss += (v - t_mean) * (v - t_mean);
+    t_ci = 1.96 * sqrt(ss / (t_v.size() - 1) / t_v.size());
+}
+
+static void writeSummary(const std::vector<Job>& t_jobs, const std::vector<Result>& t_results)
+{
+    // groups in the order they were first seen
+    std::vector<std::pair<std::string,double>> groups;
+    for(const Job& j : t_jobs)
+        if(std::find(groups.begin(), groups.end(), std::make_pair(j.lab, j.noise)) == groups.end())
+            groups.push_back(std::make_pair(j.lab, j.noise));
+
+    fprintf(stderr, "%-24s %6s %5s %5s %18s %16s %14s %14s\n", "lab", "noise", "runs", "ok",
+            "map score", "path score", "cycles", "compute(ms)");
+    for(const auto& g : groups)
+    {
+        std::vector<double> map, path, cycles, compute;
+        int runs = 0, ok = 0;
+        for(size_t i = 0; i < t_jobs.size(); i++)
+        {
+            if(t_jobs[i].lab != g.first || t_jobs[i].noise != g.second) continue;
+            const Result& r = t_results[i];
+            runs++;
+            if(r.status == EP_OK) ok++;
+            if(r.status == EP_ERROR || r.status == EP_CRASH) continue;
+            map.push_back(r.mapBest ? (double)r.mapScore / r.mapBest : 0.0);
+            path.push_back(r.pathScore);
+            cycles.push_back(r.cycles);
+            compute.push_back(r.computeMs);
+        }
+
+        double m[4], ci[4];
+        meanCi(map, m[0], ci[0]);
+        meanCi(path, m[1], ci[1]);
+        meanCi(cycles, m[2], ci[2]);
+        meanCi(compute, m[3], ci[3]);
+        fprintf(stderr, "%-24s %6g %5d %5d %9.3f +- %5.3f %7.3f +- %5.3f %6.0f +- %5.0f %6.1f +- %5.1f\n",
+                stem(g.first).c_str(), g.second, runs, ok, m[0], ci[0], m[1], ci[1], m[2], ci[2], m[3], ci[3]);
+    }
+    fprintf(stderr, "(map score as a fraction of the lab's, means +- 95%% confidence;\n"
+                    " scores of bin/score, not of the simulator's awk scripts)\n");
+}
+
+
+/*** Main ***/
+
+static void usage()
+{
+    std::cerr << "SYNOPSIS: mainBatch --lab labfile [--lab labfile]... [--grid gridfile]... [--param paramfile]\n"
+                 "                 [--seeds first[-last]] [--noise level[,level]...] [--jobs n]\n"
+                 "                 [--out dir] [--csv file | --json file]\n"
+                 "  --lab     a lab to run on, every lab gets every seed and noise level\n"
+                 "  --grid    the starting grid of the lab given in the same position, or of all labs\n"
+                 "  --param   the simulation parameters (default: ROBSOCK_SIM_PARAM)\n"
+                 "  --seeds   the noise seeds (1-10)\n"
+                 "  --noise   scales of the noise levels of the parameters (1)\n"
+                 "  --jobs    episodes run at a time (the number of cores)\n"
+                 "  --out     where the map, path and log of each episode are written (batch)\n"
+                 "  --csv, --json  the report, one line per episode (default: CSV on stdout)" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> labs, grids;
+    std::vector<double> noises;
+    unsigned int firstSeed = 1, lastSeed = 10;
+    int parallel = std::max(1u, std::thread::hardware_concurrency());
+    std::string dir = "batch", csv, json;
+
+    for(int a = 1; a < argc; a++)
+    {
+        std::string opt = argv[a];
+        if(a + 1 >= argc) { usage(); return 1; }
+        const char* val = argv[++a];
+
+        if(opt == "--lab") labs.push_back(val);
+        else if(opt == "--grid") grids.push_back(val);
+        else if(opt == "--param") setenv("ROBSOCK_SIM_PARAM", val, 1);
+        else if(opt == "--seeds")
+        {
+            char* end;
+            firstSeed = lastSeed = strtoul(val, &end, 10);
+            if(*end == '-') lastSeed = strtoul(end + 1, 0, 10);
+        }
+        else if(opt == "--noise")
+        {
+            for(const char* p = val; ; p++)
+            {
+                char* end;
+                double noise = strtod(p, &end);
+                if(end == p) break;
+                noises.push_back(noise);
+                if(*end != ',') break;
+                p = end;
+            }
+        }
+        else if(opt == "--jobs") parallel = atoi(val);
+        else if(opt == "--out") dir = val;
+        else if(opt == "--csv") csv = val;
+        else if(opt == "--json") json = val;
+        else if(opt == "--scoring")
+            ; // accepted for compatibility with the CiberRato simulator arguments
+        else { usage(); return 1; }
+    }
+    if(labs.empty() || lastSeed < firstSeed || parallel < 1 ||
+       (grids.size() > 1 && grids.size() != labs.size()))
+    {
+        usage();
+        return 1;
+    }
+    if(noises.empty()) noises.push_back(1.0);
+
+    // the ground truth of each lab, shared by its episodes
+    std::vector<std::unique_ptr<CScorer>> scorers;
+    for(size_t l = 0; l < labs.size(); l++)
+    {
+        CLab lab;
+        std::string grid = grids.empty() ? "" : grids[grids.size() > 1 ? l : 0];
+        if(!lab.loadLab(labs[l].c_str()) || (!grid.empty() && !lab.loadGrid(grid.c_str())))
+        {
+            std::cerr << "Can not read " << labs[l] << (grid.empty() ? "" : " or " + grid) << std::endl;
+            return 1;
+        }
+        scorers.push_back(std::unique_ptr<CScorer>(new CScorer(lab)));
+    }
+
+    std::vector<Job> jobs;
+    for(size_t l = 0; l < labs.size(); l++)
+        for(double noise : noises)
+            for(unsigned int seed = firstSeed; seed <= lastSeed; seed++)
+            {
+                Job j;
+                j.lab = labs[l];
+                j.grid = grids.empty() ? "" : grids[grids.size() > 1 ? l : 0];
+                j.noise = noise;
+                j.seed = seed;
+                j.scorer = scorers[l].get();
+                char name[64];
+                snprintf(name, sizeof(name), "-%zu-n%g-s%u", l, noise, seed);
+                j.name = stem(labs[l]) + name;
+                jobs.push_back(j);
+            }
+
+    mkdir(dir.c_str(), 0755);
+    std::cout.flush();
+    std::vector<Result> results = runJobs(jobs, dir, parallel);
+
+    if(!json.empty())
+    {
+        std::ofstream out(json);
+        writeJson(out, jobs, results);
+    }
+    else if(!csv.empty())
+    {
+        std::ofstream out(csv);
+        writeCsv(out, jobs, results);
+    }
+    else
+        writeCsv(std::cout, jobs, results);
+
+    writeSummary(jobs, results);
+    return 0;
+}
@@ -3,6 +3,7 @@
 
 #include "robSock/RobSock.h"
 #include "challenges/agentC4.h"
+#include "agent/metrics.h"
 
 #include <iostream>
 #include <string>
@@ -39,6 +40,8 @@ int main(int argc, char** argv)
     int rob_id = 1;
     int challenge = 0;
     std::string outfile = "solution";
+    std::string metricsfile;
+    int metricsInterval = 1000;
 
     // processing arguments
     while(argc > 2) // every option has a value, thus argc must be 1, 3, 5, ...
@@ -67,6 +70,15 @@ int main(int argc, char** argv)
         {
             outfile = argv[2];
         }
+        else if(opt == "--metrics" || opt == "-m")
+        {
+            metricsfile = argv[2];
+        }
+        else if(opt == "--metrics-interval")
+        {
+            try { metricsInterval = std::stoi(argv[2]); }
+            catch(...) { argc = 0; } // error message will be printed
+        }
         else
         {
             break;
@@ -78,7 +90,7 @@ int main(int argc, char** argv)
     if (argc != 1)
     {
         std::cerr << "Bad number of parameters\n" <<
-            "SYNOPSIS: mainRob [--challenge chanumber] [--host hostname] [--robname robotname] [--pos posnumber] [--outfile outfilename]" << std::endl;
+            "SYNOPSIS: mainRob [--challenge chanumber] [--host hostname] [--robname robotname] [--pos posnumber] [--outfile outfilename] [--metrics metricsfile] [--metrics-interval ms]" << std::endl;
       return 1;
     }
 
@@ -91,6 +103,10 @@ int main(int argc, char** argv)
     }
     std::cout << rob_name << " Connected" << std::endl;
 
+    // snapshots of the agent's metrics over the run
+    if(!metricsfile.empty() && !agent::Metrics::global().startPeriodicDump(metricsfile, metricsInterval))
+        std::cerr << "Can not write metrics to " << metricsfile << std::endl;
+
     // select agent
     int ret;
     switch (challenge)
@@ -103,5 +119,10 @@ int main(int argc, char** argv)
             ret = 1;
     }
 
+    agent::Metrics::global().stopPeriodicDump();
+
+    // flushes a recording, reports on a replay
+    CloseRobot();
+
     return ret;
 }
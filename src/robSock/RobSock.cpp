@@ -26,14 +26,90 @@
 #include <iostream>
 
 #include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <locale.h>
 
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "robSock/RobSock.h"
 
 #include "robSock/croblink.h"
+#include "robSock/clogger.h"
 
 static CRobLink *robLink=0;
 
+/* handles are opaque pointers to the CRobLink they own */
+static inline CRobLink *robLinkOf(RobHandle h)
+{
+    assert(h!=0);
+    return reinterpret_cast<CRobLink *>(h);
+}
+
+static inline RobHandle defaultHandle(void)
+{
+    return reinterpret_cast<RobHandle>(robLink);
+}
+
+/* ROBSOCK_NETTHREAD=1 moves socket I/O to a background thread */
+static void startNetThreadFromEnv(CRobLink *link)
+{
+    const char *env = getenv("ROBSOCK_NETTHREAD");
+    if(env != 0 && atoi(env) != 0)
+        link->startNetThread();
+}
+
+/* ROBSOCK_LATENCY=1 times every cycle */
+static void latencyStatsFromEnv(CRobLink *link)
+{
+    const char *env = getenv("ROBSOCK_LATENCY");
+    if(env != 0 && atoi(env) != 0)
+        link->enableLatencyStats();
+}
+
+/* ROBSOCK_RECORD=file records the robot, "%d" in file becomes its id */
+static void startRecordingFromEnv(CRobLink *link, int id)
+{
+    const char *env = getenv("ROBSOCK_RECORD");
+    if(env == 0 || env[0] == '\0') return;
+
+    std::string file = env;
+    std::string::size_type pos = file.find("%d");
+    if(pos != std::string::npos) file.replace(pos, 2, std::to_string(id));
+
+    if(!link->startRecording(file.c_str()))
+        ROBSOCK_LOG("robSock: can not record to %s", file);
+}
+
+static bool registerTimeoutSet = false;
+
+/* ROBSOCK_REGISTER_TIMEOUT=ms sets the registration deadline,
+ * unless SetRegisterTimeout was called */
+static void registerTimeoutFromEnv(void)
+{
+    if(registerTimeoutSet) return;
+    const char *env = getenv("ROBSOCK_REGISTER_TIMEOUT");
+    if(env != 0 && atoi(env) > 0)
+        CRobLink::setRegisterTimeout(atoi(env));
+}
+
+/* takes ownership of link, returns 0 if the registration failed */
+static RobHandle initHandle(CRobLink *link, int id)
+{
+    setlocale(LC_ALL,"C");
+    if(link->status() != 0) {
+        delete link;
+        return 0;
+    }
+    startNetThreadFromEnv(link);
+    startRecordingFromEnv(link, id);
+    latencyStatsFromEnv(link);
+    return reinterpret_cast<RobHandle>(link);
+}
+
 /* Init */
 void *Link(void)
 {
@@ -41,208 +117,519 @@ void *Link(void)
     return robLink;
 }
 
+RobHandle InitRobotH(char *rob_name, int rob_id, char *host)
+{
+    registerTimeoutFromEnv();
+    return initHandle(new CRobLink(rob_name, rob_id, host), rob_id);
+}
+
+RobHandle InitRobot2H(char *rob_name, int rob_id, double IRSensorAngles[NUM_IR_SENSORS], char *host)
+{
+    registerTimeoutFromEnv();
+    return initHandle(new CRobLink(rob_name, rob_id, IRSensorAngles, host), rob_id);
+}
+
+RobHandle InitRobotBeaconH(char *rob_name, int rob_id, double height, char *host)
+{
+    registerTimeoutFromEnv();
+    return initHandle(new CRobLink(rob_name, rob_id, height, host), rob_id);
+}
+
+int InitRobotsH(int n, char *rob_names[], int rob_ids[], double IRSensorAngles[][NUM_IR_SENSORS],
+                char *host, RobHandle handles[])
+{
+    registerTimeoutFromEnv();
+
+    // registrations wait on the network, run them side by side
+    std::vector<CRobLink *> links(n);
+    std::vector<std::thread> threads;
+    for(int i = 0; i < n; i++)
+        threads.push_back(std::thread([&, i]() {
+            if(IRSensorAngles != 0)
+                links[i] = new CRobLink(rob_names[i], rob_ids[i], IRSensorAngles[i], host);
+            else
+                links[i] = new CRobLink(rob_names[i], rob_ids[i], host);
+        }));
+    for(unsigned int i = 0; i < threads.size(); i++)
+        threads[i].join();
+
+    int registered = 0;
+    for(int i = 0; i < n; i++) {
+        handles[i] = initHandle(links[i], rob_ids[i]);
+        if(handles[i] != 0) registered++;
+    }
+    return registered;
+}
+
+void CloseRobotH(RobHandle h)
+{
+    if(h == defaultHandle()) robLink = 0;
+    delete robLinkOf(h);
+}
 
 int InitRobot(char *rob_name, int rob_id, char *host)
 {
     assert(robLink==0);
-    robLink=new CRobLink(rob_name, rob_id, host);
-    setlocale(LC_ALL,"C");
-    return robLink->status();
+    robLink=reinterpret_cast<CRobLink *>(InitRobotH(rob_name, rob_id, host));
+    return robLink!=0 ? 0 : -1;
 }
 
 int InitRobot2(char *rob_name, int rob_id, double IRSensorAngles[NUM_IR_SENSORS], char *host)
 {
     assert(robLink==0);
-    robLink=new CRobLink(rob_name, rob_id, IRSensorAngles, host);
-    setlocale(LC_ALL,"C");
-    return robLink->status();
+    robLink=reinterpret_cast<CRobLink *>(InitRobot2H(rob_name, rob_id, IRSensorAngles, host));
+    return robLink!=0 ? 0 : -1;
 }
 
 int InitRobotBeacon(char *rob_name, int rob_id, double height, char *host)
 {
     assert(robLink==0);
-    robLink=new CRobLink(rob_name, rob_id, height, host);
-    setlocale(LC_ALL,"C");
-    return robLink->status();
+    robLink=reinterpret_cast<CRobLink *>(InitRobotBeaconH(rob_name, rob_id, height, host));
+    return robLink!=0 ? 0 : -1;
+}
+
+void CloseRobot(void)
+{
+    CloseRobotH(defaultHandle());
+}
+
+void SetRegisterTimeout(int timeoutMs)
+{
+    registerTimeoutSet = true;
+    CRobLink::setRegisterTimeout(timeoutMs);
+}
+
+void GetStartupTimesH(RobHandle h, double *registerMs, double *firstPacketMs)
+{
+    CRobLink *link = robLinkOf(h);
+    if(registerMs) *registerMs = link->registerTime();
+    if(firstPacketMs) *firstPacketMs = link->firstPacketTime();
+}
+
+void GetStartupTimes(double *registerMs, double *firstPacketMs)
+{
+    GetStartupTimesH(defaultHandle(), registerMs, firstPacketMs);
+}
+
+RobHandle GetDefaultRobot(void)
+{
+    return defaultHandle();
+}
+
+void SetDefaultRobot(RobHandle h)
+{
+    robLink = reinterpret_cast<CRobLink *>(h);
+}
+
+int ReadSensorsH(RobHandle h)
+{
+    return robLinkOf(h)->ReadSensors();
 }
 
 int ReadSensors(void)
 {
-    assert(robLink!=0);
-    int n = robLink->ReadSensors();
+    int n = ReadSensorsH(defaultHandle());
     if (n<=0) exit(1); // error or timeout 
     return n;
 }
 
+int StartNetworkThreadH(RobHandle h)
+{
+    return robLinkOf(h)->startNetThread() ? 0 : -1;
+}
+
+int StartNetworkThread(void)
+{
+    return StartNetworkThreadH(defaultHandle());
+}
+
+int PollSensorsH(RobHandle h)
+{
+    return robLinkOf(h)->PollSensors();
+}
+
+int PollSensors(void)
+{
+    return PollSensorsH(defaultHandle());
+}
+
+int WaitSensorsH(RobHandle h, int timeoutMs)
+{
+    return robLinkOf(h)->WaitSensors(timeoutMs);
+}
+
+int WaitSensors(int timeoutMs)
+{
+    return WaitSensorsH(defaultHandle(), timeoutMs);
+}
+
+int StartRecordingH(RobHandle h, const char *file)
+{
+    return robLinkOf(h)->startRecording(file) ? 0 : -1;
+}
+
+int StartRecording(const char *file)
+{
+    return StartRecordingH(defaultHandle(), file);
+}
+
+void StopRecordingH(RobHandle h)
+{
+    robLinkOf(h)->stopRecording();
+}
+
+void StopRecording(void)
+{
+    StopRecordingH(defaultHandle());
+}
+
+int EnableLatencyStatsH(RobHandle h)
+{
+    return robLinkOf(h)->enableLatencyStats() ? 0 : -1;
+}
+
+int EnableLatencyStats(void)
+{
+    return EnableLatencyStatsH(defaultHandle());
+}
+
+int AddLatencyPhaseH(RobHandle h, const char *name)
+{
+    return robLinkOf(h)->addLatencyPhase(name);
+}
+
+int AddLatencyPhase(const char *name)
+{
+    return AddLatencyPhaseH(defaultHandle(), name);
+}
+
+void EndLatencyPhaseH(RobHandle h, int phase)
+{
+    robLinkOf(h)->endLatencyPhase(phase);
+}
+
+void EndLatencyPhase(int phase)
+{
+    EndLatencyPhaseH(defaultHandle(), phase);
+}
+
+const CLatencyStats *GetLatencyStatsH(RobHandle h)
+{
+    return robLinkOf(h)->latencyStats();
+}
+
+const CLatencyStats *GetLatencyStats(void)
+{
+    return GetLatencyStatsH(defaultHandle());
+}
+
+double GetParseTimeH(RobHandle h)
+{
+    return robLinkOf(h)->parseTime() / 1e3;
+}
+
+double GetParseTime(void)
+{
+    return GetParseTimeH(defaultHandle());
+}
+
+unsigned int GetMissedCyclesH(RobHandle h)
+{
+    return robLinkOf(h)->missedCycles();
+}
+
+unsigned int GetMissedCycles(void)
+{
+    return GetMissedCyclesH(defaultHandle());
+}
+
 /* Time */
+unsigned int GetTimeH(RobHandle h)
+{
+    return robLinkOf(h)->time();
+}
+
 unsigned int GetTime(void)
 {
-    assert(robLink!=0);
-    return robLink->time();
+    return GetTimeH(defaultHandle());
 }
 
 /* Sensors */
 
+bool IsObstacleReadyH(RobHandle h, int id)
+{
+    return robLinkOf(h)->IRSensorReady(id);
+}
+
 bool IsObstacleReady(int id)
 {
-    assert(robLink!=0);
-    return robLink->IRSensorReady(id);
+    return IsObstacleReadyH(defaultHandle(), id);
+}
+
+double GetObstacleSensorH(RobHandle h, int id)
+{
+    return (double)(robLinkOf(h)->IRSensor(id));
 }
 
 double GetObstacleSensor(int id)
 {
-    assert(robLink!=0);
-    return (double)(robLink->IRSensor(id));
+    return GetObstacleSensorH(defaultHandle(), id);
+}
+
+int GetNumberOfBeaconsH(RobHandle h)
+{
+    return (robLinkOf(h)->nBeacons());
 }
 
 int GetNumberOfBeacons(void)
 {
-    assert(robLink!=0);
-    return (robLink->nBeacons());
+    return GetNumberOfBeaconsH(defaultHandle());
+}
+
+bool IsBeaconReadyH(RobHandle h, int id)
+{
+    return robLinkOf(h)->beaconReady(id);
 }
 
 bool IsBeaconReady(int id)
 {
-    assert(robLink!=0);
-    return robLink->beaconReady(id);
+    return IsBeaconReadyH(defaultHandle(), id);
+}
+
+struct beaconMeasure GetBeaconSensorH(RobHandle h, int id)
+{
+    return (robLinkOf(h)->beacon(id));
 }
 
 struct beaconMeasure GetBeaconSensor(int id)
 {
-    assert(robLink!=0);
-    return (robLink->beacon(id));
+    return GetBeaconSensorH(defaultHandle(), id);
 }
 
-bool IsLineSensorReady(int id)
+bool IsLineSensorReadyH(RobHandle h)
 {
-    assert(robLink!=0);
-    return robLink->lineSensorReady();
+    return robLinkOf(h)->lineSensorReady();
 }
 
-void GetLineSensor(bool *lineVals)
+bool IsLineSensorReady(void)
 {
-    assert(robLink!=0);
+    return IsLineSensorReadyH(defaultHandle());
+}
+
+void GetLineSensorH(RobHandle h, bool *lineVals)
+{
+    const vector<bool> &line = robLinkOf(h)->lineSensor();
 
     for(int i=0;i<N_LINE_ELEMENTS;i++) {
-        lineVals[i] = robLink->lineSensor()[i];
+        lineVals[i] = line[i];
     }
 
 }
 
+void GetLineSensor(bool *lineVals)
+{
+    GetLineSensorH(defaultHandle(), lineVals);
+}
+
+bool IsCompassReadyH(RobHandle h)
+{
+    return robLinkOf(h)->compassReady();
+}
+
 bool IsCompassReady(void)
 {
-    assert(robLink!=0);
-    return robLink->compassReady();
+    return IsCompassReadyH(defaultHandle());
+}
+
+double GetCompassSensorH(RobHandle h)
+{
+    return (double)(robLinkOf(h)->compass());
 }
 
 double GetCompassSensor(void)
 {
-    assert(robLink!=0);
-    return (double)(robLink->compass());
+    return GetCompassSensorH(defaultHandle());
+}
+
+bool NewMessageFromH(RobHandle h, int from)
+{
+    return robLinkOf(h)->newMessage(from);
 }
 
 bool NewMessageFrom(int from)
 {
-    assert(robLink!=0);
-    return robLink->newMessage(from);
+    return NewMessageFromH(defaultHandle(), from);
+}
+
+char* GetMessageFromH(RobHandle h, int from)
+{
+    // valid until the next ReadSensors
+    return const_cast<char *>(robLinkOf(h)->message(from).c_str());
 }
 
 char* GetMessageFrom(int from)
 {
-    assert(robLink!=0);
-    QByteArray latinMsg = robLink->message(from).toLatin1();
-    return (char *)latinMsg.constData();
+    return GetMessageFromH(defaultHandle(), from);
+}
+
+bool IsGPSReadyH(RobHandle h)
+{
+    return robLinkOf(h)->gpsReady();
 }
 
 bool IsGPSReady(void)
 {
-    assert(robLink!=0);
-    return robLink->gpsReady();
+    return IsGPSReadyH(defaultHandle());
+}
+
+bool IsGPSDirReadyH(RobHandle h)
+{
+    return robLinkOf(h)->gpsDirReady();
 }
 
 bool IsGPSDirReady(void)
 {
-    assert(robLink!=0);
-    return robLink->gpsDirReady();
+    return IsGPSDirReadyH(defaultHandle());
+}
+
+double GetXH(RobHandle h)
+{
+    return (double)(robLinkOf(h)->posx());
 }
 
 double GetX(void)
 {
-    assert(robLink!=0);
-    return (double)(robLink->posx());
+    return GetXH(defaultHandle());
+}
+
+double GetYH(RobHandle h)
+{
+    return (double)(robLinkOf(h)->posy());
 }
 
 double GetY(void)
 {
-    assert(robLink!=0);
-    return (double)(robLink->posy());
+    return GetYH(defaultHandle());
+}
+
+double GetDirH(RobHandle h)
+{
+    return (double)(robLinkOf(h)->posdir());
 }
 
 double GetDir(void)
 {
-    assert(robLink!=0);
-    return (double)(robLink->posdir());
+    return GetDirH(defaultHandle());
+}
+
+bool IsGroundReadyH(RobHandle h)
+{
+    return robLinkOf(h)->groundReady();
 }
 
 bool IsGroundReady(void)
 {
-    assert(robLink!=0);
-    return robLink->groundReady();
+    return IsGroundReadyH(defaultHandle());
+}
+
+int GetGroundSensorH(RobHandle h)
+{
+    return robLinkOf(h)->ground();
 }
 
 int GetGroundSensor(void)
 {
-    assert(robLink!=0);
-    return robLink->ground();
+    return GetGroundSensorH(defaultHandle());
+}
+
+bool IsBumperReadyH(RobHandle h)
+{
+    return robLinkOf(h)->collisionReady();
 }
 
 bool IsBumperReady(void)
 {
-    assert(robLink!=0);
-    return robLink->collisionReady();
+    return IsBumperReadyH(defaultHandle());
+}
+
+bool GetBumperSensorH(RobHandle h)
+{
+    return robLinkOf(h)->collision();
 }
 
 bool GetBumperSensor(void)
 {
-    assert(robLink!=0);
-    return robLink->collision();
+    return GetBumperSensorH(defaultHandle());
+}
+
+bool IsScoreReadyH(RobHandle h)
+{
+    return robLinkOf(h)->scoreReady();
 }
 
 bool IsScoreReady(void)
 {
-    assert(robLink!=0);
-    return robLink->scoreReady();
+    return IsScoreReadyH(defaultHandle());
+}
+
+int GetScoreSensorH(RobHandle h)
+{
+    return robLinkOf(h)->score();
 }
 
 int GetScoreSensor(void)
 {
-    assert(robLink!=0);
-    return robLink->score();
+    return GetScoreSensorH(defaultHandle());
 }
 
 
+void RequestGroundSensorH(RobHandle h)
+{
+    robLinkOf(h)->requestGround();
+}
+
 void RequestGroundSensor(void)
 {
-    assert(robLink!=0);
-    robLink->requestGround();
+    RequestGroundSensorH(defaultHandle());
+}
+
+void RequestCompassSensorH(RobHandle h)
+{
+    robLinkOf(h)->requestCompass();
 }
 
 void RequestCompassSensor(void)
 {
-    assert(robLink!=0);
-    robLink->requestCompass();
+    RequestCompassSensorH(defaultHandle());
+}
+
+void RequestBeaconSensorH(RobHandle h, int id)
+{
+    robLinkOf(h)->requestBeacon(id);
 }
 
 void RequestBeaconSensor(int id)
 {
-    assert(robLink!=0);
-    robLink->requestBeacon(id);
+    RequestBeaconSensorH(defaultHandle(), id);
+}
+
+void RequestObstacleSensorH(RobHandle h, int id)
+{
+    robLinkOf(h)->requestObstacle(id);
 }
 
 void RequestObstacleSensor(int id)
 {
-    assert(robLink!=0);
-    robLink->requestObstacle(id);
+    RequestObstacleSensorH(defaultHandle(), id);
+}
+
+void RequestSensorsH(RobHandle h, int nReqs, ...)
+{
+    va_list ap;
+
+    va_start(ap, nReqs);
+    robLinkOf(h)->requestSensors(nReqs, ap);
+    va_end(ap);
 }
 
 void RequestSensors(int nReqs, ...)
@@ -258,187 +645,296 @@ void RequestSensors(int nReqs, ...)
 
 
 /* Buttons */
+bool GetStartButtonH(RobHandle h)
+{
+    return robLinkOf(h)->start();
+}
+
 bool GetStartButton(void)
 {
-    assert(robLink!=0);
-    return robLink->start();
+    return GetStartButtonH(defaultHandle());
+}
+
+bool GetStopButtonH(RobHandle h)
+{
+    return robLinkOf(h)->stop();
 }
 
 bool GetStopButton(void)
 {
-    assert(robLink!=0);
-    return robLink->stop();
+    return GetStopButtonH(defaultHandle());
+}
+
+bool GetFinishedH(RobHandle h)
+{
+    return robLinkOf(h)->endLed();
 }
 
 bool GetFinished(void)
 {
-    assert(robLink!=0);
-    return robLink->endLed();
+    return GetFinishedH(defaultHandle());
+}
+
+bool GetReturningLedH(RobHandle h)
+{
+    return robLinkOf(h)->returningLed();
 }
 
 bool GetReturningLed(void)
 {
-    assert(robLink!=0);
-    return robLink->returningLed();
+    return GetReturningLedH(defaultHandle());
+}
+
+bool GetVisitingLedH(RobHandle h)
+{
+    return robLinkOf(h)->visitingLed();
 }
 
 bool GetVisitingLed(void)
 {
-    assert(robLink!=0);
-    return robLink->visitingLed();
+    return GetVisitingLedH(defaultHandle());
 }
 
 // Commands
+void DriveMotorsH(RobHandle h, double lPow,double rPow)
+{
+    robLinkOf(h)->DriveMotors(lPow,rPow);
+}
+
 void DriveMotors(double lPow,double rPow)
 {
-    assert(robLink!=0);
-    robLink->DriveMotors(lPow,rPow);
+    DriveMotorsH(defaultHandle(), lPow, rPow);
+}
+
+void SetReturningLedH(RobHandle h, bool val)
+{
+    robLinkOf(h)->SetReturningLed(val);
 }
 
 void SetReturningLed(bool val)
 {
-    assert(robLink!=0);
-    robLink->SetReturningLed(val);
+    SetReturningLedH(defaultHandle(), val);
+}
+
+void SetVisitingLedH(RobHandle h, bool val)
+{
+    robLinkOf(h)->SetVisitingLed(val);
 }
 
 void SetVisitingLed(bool val)
 {
-    assert(robLink!=0);
-    robLink->SetVisitingLed(val);
+    SetVisitingLedH(defaultHandle(), val);
+}
+
+void FinishH(RobHandle h)
+{
+    robLinkOf(h)->Finish();
 }
 
 void Finish(void)
 {
-    assert(robLink!=0);
-    robLink->Finish();
+    FinishH(defaultHandle());
+}
+
+void ResetH(RobHandle h)
+{
+    robLinkOf(h)->Reset();
 }
 
 void Reset(void)
 {
-    assert(robLink!=0);
-    robLink->Reset();
+    ResetH(defaultHandle());
+}
+
+void SayH(RobHandle h, char *msg)
+{
+    robLinkOf(h)->Say(msg);
 }
 
 void Say(char *msg)
 {
-    assert(robLink!=0);
-    robLink->Say(msg);
+    SayH(defaultHandle(), msg);
 }
 // Parameters
+int GetCycleTimeH(RobHandle h)
+{
+    return robLinkOf(h)->cycleTime();
+}
+
 int GetCycleTime(void)
 {
-    assert(robLink!=0);
-    return robLink->cycleTime();
+    return GetCycleTimeH(defaultHandle());
+}
+
+int GetFinalTimeH(RobHandle h)
+{
+    return robLinkOf(h)->finalTime();
 }
 
 int GetFinalTime(void)
 {
-    assert(robLink!=0);
-    return robLink->finalTime();
+    return GetFinalTimeH(defaultHandle());
+}
+
+int GetKeyTimeH(RobHandle h)
+{
+    return robLinkOf(h)->keyTime();
 }
 
 int GetKeyTime(void)
 {
-    assert(robLink!=0);
-    return robLink->keyTime();
+    return GetKeyTimeH(defaultHandle());
 }
 
-unsigned int  GetNumberRequestsPerCycle(void)
+unsigned int GetNumberRequestsPerCycleH(RobHandle h)
 {
-    assert(robLink!=0);
-    return (robLink->nReqPerCycle());
+    return (robLinkOf(h)->nReqPerCycle());
+}
+
+unsigned int GetNumberRequestsPerCycle(void)
+{
+    return GetNumberRequestsPerCycleH(defaultHandle());
+}
+
+double GetNoiseObstacleSensorH(RobHandle h)
+{
+    return (double)(robLinkOf(h)->obstacleNoise());
 }
 
 double GetNoiseObstacleSensor(void)
 {
-    assert(robLink!=0);
-    return (double)(robLink->obstacleNoise());
+    return GetNoiseObstacleSensorH(defaultHandle());
+}
+
+double GetNoiseBeaconSensorH(RobHandle h)
+{
+    return (double)(robLinkOf(h)->beaconNoise());
 }
 
 double GetNoiseBeaconSensor(void)
 {
-    assert(robLink!=0);
-    return (double)(robLink->beaconNoise());
+    return GetNoiseBeaconSensorH(defaultHandle());
+}
+
+double GetNoiseCompassSensorH(RobHandle h)
+{
+    return (double)(robLinkOf(h)->compassNoise());
 }
 
 double GetNoiseCompassSensor(void)
 {
-    assert(robLink!=0);
-    return (double)(robLink->compassNoise());
+    return GetNoiseCompassSensorH(defaultHandle());
+}
+
+double GetNoiseMotorsH(RobHandle h)
+{
+    return (double)(robLinkOf(h)->motorsNoise());
 }
 
 double GetNoiseMotors(void)
 {
-    assert(robLink!=0);
-    return (double)(robLink->motorsNoise());
+    return GetNoiseMotorsH(defaultHandle());
 }
 
-double GetBeaconAperture()
+double GetBeaconApertureH(RobHandle h)
 {
-    assert(robLink!=0);
-    return (robLink->beaconAperture());
+    return (robLinkOf(h)->beaconAperture());
 }
 
-unsigned int GetBeaconLatency()
+double GetBeaconAperture(void)
 {
-    assert(robLink!=0);
-    return (robLink->beaconLatency());
+    return GetBeaconApertureH(defaultHandle());
 }
 
-unsigned int GetGroundLatency()
+unsigned int GetBeaconLatencyH(RobHandle h)
 {
-    assert(robLink!=0);
-    return (robLink->groundLatency());
+    return (robLinkOf(h)->beaconLatency());
 }
 
-unsigned int GetIRLatency()
+unsigned int GetBeaconLatency(void)
 {
-    assert(robLink!=0);
-    return (robLink->obstLatency());
+    return GetBeaconLatencyH(defaultHandle());
 }
 
-unsigned int GetBumperLatency()
+unsigned int GetGroundLatencyH(RobHandle h)
 {
-    assert(robLink!=0);
-    return (robLink->collisionLatency());
+    return (robLinkOf(h)->groundLatency());
 }
 
-bool GetBeaconRequestable()
+unsigned int GetGroundLatency(void)
 {
-    assert(robLink!=0);
-    return (robLink->beaconRequestable());
+    return GetGroundLatencyH(defaultHandle());
 }
 
-bool GetGroundRequestable()
+unsigned int GetIRLatencyH(RobHandle h)
 {
-    assert(robLink!=0);
-    return (robLink->groundRequestable());
+    return (robLinkOf(h)->obstLatency());
 }
 
-bool GetIRRequestable()
+unsigned int GetIRLatency(void)
 {
-    assert(robLink!=0);
-    return (robLink->obstRequestable());
+    return GetIRLatencyH(defaultHandle());
 }
 
-bool GetBumperRequestable()
+unsigned int GetBumperLatencyH(RobHandle h)
 {
-    assert(robLink!=0);
-    return (robLink->collisionRequestable());
+    return (robLinkOf(h)->collisionLatency());
 }
 
-void ReadMap(char *filename, void *vmap)
+unsigned int GetBumperLatency(void)
 {
-	/* set source of xml document */
-	QXmlInputSource source(new QFile(filename));
+    return GetBumperLatencyH(defaultHandle());
+}
 
+bool GetBeaconRequestableH(RobHandle h)
+{
+    return (robLinkOf(h)->beaconRequestable());
+}
+
+bool GetBeaconRequestable(void)
+{
+    return GetBeaconRequestableH(defaultHandle());
+}
+
+bool GetGroundRequestableH(RobHandle h)
+{
+    return (robLinkOf(h)->groundRequestable());
+}
+
+bool GetGroundRequestable(void)
+{
+    return GetGroundRequestableH(defaultHandle());
+}
+
+bool GetIRRequestableH(RobHandle h)
+{
+    return (robLinkOf(h)->obstRequestable());
+}
+
+bool GetIRRequestable(void)
+{
+    return GetIRRequestableH(defaultHandle());
+}
+
+bool GetBumperRequestableH(RobHandle h)
+{
+    return (robLinkOf(h)->collisionRequestable());
+}
+
+bool GetBumperRequestable(void)
+{
+    return GetBumperRequestableH(defaultHandle());
+}
+
+void ReadMap(char *filename, void *vmap)
+{
 	/* set parser handler */
     StructureParser handler(1); // 1 is dummy
 
 	/* parse xml document with handler */
-    QXmlSimpleReader reader;
+    XmlReader reader;
     reader.setContentHandler(&handler);
-    reader.parse(source);
+    reader.parseFile(filename);
 
 	memcpy(vmap, handler.map, (CELLROWS*2-1)*(CELLCOLS*2-1));
 }
@@ -0,0 +1,189 @@
+/* callocs.cpp */
+
+#include "robSock/callocs.h"
+#include "robSock/clogger.h"
+
+#ifdef ROBSOCK_ALLOC_TRACKING
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <string>
+
+#include <execinfo.h>
+
+struct CAllocStack
+{
+    uint64_t hash;          // 0 for a free slot
+    int depth;
+    void *frames[ALLOC_STACK_DEPTH];
+    uint64_t count, bytes;
+};
+
+static std::atomic<uint64_t> allocs(0);
+static std::atomic<uint64_t> allocBytes(0);
+static thread_local uint64_t threadAllocs = 0;
+
+/* the stacks, in a table indexed by their hash, filled until full */
+static std::mutex stacksMutex;
+static CAllocStack stacks[ALLOC_STACKS];
+static int nStacks = 0;
+static uint64_t lostSamples = 0;
+
+static int samplePeriod = 0;                    // set at startup, none before
+static thread_local int untilSample = 0;
+static thread_local bool sampling = false;      // backtrace may allocate
+static std::string stacksFile;
+
+static bool startAllocs(void)
+{
+    const char *env = getenv("ROBSOCK_ALLOC_SAMPLE");
+    samplePeriod = env ? atoi(env) : 64;
+
+    env = getenv("ROBSOCK_ALLOCS");
+    if(env == 0 || env[0] == '\0') return false;
+
+    stacksFile = env;
+    atexit(CAllocs::flush);
+    return true;
+}
+
+bool CAllocs::on = startAllocs();
+
+__attribute__((noinline)) static void sample(size_t size)
+{
+    sampling = true;
+
+    // leave out this function, tracked and operator new
+    void *frames[ALLOC_STACK_DEPTH + 3];
+    int n = std::max(backtrace(frames, ALLOC_STACK_DEPTH + 3) - 3, 0);
+
+    uint64_t hash = 14695981039346656037ULL;    // FNV-1a of the return addresses
+    for(int i = 0; i < n; i++) {
+        hash ^= (uint64_t)(uintptr_t)frames[i + 3];
+        hash *= 1099511628211ULL;
+    }
+    if(hash == 0) hash = 1;
+
+    {
+        std::lock_guard<std::mutex> lock(stacksMutex);
+        int i = hash % ALLOC_STACKS;
+        for(int probe = 0; probe < ALLOC_STACKS && stacks[i].hash != 0 && stacks[i].hash != hash; probe++)
+            i = (i + 1) % ALLOC_STACKS;
+
+        CAllocStack &s = stacks[i];
+        if(s.hash == hash) {
+            s.count++;
+            s.bytes += size;
+        }
+        else if(s.hash == 0 && n > 0) {
+            s.hash = hash;
+            s.depth = n;
+            memcpy(s.frames, frames + 3, n * sizeof(void *));
+            s.count = 1;
+            s.bytes = size;
+            nStacks++;
+        }
+        else
+            lostSamples++;
+    }
+
+    sampling = false;
+}
+
+__attribute__((noinline)) static void *tracked(size_t size)
+{
+    allocs.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    threadAllocs++;
+
+    if(samplePeriod > 0 && --untilSample <= 0 && !sampling) {
+        untilSample = samplePeriod;
+        sample(size);
+    }
+
+    return malloc(size ? size : 1);
+}
+
+void *operator new(size_t size)
+{
+    void *p = tracked(size);
+    if(p == 0) throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    void *p = tracked(size);
+    if(p == 0) throw std::bad_alloc();
+    return p;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return tracked(size); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return tracked(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+uint64_t CAllocs::count(void)
+{
+    return allocs.load(std::memory_order_relaxed);
+}
+
+uint64_t CAllocs::bytes(void)
+{
+    return allocBytes.load(std::memory_order_relaxed);
+}
+
+uint64_t CAllocs::threadCount(void)
+{
+    return threadAllocs;
+}
+
+void CAllocs::flush(void)
+{
+    static std::once_flag flushed;
+    std::call_once(flushed, []() {
+        FILE *f = fopen(stacksFile.c_str(), "w");
+        if(f == 0) {
+            ROBSOCK_LOG("robSock: can not write the allocation stacks to %s: %s", stacksFile, strerror(errno));
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(stacksMutex);
+
+        // the stacks sampled most first
+        int order[ALLOC_STACKS];
+        int n = 0;
+        for(int i = 0; i < ALLOC_STACKS; i++)
+            if(stacks[i].hash != 0) order[n++] = i;
+        std::sort(order, order + n, [](int a, int b) { return stacks[a].count > stacks[b].count; });
+
+        fprintf(f, "# %llu allocations, %llu bytes, one in %d sampled: %d stacks, %llu samples of others\n",
+                (unsigned long long)CAllocs::count(), (unsigned long long)CAllocs::bytes(),
+                samplePeriod, nStacks, (unsigned long long)lostSamples);
+
+        sampling = true;
+        for(int i = 0; i < n; i++) {
+            const CAllocStack &s = stacks[order[i]];
+            fprintf(f, "%llu %llu\n", (unsigned long long)s.count, (unsigned long long)s.bytes);
+
+            char **names = backtrace_symbols(s.frames, s.depth);
+            for(int k = 0; k < s.depth; k++)
+                fprintf(f, "    %s\n", names ? names[k] : "?");
+            free(names);
+        }
+        sampling = false;
+
+        fclose(f);
+    });
+}
+
+#endif
@@ -0,0 +1,220 @@
+/* clatency.cpp */
+
+#include "robSock/clatency.h"
+#include "robSock/callocs.h"
+#include "robSock/clogger.h"
+
+#include <time.h>
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static inline uint64_t thread_allocs(void)
+{
+#ifdef ROBSOCK_ALLOC_TRACKING
+    return CAllocs::threadCount();
+#else
+    return 0;
+#endif
+}
+
+CLatencyHistogram::CLatencyHistogram() : n(0), maxNs(0), sumNs(0)
+{
+    for(int b = 0; b < LAT_BUCKETS; b++)
+        counts[b].store(0, std::memory_order_relaxed);
+}
+
+/* values below 16 ns get a bucket each, then 8 buckets per power of two */
+int CLatencyHistogram::bucket(long long ns)
+{
+    if(ns < 16) return ns < 0 ? 0 : (int)ns;
+
+    int e = 63 - __builtin_clzll((unsigned long long)ns);
+    int b = 16 + (e - 4) * 8 + (int)((ns >> (e - 3)) & 7);
+    return b < LAT_BUCKETS ? b : LAT_BUCKETS - 1;
+}
+
+long long CLatencyHistogram::upper(int b)
+{
+    if(b < 16) return b;
+
+    int e = 4 + (b - 16) / 8;
+    int sub = (b - 16) % 8;
+    return ((long long)(8 + sub + 1) << (e - 3)) - 1;
+}
+
+void CLatencyHistogram::add(long long ns)
+{
+    counts[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    n.fetch_add(1, std::memory_order_relaxed);
+    sumNs.fetch_add(ns, std::memory_order_relaxed);
+
+    long long m = maxNs.load(std::memory_order_relaxed);
+    while(ns > m && !maxNs.compare_exchange_weak(m, ns, std::memory_order_relaxed))
+        ;
+}
+
+void CLatencyHistogram::merge(const CLatencyHistogram &other)
+{
+    for(int b = 0; b < LAT_BUCKETS; b++)
+        counts[b].fetch_add(other.counts[b].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    n.fetch_add(other.count(), std::memory_order_relaxed);
+    sumNs.fetch_add(other.total(), std::memory_order_relaxed);
+
+    long long m = maxNs.load(std::memory_order_relaxed);
+    while(other.max() > m && !maxNs.compare_exchange_weak(m, other.max(), std::memory_order_relaxed))
+        ;
+}
+
+long long CLatencyHistogram::percentile(double p) const
+{
+    uint64_t total = count();
+    if(total == 0) return 0;
+
+    uint64_t rank = (uint64_t)(p * total + 0.5);
+    if(rank < 1) rank = 1;
+
+    uint64_t seen = 0;
+    for(int b = 0; b < LAT_BUCKETS; b++) {
+        seen += counts[b].load(std::memory_order_relaxed);
+        if(seen >= rank) return upper(b) < max() ? upper(b) : max();
+    }
+    return max();
+}
+
+CLatencyStats::CLatencyStats(unsigned int cycleTimeMs)
+    : allocCycleCount(0), nPhases(LAT_AGENT), cycleTime(cycleTimeMs), cycleStart(0), last(0), inCycle(false),
+      allocLast(0), allocCycleStart(0), allocOn(false)
+{
+    for(int i = 0; i < LAT_MAX_PHASES; i++) {
+        allocCount[i].store(0, std::memory_order_relaxed);
+        allocMax[i].store(0, std::memory_order_relaxed);
+    }
+
+    names[LAT_WAKEUP] = "wakeup";
+    names[LAT_PARSE] = "parse";
+    names[LAT_SEND] = "send";
+    names[LAT_CYCLE] = "cycle";
+}
+
+int CLatencyStats::addPhase(const char *name)
+{
+    if(nPhases == LAT_MAX_PHASES) return -1;
+    names[nPhases] = name;
+    return nPhases++;
+}
+
+void CLatencyStats::countAllocs(int id)
+{
+    uint64_t now = thread_allocs();
+    if(allocOn) {
+        uint64_t n = now - allocLast;
+        allocCount[id].fetch_add(n, std::memory_order_relaxed);
+        if(n > allocMax[id].load(std::memory_order_relaxed))
+            allocMax[id].store(n, std::memory_order_relaxed);
+    }
+    allocLast = now;
+}
+
+void CLatencyStats::received(long long kernelNs, long long recvNs)
+{
+    // the allocations since the last cycle are the wakeup's, those of the
+    // first cycle (the agent's setup) are left out
+    allocOn = hist[LAT_CYCLE].count() > 0;
+    countAllocs(LAT_WAKEUP);
+    allocCycleStart = allocLast;
+
+    if(kernelNs > 0 && kernelNs <= recvNs) {
+        hist[LAT_WAKEUP].add(recvNs - kernelNs);
+        cycleStart = kernelNs;
+    }
+    else
+        cycleStart = recvNs;
+
+    last = recvNs;
+    inCycle = true;
+}
+
+void CLatencyStats::parsed(void)
+{
+    long long now = now_ns();
+    hist[LAT_PARSE].add(now - last);
+    last = now;
+    countAllocs(LAT_PARSE);
+}
+
+void CLatencyStats::mark(int id)
+{
+    if(!inCycle || id < LAT_AGENT || id >= nPhases) return;
+
+    long long now = now_ns();
+    hist[id].add(now - last);
+    last = now;
+    countAllocs(id);
+}
+
+void CLatencyStats::sent(void)
+{
+    if(!inCycle) return;
+
+    long long now = now_ns();
+    hist[LAT_SEND].add(now - last);
+    hist[LAT_CYCLE].add(now - cycleStart);
+    inCycle = false;
+
+    uint64_t cycleStartAllocs = allocCycleStart;
+    countAllocs(LAT_SEND);
+    allocLast = cycleStartAllocs;
+    countAllocs(LAT_CYCLE);
+    if(allocOn) allocCycleCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CLatencyStats::dump(void) const
+{
+    const CLatencyHistogram &cycle = hist[LAT_CYCLE];
+    if(cycle.count() == 0) return;
+
+    ROBSOCK_LOG("latency: %llu cycles of %u ms, the median one takes %.2f%% of it",
+                cycle.count(), cycleTime,
+                cycleTime ? cycle.percentile(0.5) / (cycleTime * 1e4) : 0.0);
+    ROBSOCK_LOG("latency: %-14s %8s %10s %10s %10s %10s  (us)",
+                "phase", "count", "p50", "p90", "p99", "max");
+
+    // robSock's phases in cycle order, around the agent's
+    int order[LAT_MAX_PHASES];
+    int n = 0;
+    order[n++] = LAT_WAKEUP;
+    order[n++] = LAT_PARSE;
+    for(int i = LAT_AGENT; i < nPhases; i++)
+        order[n++] = i;
+    order[n++] = LAT_SEND;
+    order[n++] = LAT_CYCLE;
+
+    for(int i = 0; i < n; i++) {
+        const CLatencyHistogram &h = hist[order[i]];
+        if(h.count() == 0) continue;
+        ROBSOCK_LOG("latency: %-14s %8llu %10.1f %10.1f %10.1f %10.1f",
+                    names[order[i]], h.count(),
+                    h.percentile(0.5) / 1e3, h.percentile(0.9) / 1e3,
+                    h.percentile(0.99) / 1e3, h.max() / 1e3);
+    }
+
+#ifdef ROBSOCK_ALLOC_TRACKING
+    uint64_t cycles = allocCycles();
+    if(cycles == 0) return;
+
+    ROBSOCK_LOG("allocs: %llu cycles after the first", cycles);
+    ROBSOCK_LOG("allocs: %-14s %10s %10s %10s",
+                "phase", "total", "per cycle", "max");
+    for(int i = 0; i < n; i++) {
+        if(hist[order[i]].count() == 0 && allocs(order[i]) == 0) continue;
+        ROBSOCK_LOG("allocs: %-14s %10llu %10.1f %10llu",
+                    names[order[i]], allocs(order[i]),
+                    (double)allocs(order[i]) / cycles, maxAllocs(order[i]));
+    }
+#endif
+}
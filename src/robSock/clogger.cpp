@@ -0,0 +1,355 @@
+/* clogger.cpp */
+
+#include "robSock/clogger.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* how often the background thread drains the ring */
+#define LOG_DRAIN_MS 20
+
+struct CLogFormat
+{
+    const char *format;
+    const char *file;
+    int line;
+};
+
+/*
+ * Producers reserve consecutive slots by moving head forward, fill them
+ * and mark each one ready with the position it was written for. The
+ * single consumer takes slots in order while they are ready and frees
+ * them by moving tail. A message that does not fit is dropped.
+ * Everything here is allocated once and never freed, so messages logged
+ * while the process exits are still written.
+ */
+struct CLogState
+{
+    CLogRecord slots[LOG_RING_SLOTS];
+    std::atomic<uint64_t> ready[LOG_RING_SLOTS];    // position + 1 once written
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+    std::atomic<uint64_t> dropped;
+
+    std::mutex formatsMutex;
+    std::vector<CLogFormat> formats;
+
+    std::mutex drainMutex;                          // one consumer at a time
+    FILE *file;                                     // binary sink, 0 for text on stderr
+    uint32_t formatsWritten;
+    uint64_t droppedReported;
+
+    std::thread drainer;
+    std::atomic<bool> stopping;
+    std::atomic<bool> stopped;
+};
+
+static CLogState *state = 0;
+static std::once_flag stateOnce;
+
+static void drain(void);
+
+static void stopLogger(void)
+{
+    state->stopping.store(true);
+    if(state->drainer.joinable()) state->drainer.join();
+    state->stopped.store(true);
+    drain();
+    if(state->file) fflush(state->file);
+}
+
+static CLogState *getState(void)
+{
+    std::call_once(stateOnce, []() {
+        CLogState *s = new CLogState;
+        for(int i = 0; i < LOG_RING_SLOTS; i++)
+            s->ready[i].store(0, std::memory_order_relaxed);
+        s->head.store(0);
+        s->tail.store(0);
+        s->dropped.store(0);
+        s->formatsWritten = 0;
+        s->droppedReported = 0;
+        s->stopping.store(false);
+        s->stopped.store(false);
+
+        s->file = 0;
+        const char *env = getenv("ROBSOCK_LOG_FILE");
+        if(env != 0 && env[0] != '\0') {
+            s->file = fopen(env, "wb");
+            if(s->file) fwrite(LOG_MAGIC, 8, 1, s->file);
+            else fprintf(stderr, "robSock: can not write the log to %s, using stderr\n", env);
+        }
+
+        state = s;
+        s->drainer = std::thread([]() {
+            while(!state->stopping.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(LOG_DRAIN_MS));
+                drain();
+            }
+        });
+        atexit(stopLogger);
+    });
+    return state;
+}
+
+uint32_t CLogger::define(const char *format, const char *file, int line)
+{
+    CLogState *s = getState();
+    std::lock_guard<std::mutex> lock(s->formatsMutex);
+
+    CLogFormat f;
+    f.format = format;
+    f.file = file;
+    f.line = line;
+    s->formats.push_back(f);
+    return s->formats.size() - 1;
+}
+
+static inline uint32_t textRecords(size_t bytes)
+{
+    return (bytes + sizeof(CLogRecord) - 1) / sizeof(CLogRecord);
+}
+
+void CLogger::push(CLogRecord &r, const CLogText &text)
+{
+    CLogState *s = getState();
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    r.stamp = (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+
+    size_t bytes = 0;
+    for(int i = 0; i < text.n; i++)
+        bytes += text.len[i] + 1;
+    r.nText = textRecords(bytes);
+    uint64_t n = 1 + r.nText;
+
+    // reserve n slots, or drop the message if they are not free
+    uint64_t pos = s->head.load(std::memory_order_relaxed);
+    do {
+        if(pos + n - s->tail.load(std::memory_order_acquire) > LOG_RING_SLOTS) {
+            s->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    } while(!s->head.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed));
+
+    s->slots[pos % LOG_RING_SLOTS] = r;
+
+    // strings one after the other, each with its NUL
+    uint64_t slot = pos + 1;
+    size_t used = 0;
+    char *chunk = reinterpret_cast<char *>(&s->slots[slot % LOG_RING_SLOTS]);
+    for(int i = 0; i < text.n; i++) {
+        for(uint32_t c = 0; c <= text.len[i]; c++) {
+            if(used == sizeof(CLogRecord)) {
+                slot++;
+                chunk = reinterpret_cast<char *>(&s->slots[slot % LOG_RING_SLOTS]);
+                used = 0;
+            }
+            chunk[used++] = c < text.len[i] ? text.s[i][c] : '\0';
+        }
+    }
+
+    for(uint64_t p = pos; p < pos + n; p++)
+        s->ready[p % LOG_RING_SLOTS].store(p + 1, std::memory_order_release);
+
+    // once the drainer has stopped, messages are written right away
+    if(s->stopped.load(std::memory_order_relaxed)) drain();
+}
+
+void CLogger::flush(void)
+{
+    drain();
+    if(getState()->file) fflush(state->file);
+}
+
+/* writes a record and the text records after it */
+static void writeRecord(const CLogRecord &r, const char *text, uint32_t nText)
+{
+    fwrite(&r, sizeof(r), 1, state->file);
+    if(nText) fwrite(text, sizeof(CLogRecord), nText, state->file);
+}
+
+static void writeFormats(uint32_t upTo)
+{
+    std::lock_guard<std::mutex> lock(state->formatsMutex);
+
+    for(; state->formatsWritten < upTo && state->formatsWritten < state->formats.size(); state->formatsWritten++) {
+        const CLogFormat &f = state->formats[state->formatsWritten];
+
+        std::string text = f.file;
+        text += '\0';
+        text += f.format;
+        text += '\0';
+        uint32_t nText = textRecords(text.size());
+        text.resize(nText * sizeof(CLogRecord), '\0');
+
+        CLogRecord r;
+        memset(&r, 0, sizeof(r));
+        r.id = LOG_FORMAT_DEF;
+        r.nArgs = 2;
+        r.args[0].u = state->formatsWritten;
+        r.args[1].i = f.line;
+        r.nText = nText;
+        writeRecord(r, text.data(), nText);
+    }
+}
+
+static void emit(const CLogRecord &r, const char *text)
+{
+    if(state->file) {
+        if(r.id < LOG_DROPPED) writeFormats(r.id + 1);
+        writeRecord(r, text, r.nText);
+        return;
+    }
+
+    if(r.id == LOG_DROPPED) {
+        fprintf(stderr, "robSock: %llu log messages lost, the log ring was full\n",
+                (unsigned long long)r.args[0].u);
+        return;
+    }
+
+    const char *fmt;
+    {
+        std::lock_guard<std::mutex> lock(state->formatsMutex);
+        fmt = state->formats[r.id].format;
+    }
+    std::string line = CLogger::format(fmt, r, text);
+    fputs(line.c_str(), stderr);
+    if(line.empty() || line[line.size() - 1] != '\n') fputc('\n', stderr);
+}
+
+static void drain(void)
+{
+    if(state == 0) return;
+    std::lock_guard<std::mutex> lock(state->drainMutex);
+
+    uint64_t dropped = state->dropped.load(std::memory_order_relaxed);
+    if(dropped != state->droppedReported) {
+        CLogRecord r;
+        memset(&r, 0, sizeof(r));
+        r.stamp = 0;
+        r.id = LOG_DROPPED;
+        r.nArgs = 1;
+        r.args[0].u = dropped - state->droppedReported;
+        emit(r, 0);
+        state->droppedReported = dropped;
+    }
+
+    std::vector<char> text;
+    uint64_t tail = state->tail.load(std::memory_order_relaxed);
+    for(;;) {
+        if(state->ready[tail % LOG_RING_SLOTS].load(std::memory_order_acquire) != tail + 1) break;
+        const CLogRecord &r = state->slots[tail % LOG_RING_SLOTS];
+
+        // the text records must all be ready too
+        bool complete = true;
+        for(uint64_t p = tail + 1; p <= tail + r.nText; p++)
+            if(state->ready[p % LOG_RING_SLOTS].load(std::memory_order_acquire) != p + 1) complete = false;
+        if(!complete) break;
+
+        text.resize(r.nText * sizeof(CLogRecord));
+        for(uint32_t i = 0; i < r.nText; i++)
+            memcpy(&text[i * sizeof(CLogRecord)], &state->slots[(tail + 1 + i) % LOG_RING_SLOTS],
+                   sizeof(CLogRecord));
+
+        CLogRecord rec = r;
+        tail += 1 + r.nText;
+        state->tail.store(tail, std::memory_order_release);
+        emit(rec, text.empty() ? 0 : &text[0]);
+    }
+
+    if(state->file == 0) fflush(stderr);
+}
+
+/*
+ * printf, one conversion at a time, each given the argument in the type
+ * the conversion expects whatever type it was logged as.
+ */
+std::string CLogger::format(const char *fmt, const CLogRecord &r, const char *strings)
+{
+    std::string out;
+    unsigned int arg = 0;
+    const char *str = strings;
+    char buf[LOG_MAX_STRING + 64];
+
+    for(const char *p = fmt; *p; p++) {
+        if(*p != '%') {
+            out += *p;
+            continue;
+        }
+        if(p[1] == '%') {
+            out += '%';
+            p++;
+            continue;
+        }
+
+        // flags, width, precision and length of the conversion
+        std::string spec = "%";
+        const char *q = p + 1;
+        while(*q && strchr("-+ #0", *q)) spec += *q++;
+        while(*q && ((*q >= '0' && *q <= '9') || *q == '.')) spec += *q++;
+        while(*q && strchr("hlLqjzt", *q)) q++;
+        char conv = *q;
+        if(conv == '\0') break;
+        p = q;
+
+        if(arg >= r.nArgs) {
+            out += "<missing>";
+            continue;
+        }
+
+        int type = (r.types >> (2 * arg)) & 3;
+        int64_t i = r.args[arg].i;
+        uint64_t u = r.args[arg].u;
+        double d = r.args[arg].d;
+        const char *s = "";
+        if(type == LOG_ARG_STRING) {
+            s = str ? str : "";
+            if(str) str += u + 1;
+        }
+        arg++;
+
+        switch(conv) {
+        case 'd': case 'i':
+            spec += "lld";
+            snprintf(buf, sizeof(buf), spec.c_str(), (long long)(type == LOG_ARG_DOUBLE ? (int64_t)d : i));
+            break;
+        case 'u': case 'x': case 'X': case 'o':
+            spec += "ll";
+            spec += conv;
+            snprintf(buf, sizeof(buf), spec.c_str(), (unsigned long long)(type == LOG_ARG_DOUBLE ? (uint64_t)d : u));
+            break;
+        case 'c':
+            spec += 'c';
+            snprintf(buf, sizeof(buf), spec.c_str(), (int)i);
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec += conv;
+            snprintf(buf, sizeof(buf), spec.c_str(),
+                     type == LOG_ARG_DOUBLE ? d : type == LOG_ARG_INT ? (double)i : (double)u);
+            break;
+        case 's':
+            spec += 's';
+            if(type == LOG_ARG_STRING)
+                snprintf(buf, sizeof(buf), spec.c_str(), s);
+            else if(type == LOG_ARG_DOUBLE)
+                snprintf(buf, sizeof(buf), "%g", d);
+            else
+                snprintf(buf, sizeof(buf), type == LOG_ARG_INT ? "%lld" : "%llu",
+                         type == LOG_ARG_INT ? (long long)i : (unsigned long long)u);
+            break;
+        default:
+            snprintf(buf, sizeof(buf), "%%%c", conv);
+        }
+        out += buf;
+    }
+    return out;
+}
@@ -28,6 +28,9 @@ CMeasures::CMeasures(int nBeacons) : beaconReady(nBeacons), beacon(nBeacons)
 	ground    = -1;
 	compass   = 0.0;
 	collision = false;
+	start = stop = false;
+	endLed = returningLed = visitingLed = false;
+	x = y = dir = 0.0;
 
 	for(int b=0;b<nBeacons;b++)
 	{
@@ -0,0 +1,236 @@
+/* cnetthread.cpp */
+
+#include "robSock/cnetthread.h"
+#include "robSock/clogger.h"
+#include "robSock/croblink.h"
+
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+
+#define NETTHREAD_MSGMAXSIZE 4096
+
+static_assert(sizeof(std::atomic<int>) == sizeof(int), "futex word must be a plain int");
+
+static int futex_wait(std::atomic<int> *addr, int expected, const struct timespec *timeout)
+{
+    return syscall(SYS_futex, reinterpret_cast<int *>(addr), FUTEX_WAIT_PRIVATE, expected, timeout, NULL, 0);
+}
+
+static int futex_wake(std::atomic<int> *addr)
+{
+    return syscall(SYS_futex, reinterpret_cast<int *>(addr), FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+CNetThread::CNetThread(CTransport *t, int nb)
+    : transport(t), nBeacons(nb),
+      buffers{CMeasures(nb), CMeasures(nb), CMeasures(nb)},
+      back(0), front(1), frontSize(0), middle(2),
+      published(0), dropped(0), first(0), failed(false),
+      actionHead(0), actionTail(0), actionsLost(0),
+      epollfd(-1), wakefd(-1), running(false)
+{
+    sizes[0] = sizes[1] = sizes[2] = 0;
+}
+
+CNetThread::~CNetThread()
+{
+    stop();
+}
+
+bool CNetThread::start(void)
+{
+    if(running.load()) return true;
+    if(transport->fd() < 0) return false;
+
+    epollfd = epoll_create1(EPOLL_CLOEXEC);
+    if(epollfd < 0) return false;
+
+    wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(wakefd < 0) {
+        close(epollfd);
+        epollfd = -1;
+        return false;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = transport->fd();
+    if(epoll_ctl(epollfd, EPOLL_CTL_ADD, transport->fd(), &ev) < 0) {
+        stop();
+        return false;
+    }
+    ev.data.fd = wakefd;
+    if(epoll_ctl(epollfd, EPOLL_CTL_ADD, wakefd, &ev) < 0) {
+        stop();
+        return false;
+    }
+
+    running.store(true);
+    thread = std::thread(&CNetThread::run, this);
+    return true;
+}
+
+void CNetThread::stop(void)
+{
+    if(running.exchange(false)) {
+        uint64_t one = 1;
+        if(write(wakefd, &one, sizeof(one)) < 0) { /* thread also wakes on its epoll timeout */ }
+        thread.join();
+        flushActions(); // do not lose the last commands (e.g. Finish)
+        if(actionsLost.load() > 0)
+            ROBSOCK_LOG("robSock: %u actions could not be queued to the network thread", actionsLost.load());
+    }
+    if(wakefd >= 0) close(wakefd);
+    if(epollfd >= 0) close(epollfd);
+    wakefd = epollfd = -1;
+}
+
+bool CNetThread::send(const char *xml, int n)
+{
+    if(n > NETTHREAD_ACTION_MAXSIZE || !running.load()) {
+        actionsLost.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // full: wait for the I/O thread to send the older ones, sending this
+    // one from here would reorder them
+    unsigned int head = actionHead.load(std::memory_order_relaxed);
+    while(head - actionTail.load(std::memory_order_acquire) >= NETTHREAD_ACTION_SLOTS) {
+        if(!running.load() || failed.load()) {
+            actionsLost.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        struct timespec ts = {0, 20000};
+        nanosleep(&ts, NULL);
+    }
+
+    ActionSlot &slot = actions[head % NETTHREAD_ACTION_SLOTS];
+    memcpy(slot.xml, xml, n);
+    slot.len = n;
+    actionHead.store(head + 1, std::memory_order_release);
+
+    // queued either way: a failed write means the counter is already
+    // set, and the thread also flushes on its epoll timeout
+    uint64_t one = 1;
+    if(write(wakefd, &one, sizeof(one)) < 0) { /* see above */ }
+    return true;
+}
+
+void CNetThread::flushActions(void)
+{
+    unsigned int tail = actionTail.load(std::memory_order_relaxed);
+    unsigned int head = actionHead.load(std::memory_order_acquire);
+    for(; tail != head; tail++) {
+        ActionSlot &slot = actions[tail % NETTHREAD_ACTION_SLOTS];
+        transport->send(slot.xml, slot.len);
+    }
+    actionTail.store(tail, std::memory_order_release);
+}
+
+bool CNetThread::take(CMeasures &m)
+{
+    if(!(middle.load(std::memory_order_acquire) & DIRTY)) return false;
+
+    int prev = middle.exchange(front, std::memory_order_acq_rel);
+    front = prev & ~DIRTY;
+    frontSize = sizes[front];
+    m = buffers[front];
+    return true;
+}
+
+int CNetThread::poll(CMeasures &m)
+{
+    if(take(m)) return 1;
+    return failed.load() ? -1 : 0;
+}
+
+int CNetThread::wait(CMeasures &m, int timeoutMs)
+{
+    long long deadline = now_ns() + (long long)timeoutMs * 1000000LL;
+
+    for(;;) {
+        int seq = published.load(std::memory_order_acquire);
+        if(take(m)) return 1;
+        if(failed.load()) return -1;
+
+        struct timespec ts, *tsp = NULL;
+        if(timeoutMs >= 0) {
+            long long left = deadline - now_ns();
+            if(left <= 0) return 0;
+            ts.tv_sec = left / 1000000000LL;
+            ts.tv_nsec = left % 1000000000LL;
+            tsp = &ts;
+        }
+        // sleeps only if nothing was published since seq was read
+        futex_wait(&published, seq, tsp);
+    }
+}
+
+void CNetThread::run(void)
+{
+    char buf[NETTHREAD_MSGMAXSIZE];
+
+    while(running.load(std::memory_order_relaxed))
+    {
+        struct epoll_event events[2];
+        int nev = epoll_wait(epollfd, events, 2, 100);
+        if(nev < 0 && errno != EINTR) {
+            failed.store(true);
+            futex_wake(&published);
+            break;
+        }
+        if(nev == 0) flushActions();
+
+        for(int e = 0; e < nev; e++)
+        {
+            if(events[e].data.fd == wakefd) {
+                uint64_t cnt;
+                if(read(wakefd, &cnt, sizeof(cnt)) < 0) { /* spurious wakeup */ }
+                flushActions();
+                continue;
+            }
+
+            // drain every pending datagram, keep only the newest one
+            unsigned int superseded = 0;
+            int len = transport->drain(buf, NETTHREAD_MSGMAXSIZE, &superseded);
+            if(len < 0 || (len == 0 && (events[e].events & (EPOLLHUP | EPOLLERR)))) {
+                // e.g. the simulator closed a connected transport
+                failed.store(true);
+                futex_wake(&published);
+                return;
+            }
+            if(len == 0) continue;
+
+            if(!CRobLink::parse_measures(buf, len, nBeacons, buffers[back]))
+                continue;
+            sizes[back] = len;
+
+            int prev = middle.exchange(back | DIRTY, std::memory_order_acq_rel);
+            if(prev & DIRTY) dropped.fetch_add(1, std::memory_order_relaxed);
+            dropped.fetch_add(superseded, std::memory_order_relaxed);
+            back = prev & ~DIRTY;
+
+            if(first.load(std::memory_order_relaxed) == 0)
+                first.store(now_ns(), std::memory_order_release);
+
+            published.fetch_add(1, std::memory_order_release);
+            futex_wake(&published);
+        }
+    }
+}
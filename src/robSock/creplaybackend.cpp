@@ -0,0 +1,152 @@
+/* creplaybackend.cpp */
+
+#include "robSock/creplaybackend.h"
+#include "robSock/clogger.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* divergences reported one by one, the rest are only counted */
+#define REPLAY_REPORT_MAX 10
+
+/* actions a backend is told about */
+static inline bool checked(int type)
+{
+    return type == ROBLOG_DRIVE || type == ROBLOG_END_LED ||
+           type == ROBLOG_RETURNING_LED || type == ROBLOG_VISITING_LED;
+}
+
+static void describe(char *buf, size_t size, int type, double lPow, double rPow, bool on)
+{
+    switch(type) {
+    case ROBLOG_DRIVE:
+        snprintf(buf, size, "DriveMotors(%.17g, %.17g)", lPow, rPow);
+        break;
+    case ROBLOG_END_LED:
+        snprintf(buf, size, "Finish");
+        break;
+    case ROBLOG_RETURNING_LED:
+        snprintf(buf, size, "SetReturningLed(%s)", on ? "On" : "Off");
+        break;
+    case ROBLOG_VISITING_LED:
+        snprintf(buf, size, "SetVisitingLed(%s)", on ? "On" : "Off");
+        break;
+    default:
+        snprintf(buf, size, "nothing");
+    }
+}
+
+CReplayBackend::CReplayBackend(const char *f)
+    : file(f), log(0), next(0), cycles(0), lastTime(0), nDiverged(0), firstDivergence(0)
+{
+    const char *env = getenv("ROBSOCK_REPLAY_STRICT");
+    strict = env != 0 && atoi(env) != 0;
+}
+
+CReplayBackend::~CReplayBackend()
+{
+    if(log == 0) return;
+
+    if(nDiverged == 0)
+        ROBSOCK_LOG("replay: %u cycles, the actions match the log", cycles);
+    else
+        ROBSOCK_LOG("replay: %u cycles, %u divergent actions, the first at time %u",
+                    cycles, nDiverged, firstDivergence);
+    delete log;
+}
+
+bool CReplayBackend::registerRobot(const char *name, int id, CSimParam &param)
+{
+    log = CRobLog::open(file.c_str());
+    if(log == 0) {
+        ROBSOCK_LOG("replay: %s is not a robot log", file);
+        return false;
+    }
+
+    const CRobLogHeader &h = log->header();
+    if(h.robotId != id)
+        ROBSOCK_LOG("replay: %s was recorded by robot %d (%s), replaying as robot %d (%s)",
+                    file, h.robotId, h.robotName, id, name);
+
+    log->params(param);
+    return true;
+}
+
+bool CReplayBackend::readSensors(CMeasures &m)
+{
+    if(log == 0) return false;
+    if(strict && nDiverged > 0) return false;
+
+    // recorded actions of the cycle just ended that the agent did not send
+    while(next < log->size() && (*log)[next].type != ROBLOG_MEASURES) {
+        if(checked((*log)[next].type)) diverged(&(*log)[next], 0, 0.0, 0.0, false);
+        next++;
+    }
+    if(next == log->size()) return false;
+    if(strict && nDiverged > 0) return false;
+
+    CRobLog::unpack((*log)[next++], m);
+    lastTime = m.time;
+    cycles++;
+    return true;
+}
+
+void CReplayBackend::check(int type, double lPow, double rPow, bool on)
+{
+    if(log == 0) return;
+
+    while(next < log->size() && !checked((*log)[next].type) && (*log)[next].type != ROBLOG_MEASURES)
+        next++;
+
+    const CRobLogRecord *r = next < log->size() ? &(*log)[next] : 0;
+    if(r != 0 && r->type == ROBLOG_MEASURES) r = 0;
+
+    // the agent is deterministic, so its powers match to the last bit
+    if(r != 0 && (int)r->type == type && r->motors.lPow == lPow && r->motors.rPow == rPow &&
+       ((r->flags & ROBLOG_ON) != 0) == on) {
+        next++;
+        return;
+    }
+
+    diverged(r, type, lPow, rPow, on);
+    if(r != 0) next++;      // taken as replaced by the agent's action
+}
+
+void CReplayBackend::diverged(const CRobLogRecord *r, int type, double lPow, double rPow, bool on)
+{
+    if(nDiverged++ == 0) firstDivergence = lastTime;
+    if(nDiverged > REPLAY_REPORT_MAX) return;
+
+    char sent[96], recorded[96];
+    describe(sent, sizeof(sent), type, lPow, rPow, on);
+    if(r != 0)
+        describe(recorded, sizeof(recorded), r->type, r->motors.lPow, r->motors.rPow,
+                 (r->flags & ROBLOG_ON) != 0);
+    else
+        describe(recorded, sizeof(recorded), 0, 0.0, 0.0, false);
+
+    ROBSOCK_LOG("replay: divergence at time %u: the agent sent %s, the log has %s",
+                lastTime, sent, recorded);
+    if(nDiverged == REPLAY_REPORT_MAX)
+        ROBSOCK_LOG("replay: further divergences are only counted");
+}
+
+void CReplayBackend::driveMotors(double lPow, double rPow)
+{
+    check(ROBLOG_DRIVE, lPow, rPow, false);
+}
+
+void CReplayBackend::setEndLed(bool on)
+{
+    check(ROBLOG_END_LED, 0.0, 0.0, on);
+}
+
+void CReplayBackend::setReturningLed(bool on)
+{
+    check(ROBLOG_RETURNING_LED, 0.0, 0.0, on);
+}
+
+void CReplayBackend::setVisitingLed(bool on)
+{
+    check(ROBLOG_VISITING_LED, 0.0, 0.0, on);
+}
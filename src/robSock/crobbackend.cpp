@@ -0,0 +1,34 @@
+/* crobbackend.cpp */
+
+#include "robSock/crobbackend.h"
+#include "robSock/creplaybackend.h"
+
+#include "simulator/csimbackend.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+
+static std::atomic<bool> inProcessDefault(false);
+
+void CRobBackend::setDefault(bool inProcess)
+{
+    inProcessDefault.store(inProcess);
+}
+
+CRobBackend *CRobBackend::create(const char *host)
+{
+    const char *replay = getenv("ROBSOCK_REPLAY");
+    if(replay != 0 && replay[0] != '\0')
+        return new CReplayBackend(replay);
+    if(host != 0 && strncmp(host, "replay:", 7) == 0)
+        return new CReplayBackend(host + 7);
+
+    if(host != 0 && strncmp(host, "sim:", 4) == 0)
+        return new CSimBackend(host[4] != '\0' ? host + 4 : 0);
+
+    const char *env = getenv("ROBSOCK_BACKEND");
+    bool inProcess = env != 0 ? strcmp(env, "sim") == 0 : inProcessDefault.load();
+    return inProcess ? new CSimBackend(0) : 0;
+}
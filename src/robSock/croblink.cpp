@@ -20,17 +20,48 @@
 // CRobLink implementation
 
 #include "robSock/croblink.h"
+#include "robSock/cnetthread.h"
+#include "robSock/crobbackend.h"
+#include "robSock/crobrecord.h"
+#include "robSock/clatency.h"
+#include "robSock/clogger.h"
+#include "robSock/ctrace.h"
 #include "robSock/structureparser.h"
 
 #include <iostream>
+#include <stdio.h>
+#include <time.h>
 
 using namespace std;
 
 #define MSGMAXSIZE (4096)
 
+/* registration retries, in milliseconds */
+#define REGISTER_FIRST_BACKOFF 50
+#define REGISTER_MAX_BACKOFF   1000
+
+int CRobLink::registerTimeout = 5000;
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void CRobLink::init_startup_times(void)
+{
+    registerStart = now_ns();
+    registerAttempts = 0;
+    registerMs = firstPacketMs = -1;
+    parseNs = 0;
+    lastTime = -1;
+    missed = 0;
+}
+
 
 /*!
- * Composes register message and sends it to server.
+ * Composes register message and registers in server.
  */
 void CRobLink::send_register_message(char *rob_name,int rob_id)
 {
@@ -39,12 +70,7 @@ void CRobLink::send_register_message(char *rob_name,int rob_id)
     const char fmt[] = "<Robot Name=\"%s\" Id=\"%d\"></Robot>";
 	sprintf(xml, fmt, rob_name, rob_id);
 
-    if(port.send_info(xml, strlen(xml)+1)!=true)
-    {
-        // cerr << "Failed Send Init" << endl;
-		Status=-1;
-		return;
-    }
+    register_robot(xml, strlen(xml)+1);
 }
 
 void CRobLink::send_register_message(char *rob_name,int rob_id, double irSensorAngles[])
@@ -61,16 +87,11 @@ void CRobLink::send_register_message(char *rob_name,int rob_id, double irSensorA
 
 	sprintf(xml+n,"</Robot>");
 
-    if(port.send_info(xml, strlen(xml)+1)!=true)
-    {
-        // cerr << "Failed Send Init" << endl;
-		Status=-1;
-		return;
-    }
+    register_robot(xml, strlen(xml)+1);
 }
 
 /*!
- * Composes register message and sends it to server.
+ * Composes register message and registers in server.
  */
 void CRobLink::send_robotbeacon_register_message(char *rob_name,int rob_id, double height)
 {
@@ -79,196 +100,389 @@ void CRobLink::send_robotbeacon_register_message(char *rob_name,int rob_id, doub
     const char fmt[] = "<RobotBeacon Name=\"%s\" Id=\"%d\" Height=\"%g\"/>";
 	sprintf(xml, fmt, rob_name, rob_id, height);
 
-    if(port.send_info(xml, strlen(xml)+1)!=true)
-    {
-        // cerr << "Failed Send Init" << endl;
-		Status=-1;
-		return;
-    }
+    register_robot(xml, strlen(xml)+1);
 }
 
 /*!
- * Waits for server reply and parses status, simulation parameters and
- * assigns the new UDP port to this robot.
+ * Sends the register message and waits for the server reply, resending
+ * it with exponential backoff until the server answers or the
+ * registration deadline expires.
  */
-void CRobLink::parse_server_reply(void)
+void CRobLink::register_robot(char *xml, int n)
 {
-    // get reply confirming or denying registration 
-    char xml[MSGMAXSIZE];
-    int recv_ret = port.recv_info(xml, MSGMAXSIZE);
-    if(recv_ret == -1)
+    long long deadline = registerStart + (long long)registerTimeout * 1000000LL;
+    int backoff = REGISTER_FIRST_BACKOFF;
+
+    registerAttempts = 0;
+    while(Status == 0)
     {
-        cerr << "Failed Init confirmation" << recv_ret << endl;
-		Status = -1;
-		return;
+        long long now = now_ns();
+        if(now >= deadline) {
+            ROBSOCK_LOG("Failed Init confirmation: no reply from server");
+            Status = -1;
+            return;
+        }
+
+        // a transport that is not up yet is retried like a lost message
+        bool sent = transport->send(xml, n);
+        registerAttempts++;
+
+        // wait for the reply until it is time to resend
+        long long resend = now + (long long)backoff * 1000000LL;
+        if(resend > deadline || (sent && transport->reliable())) resend = deadline;
+
+        for(;;)
+        {
+            long long left = resend - now_ns();
+            int ready = transport->wait(left > 0 ? (int)((left + 999999) / 1000000) : 0);
+            if(ready < 0) {
+                ROBSOCK_LOG("Failed Init confirmation");
+                Status = -1;
+                return;
+            }
+            if(ready == 0) break;
+
+            char reply[MSGMAXSIZE];
+            int recv_ret = transport->recv(reply, MSGMAXSIZE);
+            if(recv_ret <= 0) continue;
+
+            if(parse_server_reply(reply, recv_ret)) {
+                registerMs = (now_ns() - registerStart) / 1e6;
+                return;
+            }
+
+            // after a resend, a refusal may be for a duplicate of an
+            // attempt that the server accepted: keep waiting for its reply
+            if(registerAttempts == 1) {
+                ROBSOCK_LOG("Registration refused by server");
+                Status = -1;
+                return;
+            }
+        }
+
+        backoff *= 2;
+        if(backoff > REGISTER_MAX_BACKOFF) backoff = REGISTER_MAX_BACKOFF;
     }
-    //cerr << "XML=\"" << xml <<"\"\nXMLEND\n";
+}
 
-	/* set source of xml document */
-	QXmlInputSource source;
-	source.setData(QString(xml));
+/*!
+ * Parses the server reply: status, simulation parameters, and switches
+ * to the server endpoint assigned to this robot. Returns false if registration was refused.
+ */
+bool CRobLink::parse_server_reply(const char *xml, int n)
+{
+    //cerr << "XML=\"" << xml <<"\"\nXMLEND\n";
 
 	/* set parser handler */
     StructureParser handler(simParam.nBeacons);
 
-
 	/* parse xml document with handler */
-    QXmlSimpleReader reader;
+    XmlReader reader;
     reader.setContentHandler(&handler);
-    if( !reader.parse(source) ) {
-       Status=-1;
-       return;
-    }
+    if( !reader.parse(xml, n) )
+       return false;
 
 
     simParam = *(handler.getSimParam());
     simParam.showValues();
 
-    port.SetRemote(port.GetLastSender());
+    transport->acceptPeer();
+    return true;
+}
+
+/*!
+ * Registers with the in-process backend instead of a simulator.
+ */
+void CRobLink::register_backend(char *rob_name, int rob_id)
+{
+    registerAttempts = 1;
+    if(!backend->registerRobot(rob_name, rob_id, simParam)) {
+        ROBSOCK_LOG("Registration refused by the simulation backend");
+        Status = -1;
+        return;
+    }
+    registerMs = (now_ns() - registerStart) / 1e6;
+}
+
+/*!
+ * Records when the first sensor packet arrived and reports startup times.
+ */
+void CRobLink::note_first_packet(long long arrival)
+{
+    if(firstPacketMs >= 0) return;
+
+    firstPacketMs = (arrival - registerStart) / 1e6;
+    ROBSOCK_LOG("Registered in %.1f ms (%d attempt%s), first sensor packet after %.1f ms",
+                registerMs, registerAttempts, registerAttempts == 1 ? "" : "s", firstPacketMs);
+}
+
+/*!
+ * Counts the cycles skipped since the last Measures taken, the simulation
+ * time advances by one each cycle.
+ */
+void CRobLink::note_cycle(void)
+{
+    int t = measures.time;
+    if(lastTime >= 0 && t > lastTime + 1) missed += t - lastTime - 1;
+    lastTime = t;
 }
 
-CRobLink::CRobLink(char *rob_name, int rob_id, char *host) : measures(0), port(6000,host,0)
+CRobLink::CRobLink(char *rob_name, int rob_id, char *host) : measures(0), transport(0), backend(CRobBackend::create(host)), netThread(0),
+    recorder(0), latency(0), latencyDumped(false), robName(rob_name), robId(rob_id)
 {
     Status = 0;
+    init_startup_times();
 
-    if(!port.init())
+    if(backend) {
+        register_backend(rob_name, rob_id);
+        return;
+    }
+
+    transport = CTransport::create(host, 6000);
+    if(transport == 0 || !transport->init())
 	{
         // cerr << "Failed socket init" << endl;
 		Status=-1;
 		return;
     }
 
-    port.SetRcvTimeout(2,0);
+    transport->setRecvTimeout(2000);
 
     send_register_message(rob_name, rob_id);
     if( Status != 0 ) return;
 
-    parse_server_reply();
-    if( Status != 0 ) return;
-
     Status = 0;
 }
 
-CRobLink::CRobLink(char *rob_name, int rob_id, double irSensorAngles[], char *host) :  measures(0), port(6000,host,0)
+CRobLink::CRobLink(char *rob_name, int rob_id, double irSensorAngles[], char *host) : measures(0), transport(0), backend(CRobBackend::create(host)), netThread(0),
+    recorder(0), latency(0), latencyDumped(false), robName(rob_name), robId(rob_id)
 {
     Status = 0;
+    init_startup_times();
+
+    if(backend) {
+        register_backend(rob_name, rob_id);
+        return;
+    }
 
-    if(!port.init())
+    transport = CTransport::create(host, 6000);
+    if(transport == 0 || !transport->init())
 	{
         // cerr << "Failed socket init" << endl;
 		Status=-1;
 		return;
     }
 
-    port.SetRcvTimeout(2,0);
+    transport->setRecvTimeout(2000);
 
     send_register_message(rob_name,rob_id,irSensorAngles);
     if( Status != 0 ) return;
 
-    parse_server_reply();
-    if( Status != 0 ) return;
-
     Status = 0;
 }
 
-CRobLink::CRobLink(char *rob_name, int rob_id, double height, char *host) : measures(0), port(6000,host,0) 
+CRobLink::CRobLink(char *rob_name, int rob_id, double height, char *host) : measures(0), transport(0), backend(CRobBackend::create(host)), netThread(0),
+    recorder(0), latency(0), latencyDumped(false), robName(rob_name), robId(rob_id)
 {
     Status = 0;
+    init_startup_times();
+
+    if(backend) {
+        register_backend(rob_name, rob_id);
+        return;
+    }
 
-    if(!port.init())
+    transport = CTransport::create(host, 6000);
+    if(transport == 0 || !transport->init())
 	{
         // cerr << "Failed socket init" << endl;
 		Status=-1;
 		return;
     }
 
-    port.SetRcvTimeout(2,0);
+    transport->setRecvTimeout(2000);
 
     send_robotbeacon_register_message(rob_name, rob_id, height);
     if( Status != 0 ) return;
 
-    parse_server_reply();
-    if( Status != 0 ) return;
-
     Status = 0;
 }
 
 CRobLink::~CRobLink()
 {
+    dump_latency();
+    delete latency;
+    delete recorder;
+    delete netThread;
+    delete transport;
+    delete backend;
 }
 
-int CRobLink::ReadSensors()
+bool CRobLink::parse_measures(const char *xml, int len, unsigned int nBeacons, CMeasures &m)
 {
-	char xml[4096];
-    int n = port.recv_info(xml, 4096);
-	if (n == -1) return n;
-
-	//cerr << "ReadSensors: " << "\"" << xml << "\"";
-	
-	/* set source of xml document */
-	QXmlInputSource source;
-	source.setData(QString(xml));
-
 	/* set parser handler */
-    StructureParser handler(simParam.nBeacons);
-
-    //cerr << "ReadSensors: nBeacons=" << simParam.nBeacons << "\n";
+    StructureParser handler(nBeacons);
 
 	/* parse xml document with handler */
-    QXmlSimpleReader reader;
+    XmlReader reader;
     reader.setContentHandler(&handler);
-    reader.parse(source);
+    bool ok = reader.parse(xml, len);
 
 	///////////////////////////////////////////////////
-	measures = *(handler.getMeasures());  
-	//measures.showValues();
+	m = *(handler.getMeasures());
+	//m.showValues();
 	///////////////////////////////////////////////////
+
+    return ok;
+}
+
+int CRobLink::ReadSensors()
+{
+    ROBSOCK_TRACE_SCOPE("ReadSensors");
+
+    if(netThread) {
+        // same 2 second limit as the socket receive timeout
+        if(WaitSensors(2000) <= 0) return -1;
+        return netThread->lastSize();
+    }
+
+    if(backend) {
+        if(!backend->readSensors(measures)) return -1;
+        if(latency) latency->received(0, now_ns());
+        if(firstPacketMs < 0) firstPacketMs = (now_ns() - registerStart) / 1e6;
+        note_cycle();
+        if(recorder) recorder->measures(measures);
+        return 1;
+    }
+
+	char xml[4096];
+    int n = transport->recv(xml, 4096);
+	if (n == -1) return n;
+    if(latency) latency->received(transport->lastRecvTime(), now_ns());
+
+	//cerr << "ReadSensors: " << "\"" << xml << "\"";
+
+    long long parseStart = now_ns();
+    parse_measures(xml, n, simParam.nBeacons, measures);
+    long long parsed = now_ns();
+    parseNs = parsed - parseStart;
+    if(latency) latency->parsed();
+    note_first_packet(parsed);
+    note_cycle();
+    if(recorder) recorder->measures(measures);
 	
 //    for(unsigned int i=0; i<5;i++)
-//       if (measures.hearMessage[i]!=QString())
-//           printf("ReadSensors: Message From %d: \"%s\"\n", i, measures.hearMessage[i].latin1());
+//       if (!measures.hearMessage[i].empty())
+//           printf("ReadSensors: Message From %d: \"%s\"\n", i, measures.hearMessage[i].c_str());
 
     return n;
 }
 
+bool CRobLink::startNetThread(void)
+{
+    if(netThread) return true;
+    if(Status != 0 || backend) return false;
+
+    netThread = new CNetThread(transport, simParam.nBeacons);
+    if(!netThread->start()) {
+        delete netThread;
+        netThread = 0;
+        return false;
+    }
+    return true;
+}
+
+int CRobLink::PollSensors(void)
+{
+    if(!netThread) return -1;
+    int ret = netThread->poll(measures);
+    if(ret == 1) {
+        // parsed on the I/O thread, the cycle starts when the agent takes it
+        if(latency) latency->received(0, now_ns());
+        note_first_packet(netThread->firstPacketNs());
+        note_cycle();
+        if(recorder) recorder->measures(measures);
+    }
+    return ret;
+}
+
+int CRobLink::WaitSensors(int timeoutMs)
+{
+    if(!netThread) return -1;
+    int ret = netThread->wait(measures, timeoutMs);
+    if(ret == 1) {
+        // parsed on the I/O thread, the cycle starts when the agent takes it
+        if(latency) latency->received(0, now_ns());
+        note_first_packet(netThread->firstPacketNs());
+        note_cycle();
+        if(recorder) recorder->measures(measures);
+    }
+    return ret;
+}
+
+/*!
+ * Sends an action message, through the I/O thread when it owns the socket.
+ */
+void CRobLink::send_action(char *xml, int n)
+{
+    // sensor requests, messages and resets are not simulated in-process
+    if(backend) return;
+    if(netThread) {
+        // the thread sends them in order, or counts them lost
+        netThread->send(xml, n);
+        return;
+    }
+    transport->send(xml, n);
+}
+
 void CRobLink::requestGround()
 {
+    if(recorder) recorder->action(ROBLOG_REQUEST);
+
     char xml[128];
     const char fmt[] = "<Actions> <SensorRequests Ground=\"Yes\" /> </Actions>\n";
     unsigned int n = sprintf(xml,"%s", fmt);
-    port.send_info(xml,n+1);
+    send_action(xml,n+1);
     //cout << xml;
 }
 
 void CRobLink::requestCompass()
 {
+    if(recorder) recorder->action(ROBLOG_REQUEST);
+
     char xml[128];
     const char fmt[] = "<Actions> <SensorRequests Compass=\"Yes\" /> </Actions>\n";
     unsigned int n = sprintf(xml, "%s", fmt);
-    port.send_info(xml,n+1);
+    send_action(xml,n+1);
     //cout << xml;
 }
 
 void CRobLink::requestBeacon(int id)
 {
+    if(recorder) recorder->action(ROBLOG_REQUEST);
+
     char xml[128];
     const char fmt[] = "<Actions> <SensorRequests Beacon%d=\"Yes\" /> </Actions>\n";
     unsigned int n = sprintf(xml, fmt, id);
-    port.send_info(xml,n+1);
+    send_action(xml,n+1);
     //cout << xml;
 }
 
 void CRobLink::requestObstacle(int id)
 {
+    if(recorder) recorder->action(ROBLOG_REQUEST);
+
     char xml[128];
     const char fmt[] = "<Actions> <SensorRequests IRSensor%d=\"Yes\" /> </Actions>\n";
     unsigned int n = sprintf(xml, fmt, id);
-    port.send_info(xml,n+1);
+    send_action(xml,n+1);
     //cout << xml;
 }
 
 void CRobLink::requestSensors(int nReqs, va_list ap)
 {
+    if(recorder) recorder->action(ROBLOG_REQUEST);
+
     char *sensId;
     char xml[2048]="<Actions>\n\t<SensorRequests ";
 	int  s,n;
@@ -282,61 +496,153 @@ void CRobLink::requestSensors(int nReqs, va_list ap)
 
 	n+= sprintf(xml+n,"/>\n</Actions>");
 
-    port.send_info(xml,n+1);
+    send_action(xml,n+1);
 }
 
 void CRobLink::DriveMotors(double lPow,double rPow)
 {
+    ROBSOCK_TRACE_SCOPE("DriveMotors");
+    if(recorder) recorder->action(ROBLOG_DRIVE, lPow, rPow);
+
+    if(backend) {
+        backend->driveMotors(lPow, rPow);
+        if(latency) latency->sent();
+        return;
+    }
+
     char xml[1024];
     const char fmt[] = "<Actions LeftMotor=\"%g\" RightMotor=\"%g\"/>\n";
 	//sprintf(xml, fmt, lPow*1000.0+2000.5, rPow*1000.0+2000.5);
 	unsigned int n = sprintf(xml, fmt, lPow, rPow);
-    port.send_info(xml,n+1);
+    send_action(xml,n+1);
+    if(latency) latency->sent();
 	//cout << xml;
 }
 
 void CRobLink::Say(char *msg)
 {
+    if(recorder) recorder->action(ROBLOG_SAY);
+
     char xml[1024];
     const char fmt[] = "<Actions><Say><![CDATA[%s]]></Say></Actions>\n";
     //char *fmt = "<Actions> <Say Ground=\"Yes\"/> </Actions>";
     unsigned int n = sprintf(xml, fmt, msg);
-    port.send_info(xml,n+1);
+    send_action(xml,n+1);
 	//cout << xml;
 }
 
 void CRobLink::SetReturningLed(bool val)
 {
+    if(recorder) recorder->action(ROBLOG_RETURNING_LED, 0.0, 0.0, val);
+
+    if(backend) {
+        backend->setReturningLed(val);
+        if(latency) latency->sent();
+        return;
+    }
+
     char xml[128];
     const char fmt[] = "<Actions LeftMotor=\"%g\" RightMotor=\"%g\" ReturningLed=\"%s\"/>\n";
 	//sprintf(xml, fmt, lPow*1000.0+2000.5, rPow*1000.0+2000.5, "Off");
 	unsigned int n = sprintf(xml, fmt, 0.0, 0.0, (val?"On":"Off"));
-    port.send_info(xml,n+1);
+    send_action(xml,n+1);
+    if(latency) latency->sent();
 	//cout << xml;
 }
 
 void CRobLink::SetVisitingLed(bool val)
 {
+    if(recorder) recorder->action(ROBLOG_VISITING_LED, 0.0, 0.0, val);
+
+    if(backend) {
+        backend->setVisitingLed(val);
+        if(latency) latency->sent();
+        return;
+    }
+
     char xml[128];
     const char fmt[] = "<Actions LeftMotor=\"%g\" RightMotor=\"%g\" VisitingLed=\"%s\"/>\n";
 	//sprintf(xml, fmt, lPow*1000.0+2000.5, rPow*1000.0+2000.5, "Off");
 	unsigned int n = sprintf(xml, fmt, 0.0, 0.0, (val?"On":"Off"));
-    port.send_info(xml,n+1);
+    send_action(xml,n+1);
+    if(latency) latency->sent();
 	//cout << xml;
 }
 
 void CRobLink::Finish(void)
 {
-	char xml[] = "<Actions LeftMotor=\"0.0\" RightMotor=\"0.0\" EndLed=\"On\"/>\n";
-	unsigned int n = strlen(xml);
-	//cout << xml;
-    port.send_info(xml,n+1);
+    if(recorder) recorder->action(ROBLOG_END_LED, 0.0, 0.0, true);
+
+    if(backend)
+        backend->setEndLed(true);
+    else {
+        char xml[] = "<Actions LeftMotor=\"0.0\" RightMotor=\"0.0\" EndLed=\"On\"/>\n";
+        unsigned int n = strlen(xml);
+        //cout << xml;
+        send_action(xml,n+1);
+    }
+
+    if(latency) {
+        latency->sent();
+        dump_latency();
+    }
 }
 
 void CRobLink::Reset(void)
 {
+    if(recorder) recorder->action(ROBLOG_RESET);
+
     char xml[] = "<Actions Reset=\"On\"/>";
     unsigned int n = strlen(xml);
     //cout << xml
-    port.send_info(xml,n+1);
+    send_action(xml,n+1);
+}
+
+bool CRobLink::startRecording(const char *file)
+{
+    if(Status != 0) return false;
+
+    CRobRecorder *r = CRobRecorder::open(file, robName.c_str(), robId, simParam);
+    if(r == 0) return false;
+
+    delete recorder;
+    recorder = r;
+    return true;
+}
+
+void CRobLink::stopRecording(void)
+{
+    delete recorder;
+    recorder = 0;
+}
+
+bool CRobLink::enableLatencyStats(void)
+{
+    if(Status != 0) return false;
+    if(latency) return true;
+
+    // kernel receipt times are a bonus, not all transports have them
+    if(transport) transport->enableTimestamps();
+    latency = new CLatencyStats(simParam.cycleTime);
+    return true;
+}
+
+int CRobLink::addLatencyPhase(const char *name)
+{
+    return latency ? latency->addPhase(name) : -1;
+}
+
+void CRobLink::endLatencyPhase(int id)
+{
+    if(latency) latency->mark(id);
+}
+
+/*!
+ * Reports the latency statistics once, at Finish or when the robot is closed.
+ */
+void CRobLink::dump_latency(void)
+{
+    if(latency == 0 || latencyDumped) return;
+    latency->dump();
+    latencyDumped = true;
 }
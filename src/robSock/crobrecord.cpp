@@ -0,0 +1,228 @@
+/* crobrecord.cpp */
+
+#include "robSock/crobrecord.h"
+
+#include <string.h>
+#include <time.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* a cycle of measures and actions is a few hundred bytes */
+#define ROBLOG_BUFFER (64 * 1024)
+
+static long long clock_ns(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+CRobRecorder *CRobRecorder::open(const char *file, const char *name, int id, const CSimParam &param)
+{
+    FILE *f = fopen(file, "wb");
+    if(f == 0) return 0;
+    setvbuf(f, 0, _IOFBF, ROBLOG_BUFFER);
+
+    CRobLogHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, ROBLOG_MAGIC, sizeof(h.magic));
+    h.headerSize = sizeof(CRobLogHeader);
+    h.recordSize = sizeof(CRobLogRecord);
+    h.robotId = id;
+    strncpy(h.robotName, name, sizeof(h.robotName) - 1);
+    h.startTime = clock_ns(CLOCK_REALTIME);
+
+    h.obstNoise = param.obstNoise;
+    h.beaconNoise = param.beaconNoise;
+    h.motorsNoise = param.motorsNoise;
+    h.compassNoise = param.compassNoise;
+    h.beaconAperture = param.beaconAperture;
+    h.simTimeFinal = param.simTimeFinal;
+    h.keyTime = param.keyTime;
+    h.cycleTime = param.cycleTime;
+    h.nBeacons = param.nBeacons;
+    h.obstLatency = param.obstLatency;
+    h.beaconLatency = param.beaconLatency;
+    h.groundLatency = param.groundLatency;
+    h.compassLatency = param.compassLatency;
+    h.collisionLatency = param.collisionLatency;
+    h.requestable = (param.obstRequestable ? 1 : 0) | (param.beaconRequestable ? 2 : 0) |
+                    (param.groundRequestable ? 4 : 0) | (param.compassRequestable ? 8 : 0) |
+                    (param.collisionRequestable ? 16 : 0);
+    h.nReqPerCycle = param.nReqPerCycle;
+
+    if(fwrite(&h, sizeof(h), 1, f) != 1) {
+        fclose(f);
+        return 0;
+    }
+    return new CRobRecorder(f);
+}
+
+CRobRecorder::CRobRecorder(FILE *f) : fp(f), start(clock_ns(CLOCK_MONOTONIC)), lastTime(0)
+{
+}
+
+CRobRecorder::~CRobRecorder()
+{
+    fclose(fp);
+}
+
+void CRobRecorder::flush(void)
+{
+    fflush(fp);
+}
+
+void CRobRecorder::measures(const CMeasures &m)
+{
+    CRobLogRecord r;
+    memset(&r, 0, sizeof(r));
+    r.stamp = clock_ns(CLOCK_MONOTONIC) - start;
+    r.type = ROBLOG_MEASURES;
+    r.time = lastTime = m.time;
+    r.ground = m.ground;
+    r.score = m.score;
+
+    unsigned int flags = 0;
+    if(m.compassReady) flags |= ROBLOG_COMPASS_READY;
+    for(int i = 0; i < NUM_IR_SENSORS; i++)
+        if(m.IRSensorReady[i]) flags |= ROBLOG_IR_READY(i);
+    if(m.groundReady) flags |= ROBLOG_GROUND_READY;
+    if(m.collisionReady) flags |= ROBLOG_COLLISION_READY;
+    if(m.collision) flags |= ROBLOG_COLLISION;
+    if(m.lineSensorReady) flags |= ROBLOG_LINE_READY;
+    if(m.gpsReady) flags |= ROBLOG_GPS_READY;
+    if(m.gpsDirReady) flags |= ROBLOG_GPS_DIR_READY;
+    if(m.scoreReady) flags |= ROBLOG_SCORE_READY;
+    if(m.start) flags |= ROBLOG_START;
+    if(m.stop) flags |= ROBLOG_STOP;
+    if(m.endLed) flags |= ROBLOG_END;
+    if(m.returningLed) flags |= ROBLOG_RETURNING;
+    if(m.visitingLed) flags |= ROBLOG_VISITING;
+    r.flags = flags;
+
+    r.lineCount = m.lineSensor.size() < 16 ? m.lineSensor.size() : 16;
+    for(unsigned int i = 0; i < r.lineCount; i++)
+        if(m.lineSensor[i]) r.lineBits |= 1 << i;
+
+    r.sensors.compass = m.compass;
+    for(int i = 0; i < NUM_IR_SENSORS; i++)
+        r.sensors.ir[i] = m.IRSensor[i];
+    r.sensors.x = m.x;
+    r.sensors.y = m.y;
+    r.sensors.dir = m.dir;
+
+    fwrite(&r, sizeof(r), 1, fp);
+}
+
+void CRobRecorder::action(int type, double lPow, double rPow, bool on)
+{
+    CRobLogRecord r;
+    memset(&r, 0, sizeof(r));
+    r.stamp = clock_ns(CLOCK_MONOTONIC) - start;
+    r.type = type;
+    r.flags = on ? ROBLOG_ON : 0;
+    r.time = lastTime;
+    r.motors.lPow = lPow;
+    r.motors.rPow = rPow;
+
+    fwrite(&r, sizeof(r), 1, fp);
+}
+
+CRobLog *CRobLog::open(const char *file)
+{
+    int fd = ::open(file, O_RDONLY);
+    if(fd < 0) return 0;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CRobLogHeader)) {
+        close(fd);
+        return 0;
+    }
+
+    void *base = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED) return 0;
+
+    const CRobLogHeader *h = static_cast<const CRobLogHeader *>(base);
+    if(memcmp(h->magic, ROBLOG_MAGIC, sizeof(h->magic)) != 0 ||
+       h->headerSize != sizeof(CRobLogHeader) || h->recordSize != sizeof(CRobLogRecord)) {
+        munmap(base, st.st_size);
+        return 0;
+    }
+
+    CRobLog *log = new CRobLog;
+    log->base = base;
+    log->length = st.st_size;
+    log->hdr = h;
+    log->records = reinterpret_cast<const CRobLogRecord *>(h + 1);
+    // a record cut short by a crash is left out
+    log->count = (st.st_size - sizeof(CRobLogHeader)) / sizeof(CRobLogRecord);
+    madvise(base, st.st_size, MADV_SEQUENTIAL);
+    return log;
+}
+
+CRobLog::~CRobLog()
+{
+    munmap(base, length);
+}
+
+void CRobLog::params(CSimParam &param) const
+{
+    param.obstNoise = hdr->obstNoise;
+    param.beaconNoise = hdr->beaconNoise;
+    param.motorsNoise = hdr->motorsNoise;
+    param.compassNoise = hdr->compassNoise;
+    param.beaconAperture = hdr->beaconAperture;
+    param.simTimeFinal = hdr->simTimeFinal;
+    param.keyTime = hdr->keyTime;
+    param.cycleTime = hdr->cycleTime;
+    param.nBeacons = hdr->nBeacons;
+    param.obstLatency = hdr->obstLatency;
+    param.beaconLatency = hdr->beaconLatency;
+    param.groundLatency = hdr->groundLatency;
+    param.compassLatency = hdr->compassLatency;
+    param.collisionLatency = hdr->collisionLatency;
+    param.obstRequestable = (hdr->requestable & 1) != 0;
+    param.beaconRequestable = (hdr->requestable & 2) != 0;
+    param.groundRequestable = (hdr->requestable & 4) != 0;
+    param.compassRequestable = (hdr->requestable & 8) != 0;
+    param.collisionRequestable = (hdr->requestable & 16) != 0;
+    param.nReqPerCycle = hdr->nReqPerCycle;
+}
+
+void CRobLog::unpack(const CRobLogRecord &r, CMeasures &m)
+{
+    m.time = r.time;
+    m.ground = r.ground;
+    m.score = r.score;
+
+    m.compassReady = (r.flags & ROBLOG_COMPASS_READY) != 0;
+    for(int i = 0; i < NUM_IR_SENSORS; i++)
+        m.IRSensorReady[i] = (r.flags & ROBLOG_IR_READY(i)) != 0;
+    m.groundReady = (r.flags & ROBLOG_GROUND_READY) != 0;
+    m.collisionReady = (r.flags & ROBLOG_COLLISION_READY) != 0;
+    m.collision = (r.flags & ROBLOG_COLLISION) != 0;
+    m.lineSensorReady = (r.flags & ROBLOG_LINE_READY) != 0;
+    m.gpsReady = (r.flags & ROBLOG_GPS_READY) != 0;
+    m.gpsDirReady = (r.flags & ROBLOG_GPS_DIR_READY) != 0;
+    m.scoreReady = (r.flags & ROBLOG_SCORE_READY) != 0;
+    m.start = (r.flags & ROBLOG_START) != 0;
+    m.stop = (r.flags & ROBLOG_STOP) != 0;
+    m.endLed = (r.flags & ROBLOG_END) != 0;
+    m.returningLed = (r.flags & ROBLOG_RETURNING) != 0;
+    m.visitingLed = (r.flags & ROBLOG_VISITING) != 0;
+
+    m.lineSensor.resize(r.lineCount);
+    for(unsigned int i = 0; i < r.lineCount; i++)
+        m.lineSensor[i] = (r.lineBits >> i) & 1;
+
+    m.compass = r.sensors.compass;
+    for(int i = 0; i < NUM_IR_SENSORS; i++)
+        m.IRSensor[i] = r.sensors.ir[i];
+    m.x = r.sensors.x;
+    m.y = r.sensors.y;
+    m.dir = r.sensors.dir;
+}
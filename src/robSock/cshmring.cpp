@@ -0,0 +1,236 @@
+/* cshmring.cpp */
+
+#include "robSock/cshmring.h"
+
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#define SHM_MAGIC 0x43524d31    /* "CRM1" */
+#define SHM_SPIN  2000          /* polls before sleeping */
+
+static_assert(sizeof(std::atomic<int>) == sizeof(int), "futex word must be a plain int");
+
+/* the segment is shared between processes: no FUTEX_PRIVATE_FLAG */
+static int futex_wait(std::atomic<int> *addr, int expected, const struct timespec *timeout)
+{
+    return syscall(SYS_futex, reinterpret_cast<int *>(addr), FUTEX_WAIT, expected, timeout, NULL, 0);
+}
+
+static int futex_wake(std::atomic<int> *addr)
+{
+    return syscall(SYS_futex, reinterpret_cast<int *>(addr), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+/*
+ * Sleeps on word until ready() holds or timeoutMs expires.
+ * The waker bumps word and then reads sleepers, the sleeper registers in
+ * sleepers and then reads word: with sequentially consistent operations
+ * on both, either the waker sees the sleeper or the sleeper sees the bump.
+ */
+template<class Ready>
+static int sleep_until(std::atomic<int> &word, std::atomic<int> &sleepers, int timeoutMs, Ready ready)
+{
+    // spinning only pays off if the other side runs at the same time
+    static const int spin = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SHM_SPIN : 0;
+
+    for(int i = 0; i < spin; i++) {
+        if(ready()) return 1;
+        cpu_relax();
+    }
+
+    long long deadline = now_ns() + (long long)timeoutMs * 1000000LL;
+    int ret = 0;
+
+    sleepers.fetch_add(1);
+    for(;;) {
+        int seen = word.load();
+        if(ready()) { ret = 1; break; }
+
+        struct timespec ts, *tsp = NULL;
+        if(timeoutMs >= 0) {
+            long long left = deadline - now_ns();
+            if(left <= 0) break;
+            ts.tv_sec = left / 1000000000LL;
+            ts.tv_nsec = left % 1000000000LL;
+            tsp = &ts;
+        }
+        futex_wait(&word, seen, tsp);
+    }
+    sleepers.fetch_sub(1);
+    return ret;
+}
+
+static void wake(std::atomic<int> &word, std::atomic<int> &sleepers)
+{
+    word.fetch_add(1);
+    if(sleepers.load() > 0) futex_wake(&word);
+}
+
+void CShmRing::reset(void)
+{
+    head.store(0);
+    tail.store(0);
+}
+
+bool CShmRing::push(const void *buf, int n)
+{
+    if(n < 0 || n > SHM_MSGMAXSIZE) return false;
+
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if(h - tail.load(std::memory_order_acquire) >= SHM_RING_SLOTS) return false;
+
+    Slot &slot = slots[h % SHM_RING_SLOTS];
+    memcpy(slot.data, buf, n);
+    slot.len = n;
+    head.store(h + 1, std::memory_order_release);
+
+    wake(seq, sleepers);
+    return true;
+}
+
+int CShmRing::pop(void *buf, int size)
+{
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if(head.load(std::memory_order_acquire) == t) return -1;
+
+    Slot &slot = slots[t % SHM_RING_SLOTS];
+    int n = slot.len < size ? slot.len : size;
+    memcpy(buf, slot.data, n);
+    tail.store(t + 1, std::memory_order_release);
+    return n;
+}
+
+int CShmRing::wait(int timeoutMs)
+{
+    return sleep_until(seq, sleepers, timeoutMs, [this]() { return !empty(); });
+}
+
+CShmSegment *CShmSegment::create(const char *name)
+{
+    shm_unlink(name);
+
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if(fd < 0) return 0;
+
+    // a fresh segment reads as zeros: every slot free, every ring empty
+    if(ftruncate(fd, sizeof(CShmSegment)) < 0) {
+        close(fd);
+        shm_unlink(name);
+        return 0;
+    }
+
+    void *p = mmap(NULL, sizeof(CShmSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(p == MAP_FAILED) {
+        shm_unlink(name);
+        return 0;
+    }
+
+    CShmSegment *seg = static_cast<CShmSegment *>(p);
+    seg->size = sizeof(CShmSegment);
+    seg->magic.store(SHM_MAGIC, std::memory_order_release);
+    return seg;
+}
+
+CShmSegment *CShmSegment::open(const char *name)
+{
+    int fd = shm_open(name, O_RDWR, 0);
+    if(fd < 0) return 0;
+
+    struct stat st;
+    if(fstat(fd, &st) < 0 || st.st_size != (off_t)sizeof(CShmSegment)) {
+        close(fd);
+        return 0;
+    }
+
+    void *p = mmap(NULL, sizeof(CShmSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(p == MAP_FAILED) return 0;
+
+    CShmSegment *seg = static_cast<CShmSegment *>(p);
+    if(seg->magic.load(std::memory_order_acquire) != SHM_MAGIC || seg->size != sizeof(CShmSegment)) {
+        munmap(p, sizeof(CShmSegment));
+        return 0;
+    }
+    return seg;
+}
+
+void CShmSegment::release(CShmSegment *seg)
+{
+    if(seg) munmap(seg, sizeof(CShmSegment));
+}
+
+void CShmSegment::remove(const char *name)
+{
+    shm_unlink(name);
+}
+
+int CShmSegment::claim(void)
+{
+    for(int i = 0; i < SHM_MAX_ROBOTS; i++) {
+        int expected = SHM_SLOT_FREE;
+        if(robots[i].state.compare_exchange_strong(expected, SHM_SLOT_CLAIMED)) {
+            robots[i].pid.store(getpid());
+            ring();
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool CShmSegment::abandoned(int slot)
+{
+    CShmRobot &r = robots[slot];
+    int state = r.state.load();
+    if(state == SHM_SLOT_CLOSED) return true;
+    if(state == SHM_SLOT_FREE) return false;
+
+    // reclaim() clears the pid before freeing the slot, so a pid read here
+    // is the claimer's, or 0 while it has not stored it yet
+    int pid = r.pid.load();
+    return pid != 0 && kill(pid, 0) < 0 && errno == ESRCH;
+}
+
+void CShmSegment::reclaim(int slot)
+{
+    CShmRobot &r = robots[slot];
+    r.actions.reset();
+    r.measures.reset();
+    r.pid.store(0);
+    r.state.store(SHM_SLOT_FREE);
+}
+
+void CShmSegment::ring(void)
+{
+    wake(doorbell, sleepers);
+}
+
+int CShmSegment::waitDoorbell(int seen, int timeoutMs)
+{
+    sleep_until(doorbell, sleepers, timeoutMs, [this, seen]() { return doorbell.load() != seen; });
+    return doorbell.load();
+}
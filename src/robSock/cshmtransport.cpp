@@ -0,0 +1,81 @@
+/* cshmtransport.cpp */
+
+#include "robSock/cshmtransport.h"
+
+#include <unistd.h>
+
+CShmTransport::CShmTransport(const char *n)
+    : name(n), recvTimeoutMs(-1), segment(0), robot(0)
+{
+}
+
+CShmTransport::~CShmTransport()
+{
+    if(robot) {
+        robot->state.store(SHM_SLOT_CLOSED);
+        segment->ring();
+    }
+    CShmSegment::release(segment);
+}
+
+bool CShmTransport::init(void)
+{
+    if(name.empty()) return false;
+
+    // the simulator may not have created the segment yet, send() attaches
+    attach();
+    return true;
+}
+
+bool CShmTransport::attach(void)
+{
+    if(robot) return true;
+
+    if(segment == 0) {
+        segment = CShmSegment::open(name.c_str());
+        if(segment == 0) return false;
+    }
+
+    int slot = segment->claim();
+    if(slot < 0) return false;
+
+    robot = &segment->robots[slot];
+    return true;
+}
+
+bool CShmTransport::send(const void *buf, int n)
+{
+    if(!attach()) return false;
+    if(!robot->actions.push(buf, n)) return false;
+
+    segment->ring();
+    return true;
+}
+
+int CShmTransport::recv(void *buf, int size)
+{
+    if(wait(recvTimeoutMs) <= 0) return -1;
+    return robot->measures.pop(buf, size);
+}
+
+int CShmTransport::wait(int timeoutMs)
+{
+    // not attached yet: nothing can arrive, just let the time pass
+    if(robot == 0) {
+        if(timeoutMs > 0) usleep(timeoutMs * 1000);
+        return 0;
+    }
+    return robot->measures.wait(timeoutMs);
+}
+
+int CShmTransport::drain(char *buf, int size, unsigned int *superseded)
+{
+    if(robot == 0) return -1;
+
+    int newest = 0, n = 0;
+    for(int len; (len = robot->measures.pop(buf, size)) >= 0; n++)
+        newest = len;
+
+    if(n > 1 && superseded) *superseded += n - 1;
+    return newest;
+}
@@ -0,0 +1,105 @@
+/* ctrace.cpp */
+
+#include "robSock/ctrace.h"
+#include "robSock/clogger.h"
+
+#ifdef ROBSOCK_TRACE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+#include <sys/syscall.h>
+
+struct CTraceEvent
+{
+    const char *name;
+    long long start, end;
+};
+
+/* written by its thread only, read by flush() */
+struct CTraceRing
+{
+    int tid;
+    std::atomic<uint64_t> count;
+    CTraceEvent events[TRACE_RING_EVENTS];
+};
+
+static std::mutex ringsMutex;
+static std::vector<CTraceRing *> rings;     // kept after their thread ends
+static std::string traceFile;
+static thread_local CTraceRing *ring = 0;
+
+static bool startTrace(void)
+{
+    const char *env = getenv("ROBSOCK_TRACE");
+    if(env == 0 || env[0] == '\0') return false;
+
+    traceFile = env;
+    atexit(CTrace::flush);
+    return true;
+}
+
+bool CTrace::on = startTrace();
+
+void CTrace::event(const char *name, long long start, long long end)
+{
+    if(ring == 0) {
+        ring = new CTraceRing;
+        ring->tid = syscall(SYS_gettid);
+        ring->count.store(0, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        rings.push_back(ring);
+    }
+
+    uint64_t n = ring->count.load(std::memory_order_relaxed);
+    CTraceEvent &e = ring->events[n % TRACE_RING_EVENTS];
+    e.name = name;
+    e.start = start;
+    e.end = end;
+    ring->count.store(n + 1, std::memory_order_release);
+}
+
+void CTrace::flush(void)
+{
+    static std::once_flag flushed;
+    std::call_once(flushed, []() {
+        FILE *f = fopen(traceFile.c_str(), "w");
+        if(f == 0) {
+            ROBSOCK_LOG("robSock: can not write the trace to %s: %s", traceFile, strerror(errno));
+            return;
+        }
+
+        int pid = getpid();
+        bool first = true;
+        fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        for(unsigned int r = 0; r < rings.size(); r++) {
+            uint64_t n = rings[r]->count.load(std::memory_order_acquire);
+            uint64_t from = n > TRACE_RING_EVENTS ? n - TRACE_RING_EVENTS : 0;
+
+            for(uint64_t i = from; i < n; i++) {
+                const CTraceEvent &e = rings[r]->events[i % TRACE_RING_EVENTS];
+                fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d}",
+                        first ? "" : ",\n", e.name, e.start / 1e3, (e.end - e.start) / 1e3,
+                        pid, rings[r]->tid);
+                first = false;
+            }
+        }
+
+        fprintf(f, "\n]}\n");
+        fclose(f);
+    });
+}
+
+#endif
@@ -0,0 +1,94 @@
+/* ctransport.cpp */
+
+#include "robSock/ctransport.h"
+#include "robSock/cunixtransport.h"
+#include "robSock/cshmtransport.h"
+
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#define TRANSPORT_BATCH   8
+#define TRANSPORT_MSGSIZE 4096
+
+/* a path that fits in sun_path with its terminating zero */
+static bool validSocketPath(const char *path)
+{
+    size_t n = strlen(path);
+    return n > 0 && n < sizeof(((struct sockaddr_un *)0)->sun_path);
+}
+
+CTransport *CTransport::create(const char *host, int port)
+{
+    if(strncmp(host, "unix:", 5) == 0)
+        return validSocketPath(host + 5) ? new CUnixTransport(host + 5, SOCK_DGRAM) : 0;
+    if(strncmp(host, "unixseq:", 8) == 0)
+        return validSocketPath(host + 8) ? new CUnixTransport(host + 8, SOCK_SEQPACKET) : 0;
+    if(strncmp(host, "shm:", 4) == 0)
+        return host[4] != '\0' ? new CShmTransport(host + 4) : 0;
+
+    char hostbuf[256];
+    if(host[0] == '\0' || strlen(host) >= sizeof(hostbuf)) return 0;
+    strcpy(hostbuf, host);
+    return new CUdpTransport(port, hostbuf);
+}
+
+/* the kernel stamps datagrams on CLOCK_REALTIME, the rest of robSock
+ * times on CLOCK_MONOTONIC */
+long long CUdpTransport::lastRecvTime(void)
+{
+    struct timespec stamp, real, mono;
+    if(!port.GetLastTimestamp(&stamp)) return 0;
+
+    clock_gettime(CLOCK_REALTIME, &real);
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    long long age = (real.tv_sec - stamp.tv_sec) * 1000000000LL + (real.tv_nsec - stamp.tv_nsec);
+    return mono.tv_sec * 1000000000LL + mono.tv_nsec - age;
+}
+
+int CTransport::drainSocket(int fd, char *buf, int size, unsigned int *superseded,
+                            bool connected)
+{
+    char bufs[TRANSPORT_BATCH][TRANSPORT_MSGSIZE];
+    struct mmsghdr msgs[TRANSPORT_BATCH];
+    struct iovec iovs[TRANSPORT_BATCH];
+    int newest = 0, total = 0;
+
+    for(int i = 0; i < TRANSPORT_BATCH; i++) {
+        iovs[i].iov_base = bufs[i];
+        iovs[i].iov_len = TRANSPORT_MSGSIZE;
+        memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    // keep reading while whole batches come in
+    for(;;) {
+        int n = recvmmsg(fd, msgs, TRANSPORT_BATCH, MSG_DONTWAIT, NULL);
+        if(n < 0) {
+            if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) break;
+            return -1;
+        }
+        if(n == 0) {
+            if(connected && total == 0) return -1;
+            break;
+        }
+
+        // empty datagrams carry nothing, on a connection they mean it was closed
+        int last = n - 1;
+        while(last >= 0 && msgs[last].msg_len == 0) last--;
+        if(last < n - 1 && connected) return -1;
+
+        if(last >= 0) {
+            total += last + 1;
+            newest = msgs[last].msg_len;
+            if(newest > size) newest = size;
+            memcpy(buf, bufs[last], newest);
+        }
+
+        if(n < TRANSPORT_BATCH) break;
+    }
+
+    if(total > 1 && superseded) *superseded += total - 1;
+    return newest;
+}
@@ -0,0 +1,136 @@
+/* cunixtransport.cpp */
+
+#include "robSock/cunixtransport.h"
+
+#include <string.h>
+#include <errno.h>
+
+#include <unistd.h>
+#include <poll.h>
+
+CUnixTransport::CUnixTransport(const char *path, int t)
+    : type(t), socketfd(-1), connected(false), recvTimeoutMs(0),
+      remoteLen(0), lastSenderLen(0)
+{
+    memset(&remote, 0, sizeof(remote));
+    memset(&lastSender, 0, sizeof(lastSender));
+    remote.sun_family = AF_UNIX;
+    strncpy(remote.sun_path, path, sizeof(remote.sun_path) - 1);
+    remoteLen = sizeof(remote);
+}
+
+CUnixTransport::~CUnixTransport()
+{
+    if(socketfd >= 0) close(socketfd);
+}
+
+bool CUnixTransport::init(void)
+{
+    if(strlen(remote.sun_path) == 0) return false;
+
+    socketfd = socket(AF_UNIX, type | SOCK_CLOEXEC, 0);
+    if(socketfd < 0) return false;
+
+    if(type == SOCK_DGRAM) {
+        // autobind to an abstract address, so the server can reply
+        struct sockaddr_un local;
+        memset(&local, 0, sizeof(local));
+        local.sun_family = AF_UNIX;
+        if(bind(socketfd, (struct sockaddr *)&local, sizeof(sa_family_t)) < 0) {
+            close(socketfd);
+            socketfd = -1;
+            return false;
+        }
+        connected = true;
+        return true;
+    }
+
+    // the server may not be listening yet, send() connects
+    connectServer();
+    return true;
+}
+
+bool CUnixTransport::connectServer(void)
+{
+    if(connected) return true;
+
+    if(connect(socketfd, (struct sockaddr *)&remote, remoteLen) == 0) {
+        connected = true;
+        return true;
+    }
+
+    // a failed connect may leave the socket unusable, start over
+    close(socketfd);
+    socketfd = socket(AF_UNIX, type | SOCK_CLOEXEC, 0);
+    if(socketfd >= 0 && recvTimeoutMs > 0) setRecvTimeout(recvTimeoutMs);
+    return false;
+}
+
+bool CUnixTransport::send(const void *buf, int n)
+{
+    if(socketfd < 0) return false;
+
+    ssize_t ret;
+    if(type == SOCK_DGRAM)
+        ret = sendto(socketfd, buf, n, 0, (struct sockaddr *)&remote, remoteLen);
+    else {
+        if(!connectServer()) return false;
+        ret = ::send(socketfd, buf, n, MSG_NOSIGNAL);
+    }
+    return ret == n;
+}
+
+int CUnixTransport::recv(void *buf, int size)
+{
+    if(socketfd < 0 || !connected) return -1;
+
+    lastSenderLen = sizeof(lastSender);
+    ssize_t n = recvfrom(socketfd, buf, size, 0, (struct sockaddr *)&lastSender, &lastSenderLen);
+
+    // an orderly shutdown of the connection is an error for the robot
+    if(n == 0 && type == SOCK_SEQPACKET) return -1;
+    return n;
+}
+
+int CUnixTransport::wait(int timeoutMs)
+{
+    // not connected yet: nothing can arrive, just let the time pass
+    if(socketfd < 0 || !connected) {
+        if(timeoutMs > 0) usleep(timeoutMs * 1000);
+        return 0;
+    }
+
+    struct pollfd pfd;
+    pfd.fd = socketfd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int n = poll(&pfd, 1, timeoutMs);
+    if(n < 0) return errno == EINTR ? 0 : -1;
+    return n > 0 ? 1 : 0;
+}
+
+bool CUnixTransport::setRecvTimeout(int ms)
+{
+    recvTimeoutMs = ms;
+    if(socketfd < 0) return false;
+
+    struct timeval timeout;
+    timeout.tv_sec = ms / 1000;
+    timeout.tv_usec = (ms % 1000) * 1000;
+    return setsockopt(socketfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0;
+}
+
+int CUnixTransport::drain(char *buf, int size, unsigned int *superseded)
+{
+    if(socketfd < 0 || !connected) return -1;
+    return drainSocket(socketfd, buf, size, superseded, type == SOCK_SEQPACKET);
+}
+
+void CUnixTransport::acceptPeer(void)
+{
+    if(type != SOCK_DGRAM || lastSenderLen <= sizeof(sa_family_t)) return;
+
+    remote = lastSender;
+    remoteLen = lastSenderLen;
+}
@@ -0,0 +1,105 @@
+/* logdump.cpp
+ *
+ * Turns a log written with ROBSOCK_LOG_FILE back into text.
+ */
+
+#include "robSock/clogger.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+struct Format
+{
+    std::string file, format;
+    long long line;
+};
+
+static void usage(void)
+{
+    fprintf(stderr, "SYNOPSIS: logdump [--where] logfile\n"
+                    "  --where  prefix each message with the source line that logged it\n");
+}
+
+int main(int argc, char **argv)
+{
+    bool where = false;
+    const char *fileName = 0;
+
+    for(int a = 1; a < argc; a++) {
+        if(strcmp(argv[a], "--where") == 0)
+            where = true;
+        else if(fileName == 0)
+            fileName = argv[a];
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if(fileName == 0) {
+        usage();
+        return 1;
+    }
+
+    FILE *f = fopen(fileName, "rb");
+    if(f == 0) {
+        perror(fileName);
+        return 1;
+    }
+
+    char magic[8];
+    if(fread(magic, sizeof(magic), 1, f) != 1 || memcmp(magic, LOG_MAGIC, sizeof(magic)) != 0) {
+        fprintf(stderr, "logdump: %s is not a robSock log\n", fileName);
+        return 1;
+    }
+
+    std::map<uint32_t, Format> formats;
+    std::vector<char> text;
+    CLogRecord r;
+
+    while(fread(&r, sizeof(r), 1, f) == 1) {
+        text.assign(r.nText * sizeof(CLogRecord) + 1, '\0');
+        if(r.nText && fread(&text[0], sizeof(CLogRecord), r.nText, f) != r.nText) {
+            fprintf(stderr, "logdump: %s ends in the middle of a message\n", fileName);
+            break;
+        }
+
+        if(r.id == LOG_FORMAT_DEF) {
+            Format &def = formats[(uint32_t)r.args[0].u];
+            def.file = &text[0];
+            def.format = &text[def.file.size() + 1];
+            def.line = r.args[1].i;
+            continue;
+        }
+        if(r.id == LOG_DROPPED) {
+            printf("logdump: %llu messages lost here, the log ring was full\n",
+                   (unsigned long long)r.args[0].u);
+            continue;
+        }
+
+        std::map<uint32_t, Format>::const_iterator it = formats.find(r.id);
+        if(it == formats.end()) {
+            fprintf(stderr, "logdump: message with the unknown format %u\n", r.id);
+            continue;
+        }
+
+        time_t sec = r.stamp / 1000000000LL;
+        struct tm tm;
+        localtime_r(&sec, &tm);
+        char stamp[32];
+        strftime(stamp, sizeof(stamp), "%H:%M:%S", &tm);
+        printf("%s.%06lld ", stamp, (long long)(r.stamp % 1000000000LL) / 1000);
+        if(where) printf("%s:%lld: ", it->second.file.c_str(), it->second.line);
+
+        std::string line = CLogger::format(it->second.format.c_str(), r, &text[0]);
+        fputs(line.c_str(), stdout);
+        if(line.empty() || line[line.size() - 1] != '\n') putchar('\n');
+    }
+
+    fclose(f);
+    return 0;
+}
@@ -47,6 +47,7 @@ Port::Port()
 #endif
 	strcpy(host, "") ;
 	localport=0;
+	timestamps=false;
 }
 
 Port::Port(int lPort)
@@ -61,6 +62,7 @@ Port::Port(int lPort)
 #endif
 	strcpy(host, "") ;
 	localport=lPort;
+	timestamps=false;
 }
 
 /**
@@ -91,6 +93,7 @@ Port::Port(int port, char *RemoteHost,int lPort)
 	    portnum = port ;
 	    localport=lPort;
 	}
+	timestamps=false;
 	//fprintf(stderr,"remote host = \"%s\" port = %d\n",host,portnum);
 }
 
@@ -149,24 +152,24 @@ bool Port::SetRcvTimeout(int sec, int usec)
 
 bool Port::init_remote(void)
 {
-	struct hostent		*host_ent ;
-	struct in_addr		*addr_ptr ;
+	struct addrinfo		hints, *res ;
+	char			service[16] ;
 
-	if ((host_ent = (struct hostent *)gethostbyname(host)) == NULL) {
-		/* Check if a numeric address */
-		if (inet_addr(host) == INADDR_NONE)
-            return false ;
-	}
-	else{
-		addr_ptr = (struct in_addr *) *host_ent->h_addr_list ;
-		strcpy(host,inet_ntoa(*addr_ptr)) ;
-	}
+	memset(&hints, 0, sizeof(hints)) ;
+	hints.ai_family   = AF_INET ;
+	hints.ai_socktype = SOCK_DGRAM ;
+	sprintf(service, "%d", portnum) ;
+
+	/* numeric addresses are resolved without any lookup */
+	if (getaddrinfo(host, service, &hints, &res) != 0)
+		return false ;
 
 	/* Fill in the structure with the address of the remote UDP socket  */
 	memset((char *) &remote_addr, 0, sizeof(remote_addr)) ;
-	remote_addr.sin_family		= AF_INET ;
-	remote_addr.sin_addr.s_addr	= inet_addr(host) ;
-	remote_addr.sin_port		= htons(portnum) ;
+	memcpy(&remote_addr, res->ai_addr, sizeof(remote_addr)) ;
+	inet_ntop(AF_INET, &remote_addr.sin_addr, host, sizeof(host)) ;
+
+	freeaddrinfo(res) ;
 
     return true;
 }
@@ -199,6 +202,28 @@ bool Port::init(bool blocking)
     return true;
 }
 
+/*!
+ * Waits up to timeoutMs for a datagram to be available.
+ * Returns 1 if one is ready, 0 on timeout, -1 on error.
+ */
+int Port::wait_info(int timeoutMs)
+{
+	struct pollfd pfd;
+	pfd.fd = socketfd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+
+#ifndef MicWindows
+	int n = poll(&pfd, 1, timeoutMs);
+	if (n < 0 && errno == EINTR) return 0;
+#else
+	int n = WSAPoll(&pfd, 1, timeoutMs);
+#endif
+
+	if (n < 0) return -1;
+	return n > 0 ? 1 : 0;
+}
+
 bool Port::send_info(void *buf, int bufSize)
 {
 
@@ -216,11 +241,67 @@ bool Port::send_info(void *buf, int bufSize)
     return true;
 }
 
+/*!
+ * Asks the kernel to stamp every received message with its arrival time
+ * (SO_TIMESTAMPNS), read back with GetLastTimestamp.
+ */
+bool Port::EnableTimestamps(void)
+{
+#if !defined(MicWindows) && defined(SO_TIMESTAMPNS)
+	int on = 1;
+	if (setsockopt(socketfd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) < 0)
+		return false;
+	timestamps = true;
+	last_stamp.tv_sec = last_stamp.tv_nsec = 0;
+	return true;
+#else
+	return false;
+#endif
+}
+
+/*!
+ * Gets when the last received message reached the kernel.
+ * Returns false if timestamps are not enabled or it had none.
+ */
+bool Port::GetLastTimestamp(struct timespec *ts)
+{
+	if (!timestamps || (last_stamp.tv_sec == 0 && last_stamp.tv_nsec == 0))
+		return false;
+	*ts = last_stamp;
+	return true;
+}
+
 int Port::recv_info(void *buf, int bufSize)
 {
 	int n;
 	size_t  lastsenderlen ;
 
+#if !defined(MicWindows) && defined(SO_TIMESTAMPNS)
+	if (timestamps) {
+		char control[CMSG_SPACE(sizeof(struct timespec))];
+		struct iovec iov;
+		struct msghdr msg;
+
+		iov.iov_base = buf;
+		iov.iov_len = bufSize;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_name = &lastsender_addr;
+		msg.msg_namelen = sizeof(lastsender_addr);
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		n = recvmsg(socketfd, &msg, 0);
+
+		last_stamp.tv_sec = last_stamp.tv_nsec = 0;
+		for (struct cmsghdr *c = CMSG_FIRSTHDR(&msg); n >= 0 && c != NULL; c = CMSG_NXTHDR(&msg, c))
+			if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS)
+				memcpy(&last_stamp, CMSG_DATA(c), sizeof(last_stamp));
+		return n;
+	}
+#endif
+
 	lastsenderlen = sizeof(lastsender_addr) ;
 #ifndef MicWindows
 	n = recvfrom(socketfd, (char *)(buf), bufSize, 0,
@@ -22,53 +22,56 @@ $Id: structureparser.cpp,v 1.5 2005/02/17 11:09:23 lau Exp $
 */
 
 #include "robSock/structureparser.h"
+#include "robSock/clogger.h"
 
 #include <iostream>
-#include <qstring.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 using std::cerr;
+using std::string;
 
-static bool readAttributeInt(const QXmlAttributes &attr, const char *attrName, int *var)
+static bool readAttributeInt(const XmlAttributes &attr, const char *attrName, int *var)
 {
-	const QString &attrVal = attr.value(QString(attrName));
-	if (!attrVal.isNull()) {
-		*var = attrVal.toInt();
+	const string *attrVal = attr.value(attrName);
+	if (attrVal != 0) {
+		*var = atoi(attrVal->c_str());
 		return true;
 	}
 	return false;
 }
 
-static bool readAttributeUInt(const QXmlAttributes &attr, const char *attrName, unsigned int *var)
+static bool readAttributeUInt(const XmlAttributes &attr, const char *attrName, unsigned int *var)
 {
-	const QString &attrVal = attr.value(QString(attrName));
-	if (!attrVal.isNull()) {
-		*var = attrVal.toUInt();
+	const string *attrVal = attr.value(attrName);
+	if (attrVal != 0) {
+		*var = (unsigned int)strtoul(attrVal->c_str(), 0, 10);
 		return true;
 	}
 	return false;
 }
 
-static bool readAttributeDouble(const QXmlAttributes &attr, const char *attrName, double *var)
+static bool readAttributeDouble(const XmlAttributes &attr, const char *attrName, double *var)
 {
-	const QString &attrVal = attr.value(QString(attrName));
-	if (!attrVal.isNull()) {
-		*var = attrVal.toDouble();
+	const string *attrVal = attr.value(attrName);
+	if (attrVal != 0) {
+		*var = strtod(attrVal->c_str(), 0);
 		return true;
 	}
 	return false;
 }
 
-static bool readAttributeBool(const QXmlAttributes &attr, const char *attrName, bool *var,
+static bool readAttributeBool(const XmlAttributes &attr, const char *attrName, bool *var,
 		              const char *strTrue, const char *strFalse)
 {
-	const QString &attrVal = attr.value(QString(attrName));
-	if (!attrVal.isNull())
+	const string *attrVal = attr.value(attrName);
+	if (attrVal != 0)
 	{
-		if (attrVal == strTrue ) {
+		if (*attrVal == strTrue ) {
 			*var = true;
 			return true;
 		}
-		else if (attrVal == strFalse) {
+		else if (*attrVal == strFalse) {
 			*var = false;
 		        return true;
 	        }
@@ -77,12 +80,12 @@ static bool readAttributeBool(const QXmlAttributes &attr, const char *attrName,
 	return false;
 }
 
-static bool readAttributeBoolOnOff(const QXmlAttributes &attr, const char *attrName, bool *var)
+static bool readAttributeBoolOnOff(const XmlAttributes &attr, const char *attrName, bool *var)
 {
 	return readAttributeBool(attr, attrName, var, "On", "Off");
 }
 
-static bool readAttributeBoolYesNo(const QXmlAttributes &attr, const char *attrName, bool *var)
+static bool readAttributeBoolYesNo(const XmlAttributes &attr, const char *attrName, bool *var)
 {
 	return readAttributeBool(attr, attrName, var, "Yes", "No");
 }
@@ -99,26 +102,25 @@ bool StructureParser::endDocument()
 	return TRUE;
 }
 
-bool StructureParser::startElement(const QString&, const QString&,
-                                   const QString& qName,
-                                   const QXmlAttributes& attr)
+bool StructureParser::startElement(const string& qName,
+                                   const XmlAttributes& attr)
 {
     //cout.form("-------------------- startElement(...) called\n");
 
 	//cerr << "StartElement qName=" << qName << "\n";
 
 	/* process begin tag */
-	const QString &tag = qName;
+	const string &tag = qName;
         activeTag=tag;
 	if (tag == "Reply")
 	{
 		/* process attributes */
-		const QString &status = attr.value(QString("Status"));
-		if (!status.isNull())
+		const string *status = attr.value("Status");
+		if (status != 0)
 		{
-			if (status == "Ok")
+			if (*status == "Ok")
 				return true;
-			else if (status == "Refused")
+			else if (*status == "Refused")
 				return false;
 		}
 		return false;
@@ -175,9 +177,9 @@ bool StructureParser::startElement(const QString&, const QString&,
 	else if (tag == "IRSensor")
 	{
 		/* process attributes */
-		const QString &idStr = attr.value(QString("Id"));
-		if (!idStr.isNull()) {
-			unsigned int id = idStr.toUInt();
+		const string *idStr = attr.value("Id");
+		if (idStr != 0) {
+			unsigned int id = (unsigned int)strtoul(idStr->c_str(), 0, 10);
 
 			if(id < NUM_IR_SENSORS) {
 			    measures.IRSensorReady[id] = readAttributeDouble(attr, "Value", &measures.IRSensor[id]);
@@ -191,21 +193,21 @@ bool StructureParser::startElement(const QString&, const QString&,
 	else if (tag == "BeaconSensor")
 	{
 		/* process attributes */
-		const QString &idStr = attr.value(QString("Id"));
-		if (!idStr.isNull()) {
-			unsigned int id = idStr.toUInt();
+		const string *idStr = attr.value("Id");
+		if (idStr != 0) {
+			unsigned int id = (unsigned int)strtoul(idStr->c_str(), 0, 10);
 			//cerr << "tagBeaconSensor got " << id;
 			if(id<measures.beaconReady.size()) {
 			    measures.beaconReady[id]=true;
-		            const QString &valueStr = attr.value(QString("Value"));
-			    if(!valueStr.isNull()) {
-			        if(valueStr=="NotVisible") {
+		            const string *valueStr = attr.value("Value");
+			    if(valueStr != 0) {
+			        if(*valueStr=="NotVisible") {
 			            //cerr << "not visible";
 			            measures.beacon[id].beaconVisible = false;
 			            measures.beacon[id].beaconDir = 0.0;
 			        }
 			        else{
-			            measures.beacon[id].beaconDir = valueStr.toDouble();
+			            measures.beacon[id].beaconDir = strtod(valueStr->c_str(), 0);
 			            measures.beacon[id].beaconVisible = true;
 			            //cerr << " at " << measures.beacon[id].beaconDir;
 			        }
@@ -229,9 +231,9 @@ bool StructureParser::startElement(const QString&, const QString&,
 		/* process attributes */
 		measures.lineSensorReady = true;
 		measures.lineSensor.clear();
-		const QString &attrVal = attr.value(QString("Value"));
+		const string *attrVal = attr.value("Value");
 		for(int i=0;i<N_LINE_ELEMENTS;i++) {
-		   measures.lineSensor.push_back(attrVal.at(i) == QChar('1'));
+		   measures.lineSensor.push_back(attrVal != 0 && i < (int)attrVal->size() && (*attrVal)[i] == '1');
 	    }
 	}
 	else if (tag == "Leds")
@@ -258,20 +260,22 @@ bool StructureParser::startElement(const QString&, const QString&,
     }
 	else if (tag == "Row")
     {
-        int row;
+        int row = -1;
 		readAttributeInt(attr, "Pos", &row);
-		const QString &pattern = attr.value(QString("Pattern"));
-        const QChar *spec = pattern.data();
+		const string *pattern = attr.value("Pattern");
+        if(pattern == 0) return true;
+        if(row < 0 || row >= CELLROWS*2-1) return true; // not a row of a wall maze
+        const char *spec = pattern->c_str();
         int col=0;
-		while (!spec->isNull()) {
+		while (*spec != '\0' && col < CELLCOLS*3) {
             if(row % 2 == 0) { // only vertical walls are allowed here
-                if(spec->toLatin1()=='|') {
+                if(*spec=='|') {
                     map[row][(col+1)/3*2-1] = '|';
                 }
             }
             else {// only horizontal walls are allowed at odd rows
                 if(col % 3 == 0) { // if there is a wall at this collumn then there must also be a wall in the next one
-                    if(spec->toLatin1()=='-') {
+                    if(*spec=='-') {
                         map[row][col/3*2] = '-';
                     }
 
@@ -284,7 +288,7 @@ bool StructureParser::startElement(const QString&, const QString&,
     return true;
 }
 
-bool StructureParser::endElement( const QString&, const QString&, const QString& qName)
+bool StructureParser::endElement(const string& qName)
 {
     //cout.form("-------------------- endElement(...) called\n");
 
@@ -292,7 +296,7 @@ bool StructureParser::endElement( const QString&, const QString&, const QString&
 
 
 	/* process end tag */
-	const QString &tag = qName;
+	const string &tag = qName;
         activeTag="";
 	if (tag == "Reply")
 	{
@@ -306,7 +310,7 @@ bool StructureParser::endElement( const QString&, const QString&, const QString&
     return TRUE;
 }
 
-bool StructureParser::characters(const QString& data)
+bool StructureParser::characters(const string& data)
 {
     //cout.form("-------------------- characters(...) called\n");
     if(activeTag=="Message" ) {
@@ -318,19 +322,14 @@ bool StructureParser::characters(const QString& data)
 
 bool StructureParser::startCDATA()
 {
-    fprintf(stderr,"startCDATA\n");
+    ROBSOCK_LOG("startCDATA");
     cdata=true;
     return TRUE;
 }
 
 bool StructureParser::endCDATA()
 {
-    fprintf(stderr,"endCDATA\n");
+    ROBSOCK_LOG("endCDATA");
     cdata=false;
     return TRUE;
 }
-
-void StructureParser::setDocumentLocator(QXmlLocator *)
-{
-    //cout.form("-------------------- setDocumentLocator(...) called\n");
-}
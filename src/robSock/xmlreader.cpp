@@ -0,0 +1,255 @@
+/* xmlreader.cpp */
+
+#include "robSock/xmlreader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const std::string *XmlAttributes::value(const char *name) const
+{
+    for(int i = 0; i < n; i++)
+        if(attrs[i].first == name)
+            return &attrs[i].second;
+    return 0;
+}
+
+std::pair<std::string,std::string> &XmlAttributes::append(void)
+{
+    if(n == (int)attrs.size())
+        attrs.resize(n + 1);
+    return attrs[n++];
+}
+
+static inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline bool isNameChar(char c)
+{
+    return !isSpace(c) && c != '=' && c != '>' && c != '/' && c != '<' && c != '"' && c != '\'' && c != '\0';
+}
+
+static inline void skipSpace(const char *&p, const char *end)
+{
+    while(p < end && isSpace(*p)) p++;
+}
+
+/* appends the UTF-8 encoding of code point cp */
+static void appendUtf8(std::string &out, unsigned long cp)
+{
+    if(cp < 0x80) out += (char)cp;
+    else if(cp < 0x800) {
+        out += (char)(0xC0 | (cp >> 6));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+    else if(cp < 0x10000) {
+        out += (char)(0xE0 | (cp >> 12));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+    else {
+        out += (char)(0xF0 | (cp >> 18));
+        out += (char)(0x80 | ((cp >> 12) & 0x3F));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+}
+
+bool XmlReader::decode(const char *b, const char *e, std::string &out)
+{
+    out.clear();
+    const char *amp = (const char *)memchr(b, '&', e - b);
+    if(amp == 0) {
+        out.assign(b, e);
+        return true;
+    }
+
+    while(b < e) {
+        if(*b != '&') {
+            out += *b++;
+            continue;
+        }
+        const char *semi = (const char *)memchr(b, ';', e - b);
+        if(semi == 0) return false;
+
+        std::string ent(b + 1, semi);
+        if(ent == "lt") out += '<';
+        else if(ent == "gt") out += '>';
+        else if(ent == "amp") out += '&';
+        else if(ent == "quot") out += '"';
+        else if(ent == "apos") out += '\'';
+        else if(ent.size() > 1 && ent[0] == '#') {
+            unsigned long cp = (ent[1] == 'x') ? strtoul(ent.c_str() + 2, 0, 16)
+                                               : strtoul(ent.c_str() + 1, 0, 10);
+            appendUtf8(out, cp);
+        }
+        else return false;
+        b = semi + 1;
+    }
+    return true;
+}
+
+bool XmlReader::parseElement(const char *&p, const char *end)
+{
+    // p points after '<'
+    const char *b = p;
+    while(p < end && isNameChar(*p)) p++;
+    if(p == b) return false;
+    tag.assign(b, p);
+
+    attributes.clear();
+    for(;;) {
+        skipSpace(p, end);
+        if(p >= end) return false;
+        if(*p == '>' || *p == '/') break;
+
+        const char *nb = p;
+        while(p < end && isNameChar(*p)) p++;
+        if(p == nb) return false;
+        const char *ne = p;
+
+        skipSpace(p, end);
+        if(p >= end || *p != '=') return false;
+        p++;
+        skipSpace(p, end);
+        if(p >= end || (*p != '"' && *p != '\'')) return false;
+
+        char quote = *p++;
+        const char *vb = p;
+        const char *ve = (const char *)memchr(p, quote, end - p);
+        if(ve == 0) return false;
+        p = ve + 1;
+
+        std::pair<std::string,std::string> &attr = attributes.append();
+        attr.first.assign(nb, ne);
+        if(!decode(vb, ve, attr.second)) return false;
+    }
+
+    bool empty = (*p == '/');
+    if(empty) {
+        p++;
+        if(p >= end || *p != '>') return false;
+    }
+    p++; // skip '>'
+
+    if(!handler->startElement(tag, attributes)) return false;
+
+    if(empty)
+        return handler->endElement(tag);
+
+    if(depth == (int)open.size()) open.resize(depth + 1);
+    open[depth++] = tag;
+    return true;
+}
+
+bool XmlReader::parseEndElement(const char *&p, const char *end)
+{
+    // p points after "</"
+    const char *b = p;
+    while(p < end && isNameChar(*p)) p++;
+    tag.assign(b, p);
+    skipSpace(p, end);
+    if(p >= end || *p != '>') return false;
+    p++;
+
+    if(depth == 0 || open[depth-1] != tag) return false;
+    depth--;
+
+    return handler->endElement(tag);
+}
+
+bool XmlReader::parse(const char *data, size_t len)
+{
+    if(handler == 0) return false;
+
+    const char *p = data;
+    const char *end = data + len;
+
+    // datagrams are sent with their terminating '\0'
+    const char *nul = (const char *)memchr(data, '\0', len);
+    if(nul != 0) end = nul;
+
+    depth = 0;
+    bool root = false;
+
+    if(!handler->startDocument()) return false;
+
+    while(p < end)
+    {
+        const char *lt = (const char *)memchr(p, '<', end - p);
+        const char *te = lt ? lt : end;
+
+        // character data
+        if(te > p) {
+            if(depth > 0) {
+                if(!decode(p, te, text)) return false;
+                if(!handler->characters(text)) return false;
+            }
+            else {
+                // only whitespace is allowed outside the root element
+                for(const char *c = p; c < te; c++)
+                    if(!isSpace(*c)) return false;
+            }
+        }
+        if(lt == 0) break;
+        p = lt + 1;
+
+        if(end - p >= 8 && strncmp(p, "![CDATA[", 8) == 0) {
+            p += 8;
+            const char *ce = p;
+            while(ce + 2 < end && strncmp(ce, "]]>", 3) != 0) ce++;
+            if(ce + 2 >= end) return false;
+            text.assign(p, ce);
+            if(!handler->startCDATA()) return false;
+            if(!handler->characters(text)) return false;
+            if(!handler->endCDATA()) return false;
+            p = ce + 3;
+        }
+        else if(end - p >= 3 && strncmp(p, "!--", 3) == 0) {
+            const char *ce = p + 3;
+            while(ce + 2 < end && strncmp(ce, "-->", 3) != 0) ce++;
+            if(ce + 2 >= end) return false;
+            p = ce + 3;
+        }
+        else if(p < end && (*p == '?' || *p == '!')) {
+            const char *ce = (const char *)memchr(p, '>', end - p);
+            if(ce == 0) return false;
+            p = ce + 1;
+        }
+        else if(p < end && *p == '/') {
+            p++;
+            if(!parseEndElement(p, end)) return false;
+        }
+        else {
+            if(depth == 0 && root) return false; // a single root element
+            root = true;
+            if(!parseElement(p, end)) return false;
+        }
+    }
+
+    if(depth != 0 || !root) return false;
+
+    return handler->endDocument();
+}
+
+bool XmlReader::parse(const char *data)
+{
+    return parse(data, strlen(data));
+}
+
+bool XmlReader::parseFile(const char *filename)
+{
+    FILE *f = fopen(filename, "rb");
+    if(f == 0) return false;
+
+    std::string doc;
+    char buf[4096];
+    size_t n;
+    while((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        doc.append(buf, n);
+    fclose(f);
+
+    return parse(doc.data(), doc.size());
+}
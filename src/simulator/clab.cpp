@@ -0,0 +1,285 @@
+/* clab.cpp */
+
+#include "simulator/clab.h"
+
+#include "robSock/structureparser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <algorithm>
+
+using std::string;
+using std::vector;
+
+/*
+ * Lab, grid and parameter files share one handler: StructureParser reads
+ * the Parameters and decodes the wall maze rows, this adds what only the
+ * simulator needs.
+ */
+class CLabParser : public StructureParser
+{
+public:
+    CLabParser(CLab &l) : StructureParser(0), lab(l) {}
+
+    bool startElement(const string &tag, const XmlAttributes &attr);
+
+    /* rows as found in the file, for line mazes */
+    vector< std::pair<int,string> > rows;
+
+private:
+    static double attrDouble(const XmlAttributes &attr, const char *name, double def)
+    {
+        const string *v = attr.value(name);
+        return v ? strtod(v->c_str(), 0) : def;
+    }
+
+    CLab &lab;
+};
+
+bool CLabParser::startElement(const string &tag, const XmlAttributes &attr)
+{
+    if(tag == "Lab") {
+        const string *name = attr.value("Name");
+        if(name) lab.name = *name;
+        lab.width = attrDouble(attr, "Width", lab.width);
+        lab.height = attrDouble(attr, "Height", lab.height);
+    }
+    else if(tag == "Target") {
+        CLabTarget t;
+        t.x = attrDouble(attr, "X", 0.0);
+        t.y = attrDouble(attr, "Y", 0.0);
+        t.radius = attrDouble(attr, "Radius", LAB_TARGET_RADIUS);
+        lab.targets.push_back(t);
+    }
+    else if(tag == "Position") {
+        CLabPose p;
+        p.x = attrDouble(attr, "X", 0.0);
+        p.y = attrDouble(attr, "Y", 0.0);
+        p.dir = attrDouble(attr, "Dir", 0.0);
+        lab.grid.push_back(p);
+    }
+    else if(tag == "Parameters") {
+        const string *gps = attr.value("GPS");
+        if(gps) lab.gps = (*gps == "On");
+        lab.lineNoise = attrDouble(attr, "LineSensorNoise", lab.lineNoise);
+    }
+    else if(tag == "Row") {
+        const string *pos = attr.value("Pos");
+        const string *pattern = attr.value("Pattern");
+        if(pos && pattern) rows.push_back(std::make_pair(atoi(pos->c_str()), *pattern));
+    }
+
+    return StructureParser::startElement(tag, attr);
+}
+
+CLab::CLab() : width(28.0), height(14.0), gps(false), lineNoise(0.0), binCols(0), binRows(0)
+{
+}
+
+bool CLab::loadParameters(const char *filename)
+{
+    CLabParser handler(*this);
+    XmlReader reader;
+    reader.setContentHandler(&handler);
+    if(!reader.parseFile(filename)) return false;
+
+    param = *handler.getSimParam();
+    return true;
+}
+
+bool CLab::loadGrid(const char *filename)
+{
+    grid.clear();
+
+    CLabParser handler(*this);
+    XmlReader reader;
+    reader.setContentHandler(&handler);
+    return reader.parseFile(filename);
+}
+
+/* true if the rows hold strips: walls never put '-' on a cell row or '|' between rows */
+static bool isLineMaze(const vector< std::pair<int,string> > &rows)
+{
+    for(size_t r = 0; r < rows.size(); r++) {
+        const string &p = rows[r].second;
+        for(size_t c = 0; c < p.size(); c++) {
+            if(p[c] == '/' || p[c] == '\\') return true;
+            if(rows[r].first % 2 == 0 && p[c] == '-') return true;
+            if(rows[r].first % 2 != 0 && p[c] == '|') return true;
+        }
+    }
+    return false;
+}
+
+static void addLines(CLab &lab, const vector< std::pair<int,string> > &rows)
+{
+    // cell at (col,row) is centered at (col+2,row+2)
+    for(size_t r = 0; r < rows.size(); r++) {
+        int row = rows[r].first;
+        const string &p = rows[r].second;
+        double y = row + 2;
+
+        for(int col = 0; col < (int)p.size(); col++) {
+            double x = col + 2;
+            CLabSegment s;
+
+            switch(p[col]) {
+            case '-':
+                s.x0 = x - 1; s.y0 = y; s.x1 = x + 1; s.y1 = y;
+                break;
+            case '|':
+                s.x0 = x; s.y0 = y - 1; s.x1 = x; s.y1 = y + 1;
+                break;
+            case '/':
+                s.x0 = x - 1; s.y0 = y - 1; s.x1 = x + 1; s.y1 = y + 1;
+                break;
+            case '\\':
+                s.x0 = x - 1; s.y0 = y + 1; s.x1 = x + 1; s.y1 = y - 1;
+                break;
+            default:
+                if(p[col] >= '0' && p[col] <= '9' && row % 2 == 0 && col % 2 == 0) {
+                    unsigned int id = p[col] - '0';
+                    if(lab.targets.size() <= id) {
+                        CLabTarget none = { -100.0, -100.0, 0.0 };
+                        lab.targets.resize(id + 1, none);
+                    }
+                    CLabTarget t = { x, y, LAB_TARGET_RADIUS };
+                    lab.targets[id] = t;
+                }
+                continue;
+            }
+            lab.lines.push_back(s);
+        }
+    }
+}
+
+static void addWalls(CLab &lab, const char map[CELLROWS*2-1][CELLCOLS*2-1])
+{
+    // cell at (col,row) of the decoded map is centered at (col+1,row+1)
+    for(int row = 0; row < CELLROWS*2-1; row++)
+        for(int col = 0; col < CELLCOLS*2-1; col++) {
+            CLabSegment s;
+            if(map[row][col] == '|') {
+                s.x0 = s.x1 = col + 1;
+                s.y0 = row; s.y1 = row + 2;
+            }
+            else if(map[row][col] == '-') {
+                s.y0 = s.y1 = row + 1;
+                s.x0 = col; s.x1 = col + 2;
+            }
+            else continue;
+            lab.walls.push_back(s);
+        }
+}
+
+bool CLab::parseLab(const char *xml, size_t len)
+{
+    lines.clear();
+    walls.clear();
+    targets.clear();
+
+    CLabParser handler(*this);
+    XmlReader reader;
+    reader.setContentHandler(&handler);
+    if(!reader.parse(xml, len)) return false;
+
+    if(isLineMaze(handler.rows))
+        addLines(*this, handler.rows);
+    else
+        addWalls(*this, handler.map);
+
+    indexLines();
+    return true;
+}
+
+void CLab::indexLines(void)
+{
+    binCols = (int)ceil(width);
+    binRows = (int)ceil(height);
+    lineBins.assign(binCols * binRows, std::vector<int>());
+
+    const double margin = LAB_LINE_WIDTH / 2;
+    for(size_t i = 0; i < lines.size(); i++) {
+        const CLabSegment &s = lines[i];
+        int c0 = (int)floor(std::min(s.x0, s.x1) - margin), c1 = (int)floor(std::max(s.x0, s.x1) + margin);
+        int r0 = (int)floor(std::min(s.y0, s.y1) - margin), r1 = (int)floor(std::max(s.y0, s.y1) + margin);
+
+        for(int r = std::max(r0, 0); r <= std::min(r1, binRows - 1); r++)
+            for(int c = std::max(c0, 0); c <= std::min(c1, binCols - 1); c++)
+                lineBins[r * binCols + c].push_back(i);
+    }
+}
+
+bool CLab::loadLab(const char *filename)
+{
+    FILE *fp = fopen(filename, "rb");
+    if(fp == 0) return false;
+
+    string xml;
+    char buf[4096];
+    for(size_t n; (n = fread(buf, 1, sizeof(buf), fp)) > 0; )
+        xml.append(buf, n);
+    fclose(fp);
+
+    return parseLab(xml.data(), xml.size());
+}
+
+/* squared distance from (x,y) to segment s */
+static double distance2(const CLabSegment &s, double x, double y)
+{
+    double dx = s.x1 - s.x0, dy = s.y1 - s.y0;
+    double t = ((x - s.x0) * dx + (y - s.y0) * dy) / (dx * dx + dy * dy);
+    if(t < 0.0) t = 0.0;
+    else if(t > 1.0) t = 1.0;
+
+    double ex = s.x0 + t * dx - x, ey = s.y0 + t * dy - y;
+    return ex * ex + ey * ey;
+}
+
+bool CLab::onLine(double x, double y) const
+{
+    if(x < 0.0 || y < 0.0) return false;
+    int c = (int)x, r = (int)y;
+    if(c >= binCols || r >= binRows) return false;
+
+    const double r2 = (LAB_LINE_WIDTH / 2) * (LAB_LINE_WIDTH / 2);
+    const std::vector<int> &bin = lineBins[r * binCols + c];
+    for(size_t i = 0; i < bin.size(); i++)
+        if(distance2(lines[bin[i]], x, y) <= r2) return true;
+    return false;
+}
+
+bool CLab::collides(double x, double y, double radius) const
+{
+    if(x - radius < 0.0 || x + radius > width || y - radius < 0.0 || y + radius > height)
+        return true;
+
+    double r = radius + LAB_WALL_WIDTH / 2;
+    for(size_t i = 0; i < walls.size(); i++)
+        if(distance2(walls[i], x, y) < r * r) return true;
+    return false;
+}
+
+int CLab::targetAt(double x, double y) const
+{
+    for(size_t i = 0; i < targets.size(); i++) {
+        double dx = targets[i].x - x, dy = targets[i].y - y;
+        if(dx * dx + dy * dy <= targets[i].radius * targets[i].radius) return i;
+    }
+    return -1;
+}
+
+CLabPose CLab::startPose(int id) const
+{
+    if(id >= 1 && id <= (int)grid.size()) return grid[id - 1];
+
+    // no grid: start on target 0 (the starting spot of line mazes), or in the middle
+    CLabPose p = { width / 2, height / 2, 0.0 };
+    if(!targets.empty()) {
+        p.x = targets[0].x;
+        p.y = targets[0].y;
+    }
+    return p;
+}
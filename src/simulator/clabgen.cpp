@@ -0,0 +1,231 @@
+/* clabgen.cpp */
+
+#include "simulator/clabgen.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <random>
+
+using std::string;
+using std::vector;
+
+static const int dirCol[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+static const int dirRow[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+/*
+ * Drawn from the generator's raw output only, so a seed gives the same
+ * maze whatever the standard library's distributions do.
+ */
+static inline unsigned int below(std::mt19937 &rng, unsigned int n)
+{
+    return rng() % n;
+}
+
+static inline double uniform(std::mt19937 &rng)
+{
+    return rng() / (std::mt19937::max() + 1.0);
+}
+
+template<class T> static void shuffle(vector<T> &v, std::mt19937 &rng)
+{
+    for(size_t i = v.size(); i > 1; i--)
+        std::swap(v[i - 1], v[below(rng, i)]);
+}
+
+static inline int bits(unsigned char b)
+{
+    int n = 0;
+    for(; b; b &= b - 1) n++;
+    return n;
+}
+
+CLabGenOptions::CLabGenOptions()
+    : cols(13), rows(6), cover(1.0), diagonal(0.3), loops(0.1), deadEnds(-1), targets(3), seed(1)
+{
+}
+
+CLabGen::CLabGen(const CLabGenOptions &o)
+    : cols(std::max(o.cols, 1)), rows(std::max(o.rows, 1))
+{
+    int nCells = cols * rows;
+    start = rows / 2 * cols + cols / 2;
+    reached.assign(nCells, false);
+    linked.assign(nCells, 0);
+    crossings.assign(nCells, false);
+
+    std::mt19937 rng(o.seed);
+
+    // the tree, grown from the start over links to cells it has not reached
+    vector<int> orth, diag;     // frontier links, cell * 8 + dir
+    int goal = std::max(1, (int)lround(o.cover * nCells)), nReached = 1;
+
+    reached[start] = true;
+    for(int cell = start; ; ) {
+        for(int d = 0; d < 8; d++) {
+            int n = neighbor(cell, d);
+            if(n >= 0 && !reached[n]) (d % 2 ? diag : orth).push_back(cell * 8 + d);
+        }
+
+        cell = -1;
+        while(cell < 0 && nReached < goal && (!orth.empty() || !diag.empty())) {
+            bool useDiag = !diag.empty() && (orth.empty() || uniform(rng) < o.diagonal);
+            vector<int> &f = useDiag ? diag : orth;
+            unsigned int i = below(rng, f.size());
+            int e = f[i];
+            f[i] = f.back();
+            f.pop_back();
+
+            int n = neighbor(e / 8, e % 8);
+            if(reached[n] || !canLink(e / 8, e % 8)) continue;
+            link(e / 8, e % 8);
+            reached[n] = true;
+            nReached++;
+            cell = n;
+        }
+        if(cell < 0) break;
+    }
+
+    // loops: some of the links between reached cells the tree left out
+    vector<int> others;
+    for(int cell = 0; cell < nCells; cell++)
+        for(int d = 0; d < 4 && reached[cell]; d++) {
+            int n = neighbor(cell, d);
+            if(n >= 0 && reached[n] && canLink(cell, d)) others.push_back(cell * 8 + d);
+        }
+    shuffle(others, rng);
+
+    int nLoops = (int)lround(o.loops * others.size());
+    for(size_t i = 0; i < others.size() && nLoops > 0; i++)
+        if(canLink(others[i] / 8, others[i] % 8)) {
+            link(others[i] / 8, others[i] % 8);
+            nLoops--;
+        }
+
+    // dead ends closed by a link to another neighbor
+    if(o.deadEnds >= 0) {
+        vector<int> ends;
+        for(int cell = 0; cell < nCells; cell++)
+            if(bits(linked[cell]) == 1) ends.push_back(cell);
+        shuffle(ends, rng);
+
+        int nEnds = ends.size();
+        for(size_t i = 0; i < ends.size() && nEnds > o.deadEnds; i++) {
+            int cell = ends[i];
+            if(bits(linked[cell]) != 1) continue;   // closed with another one
+
+            vector<int> dirs;
+            for(int d = 0; d < 8; d++) {
+                int n = neighbor(cell, d);
+                if(n >= 0 && reached[n] && canLink(cell, d)) dirs.push_back(d);
+            }
+            if(dirs.empty()) continue;
+
+            int d = dirs[below(rng, dirs.size())];
+            nEnds -= 1 + (bits(linked[neighbor(cell, d)]) == 1);
+            link(cell, d);
+        }
+    }
+
+    // targets on reached cells, the start first
+    vector<int> cells;
+    for(int cell = 0; cell < nCells; cell++)
+        if(reached[cell] && cell != start) cells.push_back(cell);
+    shuffle(cells, rng);
+
+    targets.push_back(start);
+    for(int i = 0; i < std::min(o.targets, 9) && i < (int)cells.size(); i++)
+        targets.push_back(cells[i]);
+}
+
+int CLabGen::neighbor(int cell, int dir) const
+{
+    int col = cell % cols + dirCol[dir], row = cell / cols + dirRow[dir];
+    if(col < 0 || col >= cols || row < 0 || row >= rows) return -1;
+    return row * cols + col;
+}
+
+/* the square a diagonal crosses, by its lower left cell */
+static inline int square(int cell, int dir, int cols)
+{
+    int col = cell % cols, row = cell / cols;
+    return std::min(row, row + dirRow[dir]) * cols + std::min(col, col + dirCol[dir]);
+}
+
+bool CLabGen::canLink(int cell, int dir) const
+{
+    if(neighbor(cell, dir) < 0 || (linked[cell] & (1 << dir))) return false;
+    return dir % 2 == 0 || !crossings[square(cell, dir, cols)];
+}
+
+void CLabGen::link(int cell, int dir)
+{
+    int n = neighbor(cell, dir);
+    linked[cell] |= 1 << dir;
+    linked[n] |= 1 << ((dir + 4) % 8);
+    if(dir % 2) crossings[square(cell, dir, cols)] = true;
+    links.push_back(std::make_pair(std::min(cell, n), std::max(cell, n)));
+}
+
+int CLabGen::deadEnds(void) const
+{
+    int n = 0;
+    for(size_t cell = 0; cell < linked.size(); cell++)
+        if(bits(linked[cell]) == 1) n++;
+    return n;
+}
+
+string CLabGen::labXml(const string &name) const
+{
+    // a cell at every even row and column, the links between them
+    int width = 2 * cols - 1, height = 2 * rows - 1;
+    vector<string> pattern(height, string(width, ' '));
+
+    for(size_t i = 0; i < links.size(); i++) {
+        int a = links[i].first, b = links[i].second;
+        int dc = b % cols - a % cols, dr = b / cols - a / cols;
+        char c = dr == 0 ? '-' : dc == 0 ? '|' : dc == dr ? '/' : '\\';
+        pattern[a / cols * 2 + dr][a % cols * 2 + dc] = c;
+    }
+    for(size_t i = 0; i < targets.size(); i++)
+        pattern[targets[i] / cols * 2][targets[i] % cols * 2] = '0' + i;
+
+    char line[64];
+    string xml = "<Lab Name=\"" + name + "\"";
+    snprintf(line, sizeof(line), " Height=\"%d\" Width=\"%d\">\n", height + 3, width + 3);
+    xml += line;
+    for(int row = height - 1; row >= 0; row--) {
+        snprintf(line, sizeof(line), "<Row Pos=\"%d\" Pattern=\"", row);
+        xml += line + pattern[row] + "\"/>\n";
+    }
+    return xml + "</Lab>\n";
+}
+
+string CLabGen::gridXml(void) const
+{
+    char xml[128];
+    snprintf(xml, sizeof(xml), "<Grid>\n<Position X=\"%d\" Y=\"%d\" Dir=\"0.0\"/>\n</Grid>\n",
+             start % cols * 2 + 2, start / cols * 2 + 2);
+    return xml;
+}
+
+string CLabGen::graph(void) const
+{
+    int sc = start % cols, sr = start / cols;
+    string text;
+    char line[96];
+
+    for(size_t i = 0; i < targets.size(); i++) {
+        snprintf(line, sizeof(line), "target %zu %d %d\n", i,
+                 2 * (targets[i] % cols - sc), 2 * (targets[i] / cols - sr));
+        text += line;
+    }
+    for(size_t i = 0; i < links.size(); i++) {
+        int a = links[i].first, b = links[i].second;
+        snprintf(line, sizeof(line), "link %d %d %d %d\n",
+                 2 * (a % cols - sc), 2 * (a / cols - sr), 2 * (b % cols - sc), 2 * (b / cols - sr));
+        text += line;
+    }
+    return text;
+}
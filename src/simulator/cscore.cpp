@@ -0,0 +1,256 @@
+/* cscore.cpp */
+
+#include "simulator/cscore.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <vector>
+
+#define CENTER_ROW (SCORE_ROWS / 2)
+#define CENTER_COL (SCORE_COLS / 2)
+#define NCELLS (SCORE_ROWS * SCORE_COLS)
+
+static const double INF = std::numeric_limits<double>::infinity();
+
+static inline bool isLink(char c)
+{
+    return c == '-' || c == '|' || c == '/' || c == '\\';
+}
+
+/* the character that links a cell to its neighbor at (drow,dcol), in cell steps */
+static inline char linkChar(int drow, int dcol)
+{
+    if(drow == 0) return '-';
+    if(dcol == 0) return '|';
+    return drow == -dcol ? '/' : '\\';
+}
+
+/* reads a whole file, returns false if it can not be read */
+static bool readFile(const char *filename, std::vector<char> &text)
+{
+    FILE *fp = fopen(filename, "rb");
+    if(fp == 0) return false;
+
+    char buf[4096];
+    for(size_t n; (n = fread(buf, 1, sizeof(buf), fp)) > 0; )
+        text.insert(text.end(), buf, buf + n);
+    fclose(fp);
+    return true;
+}
+
+/* reads the next integer before end, skipping blanks */
+static bool readInt(const char *&p, const char *end, long &v)
+{
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+    bool negative = p < end && *p == '-';
+    if(p < end && (*p == '-' || *p == '+')) p++;
+    if(p >= end || *p < '0' || *p > '9') return false;
+
+    for(v = 0; p < end && *p >= '0' && *p <= '9'; p++)
+        v = std::min(v * 10 + (*p - '0'), 1000000L);    // far off the map anyway
+    if(negative) v = -v;
+    return true;
+}
+
+
+/*** CScoreMap ***/
+
+CScoreMap::CScoreMap()
+{
+    memset(cells, ' ', sizeof(cells));
+}
+
+bool CScoreMap::read(const char *filename)
+{
+    std::vector<char> text;
+    if(!readFile(filename, text)) {
+        memset(cells, ' ', sizeof(cells));
+        return false;
+    }
+    parse(text.empty() ? "" : &text[0], text.size());
+    return true;
+}
+
+void CScoreMap::parse(const char *text, size_t len)
+{
+    memset(cells, ' ', sizeof(cells));
+
+    int row = 0, col = 0;
+    for(size_t i = 0; i < len && row < SCORE_ROWS; i++) {
+        if(text[i] == '\n') {
+            row++;
+            col = 0;
+        }
+        else if(text[i] != '\r' && col < SCORE_COLS)
+            cells[row][col++] = text[i];
+    }
+}
+
+/* lab units are map characters, y goes up */
+static void put(char cells[][SCORE_COLS], const CLabPose &start, double x, double y, char c)
+{
+    int row = CENTER_ROW - (int)lround(y - start.y);
+    int col = CENTER_COL + (int)lround(x - start.x);
+    if(row >= 0 && row < SCORE_ROWS && col >= 0 && col < SCORE_COLS) cells[row][col] = c;
+}
+
+void CScoreMap::draw(const CLab &lab)
+{
+    memset(cells, ' ', sizeof(cells));
+    CLabPose start = lab.startPose(1);
+
+    for(size_t i = 0; i < lab.lines.size(); i++) {
+        const CLabSegment &s = lab.lines[i];
+        double dx = s.x1 - s.x0, dy = s.y1 - s.y0;
+        put(cells, start, (s.x0 + s.x1) / 2, (s.y0 + s.y1) / 2,
+            dy == 0 ? '-' : dx == 0 ? '|' : dx * dy > 0 ? '/' : '\\');
+    }
+
+    for(size_t i = 0; i < lab.targets.size() && i < 10; i++)
+        if(lab.targets[i].radius > 0) put(cells, start, lab.targets[i].x, lab.targets[i].y, '0' + i);
+}
+
+
+/*** CScorer ***/
+
+CScorer::CScorer(const CLab &l)
+    : nLinks(0), nTargets(0), tour(0.0)
+{
+    lab.draw(l);
+
+    for(int i = 0; i < NCELLS; i++)
+        if(isLink(lab.cells[i / SCORE_COLS][i % SCORE_COLS])) nLinks++;
+
+    // the start, then the other targets by id
+    memset(targetAt, -1, sizeof(targetAt));
+    int start = CENTER_ROW * SCORE_COLS + CENTER_COL;
+    targets[nTargets] = start;
+    targetAt[start] = nTargets++;
+    for(char id = '0'; id <= '9'; id++)
+        for(int i = 0; i < NCELLS; i++)
+            if(lab.cells[i / SCORE_COLS][i % SCORE_COLS] == id && targetAt[i] < 0 && nTargets < 10) {
+                targets[nTargets] = i;
+                targetAt[i] = nTargets++;
+            }
+
+    // distances between targets
+    std::vector<double> dist(NCELLS);
+    double between[10][10];
+    for(int a = 0; a < nTargets; a++) {
+        distancesFrom(targets[a], &dist[0]);
+        for(int b = 0; b < nTargets; b++)
+            between[a][b] = dist[targets[b]];
+    }
+
+    // shortest tour from the start through every other target and back (Held-Karp)
+    int n = nTargets - 1;
+    if(n == 0) return;
+    std::vector<double> best((1 << n) * n, INF);      // visited set, last target
+    for(int t = 0; t < n; t++)
+        best[(1 << t) * n + t] = between[0][t + 1];
+    for(int set = 1; set < (1 << n); set++)
+        for(int last = 0; last < n; last++) {
+            double d = best[set * n + last];
+            if(!(set & (1 << last)) || d == INF) continue;
+            for(int next = 0; next < n; next++) {
+                if(set & (1 << next)) continue;
+                double &b = best[(set | (1 << next)) * n + next];
+                b = std::min(b, d + between[last + 1][next + 1]);
+            }
+        }
+
+    tour = INF;
+    for(int last = 0; last < n; last++)
+        tour = std::min(tour, best[((1 << n) - 1) * n + last] + between[last + 1][0]);
+}
+
+int CScorer::mapScore(const CScoreMap &map) const
+{
+    int score = 0;
+    const char *m = &map.cells[0][0], *l = &lab.cells[0][0];
+    for(int i = 0; i < NCELLS; i++)
+        if(isLink(m[i])) score += m[i] == l[i] ? 1 : -1;
+    return score;
+}
+
+bool CScorer::linked(int cell, int drow, int dcol) const
+{
+    int row = cell / SCORE_COLS + 2 * drow, col = cell % SCORE_COLS + 2 * dcol;
+    if(row < 0 || row >= SCORE_ROWS || col < 0 || col >= SCORE_COLS) return false;
+    return lab.cells[row - drow][col - dcol] == linkChar(drow, dcol);
+}
+
+void CScorer::distancesFrom(int cell, double *dist) const
+{
+    typedef std::pair<double,int> Entry;
+    std::priority_queue< Entry, std::vector<Entry>, std::greater<Entry> > open;
+
+    std::fill(dist, dist + NCELLS, INF);
+    dist[cell] = 0.0;
+    open.push(Entry(0.0, cell));
+    while(!open.empty()) {
+        Entry e = open.top();
+        open.pop();
+        if(e.first > dist[e.second]) continue;
+
+        for(int dr = -1; dr <= 1; dr++)
+            for(int dc = -1; dc <= 1; dc++) {
+                if((dr == 0 && dc == 0) || !linked(e.second, dr, dc)) continue;
+                int n = e.second + 2 * dr * SCORE_COLS + 2 * dc;
+                double d = e.first + (dr != 0 && dc != 0 ? M_SQRT2 : 1.0);
+                if(d < dist[n]) {
+                    dist[n] = d;
+                    open.push(Entry(d, n));
+                }
+            }
+    }
+}
+
+double CScorer::pathScore(const char *filename) const
+{
+    std::vector<char> text;
+    if(!readFile(filename, text)) return 0.0;
+    return pathScore(text.empty() ? "" : &text[0], text.size());
+}
+
+double CScorer::pathScore(const char *text, size_t len) const
+{
+    const char *p = text, *end = text + len;
+    int prev = -1, first = -1;
+    unsigned int visited = 0;
+    double length = 0.0;
+
+    // one "x y" per line, read as pairs of numbers
+    for(;;) {
+        long x, y;
+        if(!readInt(p, end, x)) break;
+        if(!readInt(p, end, y)) return 0.0;
+
+        long row = CENTER_ROW - y, col = CENTER_COL + x;
+        if(row < 0 || row >= SCORE_ROWS || col < 0 || col >= SCORE_COLS) return 0.0;
+        int cell = row * SCORE_COLS + col;
+
+        if(prev < 0)
+            first = cell;
+        else if(cell != prev) {
+            int dr = cell / SCORE_COLS - prev / SCORE_COLS, dc = cell % SCORE_COLS - prev % SCORE_COLS;
+            if(dr < -2 || dr > 2 || dc < -2 || dc > 2 || dr % 2 != 0 || dc % 2 != 0 ||
+               !linked(prev, dr / 2, dc / 2))
+                return 0.0;
+            length += (dr != 0 && dc != 0) ? M_SQRT2 : 1.0;
+        }
+        if(targetAt[cell] >= 0) visited |= 1u << targetAt[cell];
+        prev = cell;
+    }
+
+    if(first != targets[0] || prev != targets[0]) return 0.0;
+    if(visited != (1u << nTargets) - 1 || tour == INF) return 0.0;
+    return length > 0.0 ? tour / length : 1.0;
+}
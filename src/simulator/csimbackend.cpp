@@ -0,0 +1,133 @@
+/* csimbackend.cpp */
+
+#include "simulator/csimbackend.h"
+
+#include "robSock/clogger.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+using std::string;
+
+static std::mutex worldsMutex;
+static std::map<string, CLab *> worlds;     // loaded worlds, kept for the process lifetime
+
+static std::atomic<unsigned int> nextSeed(0);
+static std::once_flag seedOnce;
+
+static string envString(const char *name)
+{
+    const char *v = getenv(name);
+    return v ? v : "";
+}
+
+/* loads the files once, episodes after the first reuse them */
+static const CLab *loadLab(const string &paramFile, const string &labFile, const string &gridFile,
+                           const string &noise)
+{
+    string key = paramFile + '\n' + labFile + '\n' + gridFile + '\n' + noise;
+
+    std::lock_guard<std::mutex> lock(worldsMutex);
+    std::map<string, CLab *>::iterator it = worlds.find(key);
+    if(it != worlds.end()) return it->second;
+
+    CLab *lab = new CLab;
+    if((!paramFile.empty() && !lab->loadParameters(paramFile.c_str())) ||
+       (!labFile.empty() && !lab->loadLab(labFile.c_str())) ||
+       (!gridFile.empty() && !lab->loadGrid(gridFile.c_str()))) {
+        ROBSOCK_LOG("robSock: can not load the simulation (param \"%s\", lab \"%s\", grid \"%s\")",
+                    paramFile, labFile, gridFile);
+        delete lab;
+        return 0;
+    }
+
+    if(!noise.empty()) {
+        double scale = strtod(noise.c_str(), 0);
+        lab->param.obstNoise *= scale;
+        lab->param.beaconNoise *= scale;
+        lab->param.motorsNoise *= scale;
+        lab->param.compassNoise *= scale;
+        lab->lineNoise *= scale;
+    }
+
+    worlds[key] = lab;
+    return lab;
+}
+
+CSimBackend::CSimBackend(const char *lab)
+    : labFile(lab ? lab : envString("ROBSOCK_SIM_LAB")), sim(0), first(true), over(false)
+{
+}
+
+CSimBackend::~CSimBackend()
+{
+    delete sim;
+}
+
+bool CSimBackend::registerRobot(const char *name, int id, CSimParam &param)
+{
+    const CLab *lab = loadLab(envString("ROBSOCK_SIM_PARAM"), labFile, envString("ROBSOCK_SIM_GRID"),
+                              envString("ROBSOCK_SIM_NOISE"));
+    if(lab == 0) return false;
+
+    std::call_once(seedOnce, []() {
+        const char *env = getenv("ROBSOCK_SIM_SEED");
+        nextSeed.store(env ? strtoul(env, 0, 10) : time(0));
+    });
+
+    sim = new CSimulator(*lab, nextSeed.fetch_add(1));
+    sim->addRobot(id, name);
+    sim->start();
+
+    param = lab->param;
+    return true;
+}
+
+bool CSimBackend::readSensors(CMeasures &m)
+{
+    if(sim == 0) return false;
+
+    // the first read gets the starting cycle, each later one the next
+    if(!first) {
+        if(over) return false;
+        sim->step();
+    }
+    first = false;
+
+    sim->measures(0, m);
+
+    // the robot has seen how it ended (its EndLed, or the time limit)
+    over = sim->over();
+    return true;
+}
+
+void CSimBackend::driveMotors(double lPow, double rPow)
+{
+    if(sim) sim->robot(0).setMotors(lPow, rPow);
+}
+
+void CSimBackend::setEndLed(bool on)
+{
+    if(sim == 0) return;
+    sim->robot(0).setMotors(0.0, 0.0);
+    sim->robot(0).setEndLed(on);
+}
+
+void CSimBackend::setReturningLed(bool on)
+{
+    if(sim == 0) return;
+    sim->robot(0).setMotors(0.0, 0.0);
+    sim->robot(0).setReturningLed(on);
+}
+
+void CSimBackend::setVisitingLed(bool on)
+{
+    if(sim == 0) return;
+    sim->robot(0).setMotors(0.0, 0.0);
+    sim->robot(0).setVisitingLed(on);
+}
@@ -0,0 +1,108 @@
+/* csimchannel.cpp */
+
+#include "simulator/csimchannel.h"
+#include "simulator/csimshmchannel.h"
+#include "simulator/csimunixchannel.h"
+
+#include <string.h>
+#include <errno.h>
+
+CSimChannel *CSimChannel::create(const std::string &address, int port)
+{
+    if(address.compare(0, 5, "unix:") == 0)
+        return new CSimUnixChannel(address.c_str() + 5, SOCK_DGRAM);
+    if(address.compare(0, 8, "unixseq:") == 0)
+        return new CSimUnixChannel(address.c_str() + 8, SOCK_SEQPACKET);
+    if(address.compare(0, 4, "shm:") == 0)
+        return new CSimShmChannel(address.c_str() + 4);
+    if(!address.empty())
+        return 0;
+
+    return new CSimUdpChannel(port);
+}
+
+static bool sameSender(const sockaddr_in &a, const sockaddr_in &b)
+{
+    return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+}
+
+CSimUdpChannel::~CSimUdpChannel()
+{
+    for(size_t i = 0; i < ports.size(); i++) delete ports[i];
+}
+
+bool CSimUdpChannel::wait(int timeoutMs)
+{
+    std::vector<struct pollfd> pfd(1);
+    pfd[0].fd = server.socketfd;
+    for(size_t i = 0; i < ports.size(); i++) {
+        if(ports[i] == 0) continue;
+        pfd.push_back(pfd[0]);
+        pfd.back().fd = ports[i]->socketfd;
+    }
+    for(size_t i = 0; i < pfd.size(); i++) {
+        pfd[i].events = POLLIN;
+        pfd[i].revents = 0;
+    }
+
+    int ready = poll(&pfd[0], pfd.size(), timeoutMs);
+    return ready >= 0 || errno == EINTR;
+}
+
+int CSimUdpChannel::registration(char *buf, int size, int &link)
+{
+    if(server.wait_info(0) <= 0) return 0;
+
+    int n = server.recv_info(buf, size);
+    if(n <= 0) return 0;
+
+    // a resent registration comes from the same sender
+    sockaddr_in sender = server.GetLastSender();
+    for(size_t i = 0; i < remotes.size(); i++) {
+        if(ports[i] && sameSender(remotes[i], sender)) {
+            link = i;
+            return n;
+        }
+    }
+
+    link = remotes.size();
+    ports.push_back(0);
+    remotes.push_back(sender);
+    return n;
+}
+
+void CSimUdpChannel::reply(int link, const char *buf, int n, bool accepted)
+{
+    if(!accepted) {
+        // refused from the server port, the robot gets no port of its own
+        server.SetRemote(remotes[link]);
+        server.send_info(const_cast<char *>(buf), n);
+        return;
+    }
+
+    if(ports[link] == 0) {
+        Port *port = new Port();
+        if(!port->init()) {
+            delete port;
+            return;
+        }
+        port->SetRemote(remotes[link]);
+        ports[link] = port;
+    }
+    ports[link]->send_info(const_cast<char *>(buf), n);
+}
+
+int CSimUdpChannel::recv(int link, char *buf, int size)
+{
+    Port *port = ports[link];
+    if(port == 0) return -1;
+    if(port->wait_info(0) <= 0) return 0;
+
+    int n = port->recv_info(buf, size);
+    return n > 0 ? n : 0;
+}
+
+bool CSimUdpChannel::send(int link, const char *buf, int n)
+{
+    return ports[link] && ports[link]->send_info(const_cast<char *>(buf), n);
+}
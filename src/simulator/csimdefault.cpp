@@ -0,0 +1,12 @@
+/* csimdefault.cpp
+ *
+ * Linked into a program (robSockSim objects), makes robSock run the
+ * robots in-process by default, see CRobBackend.
+ */
+
+#include "robSock/crobbackend.h"
+
+static struct CSimDefault
+{
+    CSimDefault() { CRobBackend::setDefault(true); }
+} simDefault;
@@ -0,0 +1,193 @@
+/* csimrobot.cpp */
+
+#include "simulator/csimrobot.h"
+
+#include "robSock/xmlreader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+using std::string;
+
+/* reads the attributes of an Actions message */
+class CActionParser : public XmlHandler
+{
+public:
+    CActionParser() : left(0), right(0), endLed(0), returningLed(0), visitingLed(0) {}
+
+    bool startElement(const string &tag, const XmlAttributes &attr)
+    {
+        if(tag != "Actions") return true;
+        left = attr.value("LeftMotor");
+        right = attr.value("RightMotor");
+        if(left) leftValue = strtod(left->c_str(), 0);
+        if(right) rightValue = strtod(right->c_str(), 0);
+        endLed = onOff(attr, "EndLed");
+        returningLed = onOff(attr, "ReturningLed");
+        visitingLed = onOff(attr, "VisitingLed");
+        return true;
+    }
+
+    /* 0 if absent, 1 for Off, 2 for On */
+    static int onOff(const XmlAttributes &attr, const char *name)
+    {
+        const string *v = attr.value(name);
+        return v ? (*v == "On" ? 2 : 1) : 0;
+    }
+
+    const string *left, *right;
+    double leftValue, rightValue;
+    int endLed, returningLed, visitingLed;
+};
+
+static inline double clampPower(double p)
+{
+    if(p > MAX_POWER) return MAX_POWER;
+    if(p < -MAX_POWER) return -MAX_POWER;
+    return p;
+}
+
+static inline double normalizeRad(double a)
+{
+    while(a > M_PI) a -= 2 * M_PI;
+    while(a <= -M_PI) a += 2 * M_PI;
+    return a;
+}
+
+CSimRobot::CSimRobot(int id, const string &name, const CLabPose &start)
+    : robotId(id), robotName(name),
+      posX(start.x), posY(start.y), posDir(normalizeRad(start.dir * M_PI / 180.0)),
+      inL(0.0), inR(0.0), outL(0.0), outR(0.0),
+      endLed(false), returningLed(false), visitingLed(false),
+      collision(false), nCollisions(0), compass(0.0), ground(-1)
+{
+    for(int i = 0; i < N_LINE_ELEMENTS; i++) line[i] = false;
+}
+
+bool CSimRobot::actions(const char *xml, int n)
+{
+    CActionParser handler;
+    XmlReader reader;
+    reader.setContentHandler(&handler);
+    if(!reader.parse(xml, n)) return false;
+
+    if(handler.left) inL = clampPower(handler.leftValue);
+    if(handler.right) inR = clampPower(handler.rightValue);
+    if(handler.endLed) endLed = handler.endLed == 2;
+    if(handler.returningLed) returningLed = handler.returningLed == 2;
+    if(handler.visitingLed) visitingLed = handler.visitingLed == 2;
+    return true;
+}
+
+void CSimRobot::setMotors(double lPow, double rPow)
+{
+    inL = clampPower(lPow);
+    inR = clampPower(rPow);
+}
+
+void CSimRobot::move(const CLab &lab, std::mt19937 &rng)
+{
+    // MotorsNoise is a percentage of the power
+    std::normal_distribution<double> noise(1.0, lab.param.motorsNoise / 100.0);
+
+    outL = (inL + outL) / 2 * noise(rng);
+    outR = (inR + outR) / 2 * noise(rng);
+
+    double lin = (outL + outR) / 2;
+    double rot = (outR - outL) / ROBOT_DIAMETER;
+
+    double x = posX + lin * cos(posDir);
+    double y = posY + lin * sin(posDir);
+
+    collision = lab.collides(x, y, ROBOT_DIAMETER / 2);
+    if(collision) nCollisions++;
+    else {
+        posX = x;
+        posY = y;
+    }
+    posDir = normalizeRad(posDir + rot);
+}
+
+void CSimRobot::sense(const CLab &lab, std::mt19937 &rng)
+{
+    std::normal_distribution<double> compassNoise(0.0, lab.param.compassNoise);
+    std::uniform_real_distribution<double> percent(0.0, 100.0);
+
+    compass = posDir * 180.0 / M_PI;
+    if(lab.param.compassNoise > 0) compass += compassNoise(rng);
+    while(compass > 180.0) compass -= 360.0;
+    while(compass <= -180.0) compass += 360.0;
+
+    ground = lab.targetAt(posX, posY);
+
+    // element 0 is the leftmost one
+    double c = cos(posDir), s = sin(posDir);
+    for(int i = 0; i < N_LINE_ELEMENTS; i++) {
+        double side = (N_LINE_ELEMENTS / 2 - i) * LINE_SENSOR_SEP;
+        double x = posX + LINE_SENSOR_DIST * c - side * s;
+        double y = posY + LINE_SENSOR_DIST * s + side * c;
+
+        line[i] = lab.onLine(x, y);
+        if(lab.lineNoise > 0 && percent(rng) < lab.lineNoise) line[i] = !line[i];
+    }
+}
+
+static inline const char *onOffStr(bool v) { return v ? "On" : "Off"; }
+
+int CSimRobot::measures(char *buf, int size, const CLab &lab, unsigned int time, bool started) const
+{
+    char lineValue[N_LINE_ELEMENTS + 1];
+    for(int i = 0; i < N_LINE_ELEMENTS; i++) lineValue[i] = line[i] ? '1' : '0';
+    lineValue[N_LINE_ELEMENTS] = '\0';
+
+    int n = snprintf(buf, size,
+                     "<Measures Time=\"%u\">"
+                     "<Sensors Compass=\"%.1f\" Collision=\"%s\" Ground=\"%d\">"
+                     "<LineSensor Value=\"%s\"/>",
+                     time, compass, collision ? "Yes" : "No", ground, lineValue);
+
+    if(lab.gps && n < size)
+        n += snprintf(buf + n, size - n, "<GPS X=\"%.3f\" Y=\"%.3f\" Dir=\"%.1f\"/>",
+                      posX, posY, posDir * 180.0 / M_PI);
+
+    if(n < size)
+        n += snprintf(buf + n, size - n,
+                      "</Sensors>"
+                      "<Leds EndLed=\"%s\" ReturningLed=\"%s\" VisitingLed=\"%s\"/>"
+                      "<Buttons Start=\"%s\" Stop=\"Off\"/>"
+                      "</Measures>",
+                      onOffStr(endLed), onOffStr(returningLed), onOffStr(visitingLed),
+                      onOffStr(started));
+
+    if(n >= size) return -1;
+    return n + 1;
+}
+
+void CSimRobot::measures(CMeasures &m, const CLab &lab, unsigned int time, bool started) const
+{
+    m.time = time;
+
+    m.compassReady = true;
+    m.compass = floor(compass * 10 + 0.5) / 10;     // as printed in the message
+    m.collisionReady = true;
+    m.collision = collision;
+    m.groundReady = true;
+    m.ground = ground;
+
+    m.lineSensorReady = true;
+    m.lineSensor.assign(line, line + N_LINE_ELEMENTS);
+
+    m.gpsReady = m.gpsDirReady = lab.gps;
+    if(lab.gps) {
+        m.x = posX;
+        m.y = posY;
+        m.dir = posDir * 180.0 / M_PI;
+    }
+
+    m.endLed = endLed;
+    m.returningLed = returningLed;
+    m.visitingLed = visitingLed;
+    m.start = started;
+    m.stop = false;
+}
@@ -0,0 +1,193 @@
+/* csimserver.cpp */
+
+#include "simulator/csimserver.h"
+
+#include "robSock/xmlreader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MSGMAXSIZE 4096
+
+using std::string;
+
+static long long now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+/* reads a Robot (or RobotBeacon) registration message */
+class CRegisterParser : public XmlHandler
+{
+public:
+    CRegisterParser() : id(-1) {}
+
+    bool startElement(const string &tag, const XmlAttributes &attr)
+    {
+        if(tag != "Robot" && tag != "RobotBeacon") return true;
+
+        const string *v = attr.value("Name");
+        if(v) name = *v;
+        v = attr.value("Id");
+        if(v) id = atoi(v->c_str());
+        return true;
+    }
+
+    string name;
+    int id;
+};
+
+CSimServer::CSimServer(CSimulator &s, const std::string &address, int port)
+    : sim(s), channel(CSimChannel::create(address, port))
+{
+}
+
+CSimServer::~CSimServer()
+{
+    delete channel;
+}
+
+bool CSimServer::init(void)
+{
+    return channel && channel->init();
+}
+
+/*!
+ * Handles the pending registrations: registers each robot and replies on
+ * the link assigned to it.
+ */
+void CSimServer::registration(void)
+{
+    char xml[MSGMAXSIZE], reply[MSGMAXSIZE];
+    int n, link;
+
+    while((n = channel->registration(xml, MSGMAXSIZE, link)) > 0) {
+        // a resent registration gets the reply again
+        bool resent = false;
+        for(size_t i = 0; i < links.size(); i++)
+            if(links[i] == link) resent = true;
+        if(resent) {
+            int len = sim.reply(reply, MSGMAXSIZE, true);
+            channel->reply(link, reply, len, true);
+            continue;
+        }
+
+        CRegisterParser handler;
+        XmlReader reader;
+        reader.setContentHandler(&handler);
+        bool ok = reader.parse(xml, n) && handler.id >= 0;
+
+        int robot = ok && sim.nRobots() < SIM_MAX_ROBOTS ? sim.addRobot(handler.id, handler.name) : -1;
+        if(robot < 0) {
+            int len = sim.reply(reply, MSGMAXSIZE, false);
+            channel->reply(link, reply, len, false);
+            continue;
+        }
+
+        links.push_back(link);
+        reported.push_back(false);
+        gone.push_back(false);
+
+        int len = sim.reply(reply, MSGMAXSIZE, true);
+        channel->reply(link, reply, len, true);
+
+        fprintf(stderr, "simulator: robot %s registered at position %d\n",
+                handler.name.c_str(), handler.id);
+    }
+}
+
+void CSimServer::receiveActions(int i, bool *acted)
+{
+    char xml[MSGMAXSIZE];
+    if(gone[i]) return;
+
+    // several messages may be waiting, apply them in order
+    int n;
+    while((n = channel->recv(links[i], xml, MSGMAXSIZE)) > 0)
+        if(sim.robot(i).actions(xml, n)) acted[i] = true;
+
+    if(n < 0) {
+        fprintf(stderr, "simulator: robot %s is gone\n", sim.robot(i).name().c_str());
+        gone[i] = true;
+    }
+}
+
+void CSimServer::collectActions(bool unthrottled)
+{
+    int nRobots = sim.nRobots();
+    bool acted[SIM_MAX_ROBOTS];
+
+    // robots that finished or left no longer act
+    for(int i = 0; i < nRobots; i++) acted[i] = reported[i] || gone[i];
+
+    long long deadline = now_ms() + (unthrottled ? SIM_ACTION_TIMEOUT : sim.getLab().param.cycleTime);
+
+    for(;;) {
+        if(unthrottled) {
+            int i = 0;
+            while(i < nRobots && (acted[i] || gone[i])) i++;
+            if(i == nRobots) break;
+        }
+
+        long long left = deadline - now_ms();
+        if(left <= 0) break;
+
+        if(!channel->wait((int)left)) {
+            perror("simulator: wait");
+            exit(1);
+        }
+
+        registration();
+        for(int i = 0; i < nRobots; i++)
+            receiveActions(i, acted);
+    }
+}
+
+void CSimServer::sendMeasures(void)
+{
+    char xml[MSGMAXSIZE];
+
+    for(int i = 0; i < sim.nRobots(); i++) {
+        if(reported[i] || gone[i]) continue;
+
+        int n = sim.measures(i, xml, MSGMAXSIZE);
+        if(n > 0) channel->send(links[i], xml, n);
+
+        if(sim.robot(i).finished()) reported[i] = true;
+    }
+}
+
+void CSimServer::waitRobots(int nRobots)
+{
+    if(nRobots > SIM_MAX_ROBOTS) nRobots = SIM_MAX_ROBOTS;
+
+    while(sim.nRobots() < nRobots) {
+        if(!channel->wait(-1)) {
+            perror("simulator: wait");
+            exit(1);
+        }
+        registration();
+
+        // what they send before the start is applied as it would be then
+        bool acted[SIM_MAX_ROBOTS];
+        for(int i = 0; i < sim.nRobots(); i++)
+            receiveActions(i, acted);
+    }
+}
+
+void CSimServer::run(bool unthrottled)
+{
+    sim.start();
+    while(!sim.over()) {
+        sendMeasures();
+        collectActions(unthrottled);
+        sim.step();
+    }
+
+    // robots that finished in the last cycle see their EndLed
+    sendMeasures();
+}
@@ -0,0 +1,90 @@
+/* csimshmchannel.cpp */
+
+#include "simulator/csimshmchannel.h"
+
+CSimShmChannel::CSimShmChannel(const char *n)
+    : name(n), segment(0), doorbell(0)
+{
+    for(int i = 0; i < SHM_MAX_ROBOTS; i++) slotLinks[i] = -1;
+}
+
+CSimShmChannel::~CSimShmChannel()
+{
+    if(segment) {
+        CShmSegment::release(segment);
+        CShmSegment::remove(name.c_str());
+    }
+}
+
+bool CSimShmChannel::init(void)
+{
+    if(name.empty()) return false;
+
+    segment = CShmSegment::create(name.c_str());
+    if(segment == 0) return false;
+
+    doorbell = segment->doorbellValue();
+    return true;
+}
+
+bool CSimShmChannel::wait(int timeoutMs)
+{
+    // a ring after the last look makes it return at once
+    doorbell = segment->waitDoorbell(doorbell, timeoutMs);
+    return true;
+}
+
+/* reclaims the slot if its robot left it, its link is then gone */
+bool CSimShmChannel::reclaimed(int slot)
+{
+    if(!segment->abandoned(slot)) return false;
+
+    segment->reclaim(slot);
+    if(slotLinks[slot] >= 0) slots[slotLinks[slot]] = -1;
+    slotLinks[slot] = -1;
+    return true;
+}
+
+int CSimShmChannel::registration(char *buf, int size, int &link)
+{
+    for(int s = 0; s < SHM_MAX_ROBOTS; s++) {
+        if(reclaimed(s) || slotLinks[s] >= 0) continue;
+        if(segment->robots[s].state.load() != SHM_SLOT_CLAIMED) continue;
+
+        int n = segment->robots[s].actions.pop(buf, size);
+        if(n <= 0) continue;
+
+        link = slots.size();
+        slots.push_back(s);
+        slotLinks[s] = link;
+        return n;
+    }
+    return 0;
+}
+
+void CSimShmChannel::reply(int link, const char *buf, int n, bool accepted)
+{
+    int s = slots[link];
+    if(s < 0) return;
+
+    segment->robots[s].measures.push(buf, n);
+    if(accepted)
+        segment->robots[s].state.store(SHM_SLOT_ATTACHED);
+    else
+        slots[link] = -1;   // the slot is reclaimed once the robot closes it
+}
+
+int CSimShmChannel::recv(int link, char *buf, int size)
+{
+    int s = slots[link];
+    if(s < 0 || reclaimed(s)) return -1;
+
+    int n = segment->robots[s].actions.pop(buf, size);
+    return n > 0 ? n : 0;
+}
+
+bool CSimShmChannel::send(int link, const char *buf, int n)
+{
+    int s = slots[link];
+    return s >= 0 && segment->robots[s].measures.push(buf, n);
+}
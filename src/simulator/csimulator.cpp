@@ -0,0 +1,64 @@
+/* csimulator.cpp */
+
+#include "simulator/csimulator.h"
+
+#include <stdio.h>
+
+CSimulator::CSimulator(const CLab &l, unsigned int seed)
+    : lab(l), rng(seed), cycle(0), running(false)
+{
+}
+
+int CSimulator::addRobot(int id, const std::string &name)
+{
+    if(running) return -1;
+
+    robots.push_back(CSimRobot(id, name, lab.startPose(id)));
+    robots.back().sense(lab, rng);
+    return robots.size() - 1;
+}
+
+void CSimulator::step(void)
+{
+    if(!running) return;
+
+    bool timeUp = cycle >= lab.param.simTimeFinal;
+    for(size_t i = 0; i < robots.size(); i++) {
+        if(timeUp || robots[i].finished()) robots[i].stopMotors();
+        robots[i].move(lab, rng);
+    }
+
+    cycle++;
+    for(size_t i = 0; i < robots.size(); i++)
+        robots[i].sense(lab, rng);
+}
+
+bool CSimulator::over(void) const
+{
+    if(cycle >= lab.param.simTimeFinal + SIM_GRACE_CYCLES) return true;
+    if(robots.empty()) return false;
+
+    for(size_t i = 0; i < robots.size(); i++)
+        if(!robots[i].finished()) return false;
+    return true;
+}
+
+int CSimulator::reply(char *buf, int size, bool accepted) const
+{
+    int n;
+    if(!accepted)
+        n = snprintf(buf, size, "<Reply Status=\"Refused\"></Reply>");
+    else
+        n = snprintf(buf, size,
+                     "<Reply Status=\"Ok\">"
+                     "<Parameters SimTime=\"%u\" CycleTime=\"%u\" KeyTime=\"%u\""
+                     " CompassNoise=\"%g\" BeaconNoise=\"%g\" ObstacleNoise=\"%g\" MotorsNoise=\"%g\""
+                     " LineSensorNoise=\"%g\" GPS=\"%s\" NBeacons=\"0\"/>"
+                     "</Reply>",
+                     lab.param.simTimeFinal, lab.param.cycleTime, lab.param.keyTime,
+                     lab.param.compassNoise, lab.param.beaconNoise, lab.param.obstNoise,
+                     lab.param.motorsNoise, lab.lineNoise, lab.gps ? "On" : "Off");
+
+    if(n >= size) return -1;
+    return n + 1;
+}
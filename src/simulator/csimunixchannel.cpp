@@ -0,0 +1,196 @@
+/* csimunixchannel.cpp */
+
+#include "simulator/csimunixchannel.h"
+
+#include <string.h>
+#include <errno.h>
+
+#include <unistd.h>
+#include <poll.h>
+
+CSimUnixChannel::CSimUnixChannel(const char *path, int t)
+    : type(t), serverfd(-1)
+{
+    memset(&local, 0, sizeof(local));
+    local.sun_family = AF_UNIX;
+    if(strlen(path) < sizeof(local.sun_path))
+        strcpy(local.sun_path, path);
+}
+
+CSimUnixChannel::~CSimUnixChannel()
+{
+    for(size_t i = 0; i < links.size(); i++) close(i);
+    if(serverfd >= 0) {
+        ::close(serverfd);
+        unlink(local.sun_path);
+    }
+}
+
+bool CSimUnixChannel::init(void)
+{
+    if(local.sun_path[0] == '\0') return false;
+
+    serverfd = socket(AF_UNIX, type | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if(serverfd < 0) return false;
+
+    // a socket left by an earlier run would make bind fail
+    unlink(local.sun_path);
+    if(bind(serverfd, (struct sockaddr *)&local, sizeof(local)) < 0 ||
+       (type == SOCK_SEQPACKET && listen(serverfd, SOMAXCONN) < 0)) {
+        ::close(serverfd);
+        serverfd = -1;
+        return false;
+    }
+    return true;
+}
+
+bool CSimUnixChannel::wait(int timeoutMs)
+{
+    std::vector<struct pollfd> pfd(1);
+    pfd[0].fd = serverfd;
+    for(size_t i = 0; i < links.size(); i++) {
+        if(links[i].fd < 0) continue;
+        pfd.push_back(pfd[0]);
+        pfd.back().fd = links[i].fd;
+    }
+    for(size_t i = 0; i < pfd.size(); i++) {
+        pfd[i].events = POLLIN;
+        pfd[i].revents = 0;
+    }
+
+    int ready = poll(&pfd[0], pfd.size(), timeoutMs);
+    return ready >= 0 || errno == EINTR;
+}
+
+void CSimUnixChannel::acceptConnections(void)
+{
+    for(;;) {
+        int fd = accept4(serverfd, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if(fd < 0) return;
+
+        Link l;
+        memset(&l, 0, sizeof(l));
+        l.fd = fd;
+        links.push_back(l);
+    }
+}
+
+int CSimUnixChannel::registration(char *buf, int size, int &link)
+{
+    if(type == SOCK_DGRAM) {
+        struct sockaddr_un sender;
+        socklen_t senderLen = sizeof(sender);
+        ssize_t n = recvfrom(serverfd, buf, size, MSG_DONTWAIT, (struct sockaddr *)&sender, &senderLen);
+        if(n <= 0) return 0;
+
+        // a resent registration comes from the same sender, an unbound one
+        // can not be answered
+        if(senderLen <= sizeof(sa_family_t)) return 0;
+        for(size_t i = 0; i < links.size(); i++) {
+            if(links[i].fd >= 0 && links[i].remoteLen == senderLen &&
+               memcmp(&links[i].remote, &sender, senderLen) == 0) {
+                link = i;
+                return n;
+            }
+        }
+
+        Link l;
+        memset(&l, 0, sizeof(l));
+        l.fd = -1;
+        l.remote = sender;
+        l.remoteLen = senderLen;
+        link = links.size();
+        links.push_back(l);
+        return n;
+    }
+
+    // the first message on a new connection is its registration
+    acceptConnections();
+    for(size_t i = 0; i < links.size(); i++) {
+        Link &l = links[i];
+        if(l.fd < 0 || l.registered) continue;
+
+        ssize_t n = ::recv(l.fd, buf, size, MSG_DONTWAIT);
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) continue;
+        if(n <= 0) {
+            close(i);
+            continue;
+        }
+
+        l.registered = true;
+        link = i;
+        return n;
+    }
+    return 0;
+}
+
+void CSimUnixChannel::reply(int link, const char *buf, int n, bool accepted)
+{
+    Link &l = links[link];
+
+    if(type == SOCK_DGRAM) {
+        if(!accepted) {
+            sendto(serverfd, buf, n, MSG_DONTWAIT, (struct sockaddr *)&l.remote, l.remoteLen);
+            l.gone = true;
+            return;
+        }
+
+        // answered from a socket of its own, which it then talks to
+        if(l.fd < 0) {
+            struct sockaddr_un addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            l.fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+            if(l.fd < 0 || bind(l.fd, (struct sockaddr *)&addr, sizeof(sa_family_t)) < 0) {
+                close(link);
+                return;
+            }
+        }
+    }
+
+    send(link, buf, n);
+    if(!accepted) close(link);
+}
+
+int CSimUnixChannel::recv(int link, char *buf, int size)
+{
+    Link &l = links[link];
+    if(l.gone || l.fd < 0) return -1;
+
+    ssize_t n = ::recv(l.fd, buf, size, MSG_DONTWAIT);
+    if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return 0;
+
+    // on a connection an empty read is its end
+    if(n < 0 || (n == 0 && type == SOCK_SEQPACKET)) {
+        close(link);
+        return -1;
+    }
+    return n;
+}
+
+bool CSimUnixChannel::send(int link, const char *buf, int n)
+{
+    Link &l = links[link];
+    if(l.gone || l.fd < 0) return false;
+
+    ssize_t ret;
+    if(type == SOCK_DGRAM)
+        ret = sendto(l.fd, buf, n, MSG_DONTWAIT, (struct sockaddr *)&l.remote, l.remoteLen);
+    else
+        ret = ::send(l.fd, buf, n, MSG_DONTWAIT | MSG_NOSIGNAL);
+
+    // the robot closed its socket
+    if(ret < 0 && (errno == ECONNREFUSED || errno == EPIPE || errno == ECONNRESET)) {
+        close(link);
+        return false;
+    }
+    return ret == n;
+}
+
+void CSimUnixChannel::close(int link)
+{
+    Link &l = links[link];
+    if(l.fd >= 0) ::close(l.fd);
+    l.fd = -1;
+    l.gone = true;
+}
@@ -0,0 +1,107 @@
+/* mainLabGen.cpp
+ *
+ * Writes random line mazes (see clabgen.h): for each one the lab and grid
+ * files the simulator reads, and the ground-truth graph.
+ */
+
+#include "simulator/clabgen.h"
+
+#include <iostream>
+#include <string>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static void usage(void)
+{
+    std::cerr << "SYNOPSIS: labgen [--cols n] [--rows n] [--cover f] [--diagonal f] [--loops f]\n"
+                 "                 [--dead-ends n] [--targets n] [--seed s] [--count n] [--out prefix]\n"
+                 "  --cols, --rows  cells of the grid (13x6)\n"
+                 "  --cover     fraction of the cells the lines reach (1)\n"
+                 "  --diagonal  share of diagonal links in the tree (0.3)\n"
+                 "  --loops     fraction of the links left out of the tree added back (0.1, 0 for a tree)\n"
+                 "  --dead-ends at most this many dead ends (as many as the tree has)\n"
+                 "  --targets   targets besides the start, 1 to 9 (3)\n"
+                 "  --count     mazes written, with consecutive seeds (1)\n"
+                 "  --out       the files are prefix-<seed>-lab.xml, -grid.xml and .graph (gen)"
+              << std::endl;
+}
+
+static bool writeFile(const std::string &name, const std::string &text)
+{
+    FILE *fp = fopen(name.c_str(), "w");
+    if(fp == 0) return false;
+    bool ok = fwrite(text.data(), 1, text.size(), fp) == text.size();
+    return fclose(fp) == 0 && ok;
+}
+
+int main(int argc, char **argv)
+{
+    CLabGenOptions options;
+    int count = 1;
+    std::string prefix = "gen";
+
+    for(int a = 1; a < argc; a++)
+    {
+        std::string opt = argv[a];
+        if(a + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+
+        const char *val = argv[++a];
+        if(opt == "--cols")
+            options.cols = atoi(val);
+        else if(opt == "--rows")
+            options.rows = atoi(val);
+        else if(opt == "--cover")
+            options.cover = atof(val);
+        else if(opt == "--diagonal")
+            options.diagonal = atof(val);
+        else if(opt == "--loops")
+            options.loops = atof(val);
+        else if(opt == "--dead-ends")
+            options.deadEnds = atoi(val);
+        else if(opt == "--targets")
+            options.targets = atoi(val);
+        else if(opt == "--seed")
+            options.seed = strtoul(val, 0, 10);
+        else if(opt == "--count")
+            count = atoi(val);
+        else if(opt == "--out")
+            prefix = val;
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if(options.cols < 1 || options.rows < 1 || options.targets < 1 || options.targets > 9 || count < 1)
+    {
+        usage();
+        return 1;
+    }
+
+    unsigned int first = options.seed;
+    for(int i = 0; i < count; i++)
+    {
+        options.seed = first + i;
+        CLabGen gen(options);
+
+        std::string name = prefix + "-" + std::to_string(options.seed);
+        std::string labName = name.substr(name.find_last_of('/') + 1);
+        if(!writeFile(name + "-lab.xml", gen.labXml(labName)) ||
+           !writeFile(name + "-grid.xml", gen.gridXml()) ||
+           !writeFile(name + ".graph", gen.graph()))
+        {
+            std::cerr << "labgen: can not write " << name << std::endl;
+            return 1;
+        }
+
+        printf("%s: %dx%d cells, %zu links, %d dead ends, %zu targets\n", name.c_str(),
+               gen.nCols(), gen.nRows(), gen.getLinks().size(), gen.deadEnds(), gen.getTargets().size() - 1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+/* mainScore.cpp
+ *
+ * Scores the map and path files written by the challenge 4 agent against
+ * the lab it ran in (see cscore.h). Prints one line per run:
+ *   <run> <map score> <best map score> <path score>
+ * The scores are cscore.h's own, not those of the simulator's awk scripts.
+ */
+
+#include "simulator/clab.h"
+#include "simulator/cscore.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+
+static void usage(void)
+{
+    std::cerr << "SYNOPSIS: score --lab labfile [--grid gridfile] [--truth] run...\n"
+                 "  run      the outfile given to the agent, run.map and run.path are scored\n"
+                 "  --truth  also print the lab as the agent would draw it" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    std::string labFile, gridFile;
+    std::vector<std::string> runs;
+    bool truth = false;
+
+    for(int a = 1; a < argc; a++)
+    {
+        std::string opt = argv[a];
+
+        if(opt == "--truth")
+        {
+            truth = true;
+            continue;
+        }
+        if(opt.compare(0, 2, "--") != 0)
+        {
+            runs.push_back(opt);
+            continue;
+        }
+        if(a + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+
+        std::string val = argv[++a];
+        if(opt == "--lab")
+            labFile = val;
+        else if(opt == "--grid")
+            gridFile = val;
+        else if(opt == "--param" || opt == "--scoring")
+            ; // accepted for compatibility with the CiberRato simulator arguments
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if(labFile.empty() || (runs.empty() && !truth))
+    {
+        usage();
+        return 1;
+    }
+
+    CLab lab;
+    if(!lab.loadLab(labFile.c_str()))
+    {
+        std::cerr << "score: can not read " << labFile << std::endl;
+        return 1;
+    }
+    if(!gridFile.empty() && !lab.loadGrid(gridFile.c_str()))
+    {
+        std::cerr << "score: can not read " << gridFile << std::endl;
+        return 1;
+    }
+
+    CScorer scorer(lab);
+    if(truth)
+    {
+        for(int row = 0; row < SCORE_ROWS; row++)
+            printf("%.*s\n", SCORE_COLS, scorer.truth().cells[row]);
+    }
+
+    int ret = 0;
+    for(size_t i = 0; i < runs.size(); i++)
+    {
+        CScoreMap map;
+        if(!map.read((runs[i] + ".map").c_str()))
+        {
+            std::cerr << "score: can not read " << runs[i] << ".map" << std::endl;
+            ret = 1;
+        }
+        printf("%s %d %d %g\n", runs[i].c_str(), scorer.mapScore(map), scorer.bestMapScore(),
+               scorer.pathScore((runs[i] + ".path").c_str()));
+    }
+
+    return ret;
+}
@@ -0,0 +1,131 @@
+/* mainSim.cpp
+ *
+ * Headless stand-in for the CiberRato simulator, for local runs of the
+ * agent without the viewer. Besides UDP it serves the local transports
+ * robots can be given as host (see csimchannel.h), with --listen.
+ */
+
+#include "simulator/clab.h"
+#include "simulator/csimulator.h"
+#include "simulator/csimserver.h"
+
+#include <iostream>
+#include <string>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void usage(void)
+{
+    std::cerr << "SYNOPSIS: simulator [--param paramfile] [--lab labfile] [--grid gridfile]\n"
+                 "                    [--port port] [--listen address] [--nrobots n] [--seed seed]\n"
+                 "                    [--unthrottled]\n"
+                 "  --listen  unix:/path, unixseq:/path or shm:/name instead of UDP on the port"
+              << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    std::string paramFile, labFile, gridFile, address;
+    int port = 6000;
+    int nRobots = 1;
+    unsigned int seed = time(0);
+    bool unthrottled = false;
+
+    for(int a = 1; a < argc; a++)
+    {
+        std::string opt = argv[a];
+
+        if(opt == "--unthrottled")
+        {
+            unthrottled = true;
+            continue;
+        }
+        if(a + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+
+        std::string val = argv[++a];
+        if(opt == "--param")
+            paramFile = val;
+        else if(opt == "--lab")
+            labFile = val;
+        else if(opt == "--grid")
+            gridFile = val;
+        else if(opt == "--port")
+            port = atoi(val.c_str());
+        else if(opt == "--listen")
+            address = val;
+        else if(opt == "--nrobots")
+            nRobots = atoi(val.c_str());
+        else if(opt == "--seed")
+            seed = strtoul(val.c_str(), 0, 10);
+        else if(opt == "--scoring")
+            ; // accepted for compatibility with the CiberRato simulator arguments
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    CLab lab;
+    if(!paramFile.empty() && !lab.loadParameters(paramFile.c_str()))
+    {
+        std::cerr << "simulator: can not read " << paramFile << std::endl;
+        return 1;
+    }
+    if(!labFile.empty() && !lab.loadLab(labFile.c_str()))
+    {
+        std::cerr << "simulator: can not read " << labFile << std::endl;
+        return 1;
+    }
+    if(!gridFile.empty() && !lab.loadGrid(gridFile.c_str()))
+    {
+        std::cerr << "simulator: can not read " << gridFile << std::endl;
+        return 1;
+    }
+
+    CSimulator sim(lab, seed);
+    CSimServer server(sim, address, port);
+    if(!server.init())
+    {
+        if(address.empty())
+            perror("simulator: can not open the server port");
+        else
+            perror(("simulator: can not listen on " + address).c_str());
+        return 1;
+    }
+
+    fprintf(stderr, "simulator: lab \"%s\", %u cycles of %u ms%s, seed %u\n",
+            lab.name.c_str(), lab.param.simTimeFinal, lab.param.cycleTime,
+            unthrottled ? " (unthrottled)" : "", seed);
+
+    server.waitRobots(nRobots);
+
+    double start = now_ms();
+    server.run(unthrottled);
+    double elapsed = now_ms() - start;
+
+    fprintf(stderr, "simulator: %u cycles in %.1f ms (%.1f us per cycle)\n",
+            sim.time(), elapsed, sim.time() ? elapsed * 1e3 / sim.time() : 0.0);
+    for(int i = 0; i < sim.nRobots(); i++)
+    {
+        CSimRobot &r = sim.robot(i);
+        fprintf(stderr, "simulator: robot %s %s at (%.2f, %.2f), %u collisions\n",
+                r.name().c_str(), r.finished() ? "finished" : "did not finish",
+                r.x(), r.y(), r.collisions());
+    }
+
+    return 0;
+}
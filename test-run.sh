@@ -157,6 +157,13 @@ case $challenge in
             echo "TEST 2: passed!"
         fi
 
+        # bin/score is not yet known to agree with the scripts above, show
+        # its scores next to theirs so differences can be collected
+        if [ -x "$BIN_DIR/score" ]; then
+            read run native_map_score native_best_map_score native_path_score <<< "$($BIN_DIR/score $SIMULATOR_ARGS_C4 "$outfile")"
+            echo "bin/score: map $native_map_score of $native_best_map_score (awk: $map_score of $best_map_score), path $native_path_score (awk: $path_score)"
+        fi
+
         # store both scores
         echo "$map_score $path_score" >> $SCORES_FILE
         ;;
@@ -0,0 +1,285 @@
+/* bench-cycle.cpp
+ *
+ * Runs whole episodes of AgentC4, one after the other in the same
+ * process, and reports how long the agent takes to compute each cycle:
+ * from its Measures being read to its action being sent, as timed by the
+ * latency statistics (see robSock/clatency.h).
+ *
+ * The agent plays against recorded sensor streams (--replay, see
+ * crobrecord.h), or against the in-process simulator (see csimbackend.h).
+ * The first --warmup episodes are left out of the totals, which show the
+ * steady state once caches and allocators are warm. Allocations are
+ * counted for the whole episode, and apart for its cycles: those of the
+ * agent's thread from the first action sent to the last, leaving out the
+ * agent's setup and teardown. Only operator new is counted: memory taken
+ * with malloc directly, as the C++ runtime does for each exception thrown,
+ * is not.
+ *
+ * With --max-cycle-allocs, it fails when the steady state makes more
+ * allocations per cycle than that, to keep the cycle off the heap. Built
+ * with ROBSOCK_WITH_ALLOC_TRACKING, the allocations are robSock's counts
+ * (see robSock/callocs.h), and each episode reports them per phase.
+ */
+
+#include "challenges/agentC4.h"
+#include "robSock/RobSock.h"
+#include "robSock/callocs.h"
+#include "robSock/clatency.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+/*** Allocations ***/
+
+#ifdef ROBSOCK_ALLOC_TRACKING
+
+// robSock counts them, and the latency statistics split the cycles' by phase
+static uint64_t totalAllocs() { return CAllocs::count(); }
+static uint64_t totalAllocBytes() { return CAllocs::bytes(); }
+static void startCycleAllocs() {}
+static void stopCycleAllocs() {}
+
+static uint64_t episodeCycleAllocs()
+{
+    const CLatencyStats* stats = GetLatencyStats();
+    return stats->allocs(LAT_WAKEUP) + stats->allocs(LAT_CYCLE);
+}
+
+#else
+
+static std::atomic<uint64_t> s_allocs{0};
+static std::atomic<uint64_t> s_allocBytes{0};
+
+// the cycles of the running episode, and the allocations the agent's thread
+// (not the logger's) made once it sent its first action, by then and since
+// the last one sent
+static thread_local bool t_agentThread = false;
+static std::atomic<const CLatencyHistogram*> s_cycles{nullptr};
+static std::atomic<uint64_t> s_cycleAllocs{0};
+static std::atomic<uint64_t> s_lastCycle{0};
+static std::atomic<uint64_t> s_sinceLastCycle{0};
+
+static void* countedAlloc(size_t t_size)
+{
+    s_allocs.fetch_add(1, std::memory_order_relaxed);
+    s_allocBytes.fetch_add(t_size, std::memory_order_relaxed);
+
+    const CLatencyHistogram* cycles = s_cycles.load(std::memory_order_relaxed);
+    uint64_t sent = cycles && t_agentThread ? cycles->count() : 0;
+    if(sent > 0)
+    {
+        if(s_lastCycle.exchange(sent, std::memory_order_relaxed) != sent)
+            s_sinceLastCycle.store(0, std::memory_order_relaxed);
+        s_cycleAllocs.fetch_add(1, std::memory_order_relaxed);
+        s_sinceLastCycle.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return malloc(t_size ? t_size : 1);
+}
+
+void* operator new(size_t t_size)
+{
+    void* p = countedAlloc(t_size);
+    if(p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t t_size)
+{
+    void* p = countedAlloc(t_size);
+    if(p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t t_size, const std::nothrow_t&) noexcept { return countedAlloc(t_size); }
+void* operator new[](size_t t_size, const std::nothrow_t&) noexcept { return countedAlloc(t_size); }
+void operator delete(void* t_p) noexcept { free(t_p); }
+void operator delete[](void* t_p) noexcept { free(t_p); }
+void operator delete(void* t_p, size_t) noexcept { free(t_p); }
+void operator delete[](void* t_p, size_t) noexcept { free(t_p); }
+
+static uint64_t totalAllocs() { return s_allocs.load(); }
+static uint64_t totalAllocBytes() { return s_allocBytes.load(); }
+
+static void startCycleAllocs()
+{
+    s_cycleAllocs = 0;
+    s_lastCycle = 0;
+    s_sinceLastCycle = 0;
+    s_cycles = &GetLatencyStats()->phase(LAT_CYCLE);
+    t_agentThread = true;
+}
+
+static void stopCycleAllocs()
+{
+    s_cycles = nullptr;
+}
+
+static uint64_t episodeCycleAllocs()
+{
+    return s_cycleAllocs.load() - s_sinceLastCycle.load();
+}
+
+#endif
+
+/**
+ * Peak resident set size of the process, in KiB.
+*/
+static long peakRss()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+
+/*** Episodes ***/
+
+struct Episode
+{
+    uint64_t cycles;
+    double meanUs, p99Us, maxUs;
+    uint64_t allocs, allocBytes;
+    uint64_t cycleAllocs;       // made in the cycles, from the first action sent to the last
+    long rssKb;
+};
+
+/**
+ * Run AgentC4 for one episode against host.
+ *
+ * @param t_host The host given to InitRobot2, "replay:file" or "sim:lab".
+ * @param t_cycles Where the cycle times of the episode are added.
+ * @param t_ep The results of the episode.
+ * @return False if the robot could not be initialized.
+*/
+static bool runEpisode(const std::string& t_host, CLatencyHistogram& t_cycles, Episode& t_ep)
+{
+    double irSensorAngles[4] = {0.0, 60.0, -60.0, 180.0};
+    char name[] = "benchAgent";
+    if(InitRobot2(name, 1, irSensorAngles, const_cast<char*>(t_host.c_str())) != 0)
+        return false;
+    EnableLatencyStats();
+
+    uint64_t allocs = totalAllocs(), bytes = totalAllocBytes();
+    startCycleAllocs();
+    {
+        AgentC4 agent{};
+        try {
+            agent.run();
+        }
+        catch(std::exception& e) {
+            std::cerr << "ERROR: during agent.run(): " << e.what() << std::endl;
+        }
+    }
+    stopCycleAllocs();
+    t_ep.allocs = totalAllocs() - allocs;
+    t_ep.allocBytes = totalAllocBytes() - bytes;
+    t_ep.cycleAllocs = episodeCycleAllocs();
+
+    const CLatencyHistogram& h = GetLatencyStats()->phase(LAT_CYCLE);
+    t_ep.cycles = h.count();
+    t_ep.meanUs = h.count() ? h.total() / 1e3 / h.count() : 0.0;
+    t_ep.p99Us = h.percentile(0.99) / 1e3;
+    t_ep.maxUs = h.max() / 1e3;
+    t_cycles.merge(h);
+
+    CloseRobot();
+    t_ep.rssKb = peakRss();
+    return true;
+}
+
+static void usage()
+{
+    std::cerr << "SYNOPSIS: bench-cycle [--episodes n] [--warmup n] [--replay logfile]...\n"
+                 "                      [--param paramfile] [--lab labfile] [--grid gridfile] [--seed n]\n"
+                 "                      [--max-cycle-allocs x]\n"
+                 "  --episodes  episodes timed after the warmup (10)\n"
+                 "  --warmup    episodes run first and left out of the totals (1)\n"
+                 "  --replay    play a recorded log, several are played in turn\n"
+                 "  --param, --lab, --grid, --seed  the simulated world, when nothing is replayed\n"
+                 "                                  (default: ROBSOCK_SIM_PARAM, ...)\n"
+                 "  --max-cycle-allocs  fail when the timed episodes allocate more per cycle" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    int episodes = 10, warmup = 1;
+    double maxCycleAllocs = -1;
+    std::vector<std::string> hosts;
+    std::string lab;
+
+    for(int a = 1; a < argc; a++)
+    {
+        std::string opt = argv[a];
+        if(a + 1 >= argc) { usage(); return 1; }
+        const char* val = argv[++a];
+
+        if(opt == "--episodes") episodes = atoi(val);
+        else if(opt == "--warmup") warmup = atoi(val);
+        else if(opt == "--replay") hosts.push_back(std::string("replay:") + val);
+        else if(opt == "--lab") lab = val;
+        else if(opt == "--param") setenv("ROBSOCK_SIM_PARAM", val, 1);
+        else if(opt == "--grid") setenv("ROBSOCK_SIM_GRID", val, 1);
+        else if(opt == "--seed") setenv("ROBSOCK_SIM_SEED", val, 1);
+        else if(opt == "--max-cycle-allocs") maxCycleAllocs = atof(val);
+        else { usage(); return 1; }
+    }
+    if(episodes < 1 || warmup < 0) { usage(); return 1; }
+    if(hosts.empty()) hosts.push_back("sim:" + lab);
+
+    CLatencyHistogram steady;
+    uint64_t allocs = 0, allocBytes = 0, cycleAllocs = 0;
+
+    printf("%8s %8s %10s %10s %10s %12s %12s %12s %10s\n",
+           "episode", "cycles", "mean(us)", "p99(us)", "max(us)", "allocs", "bytes", "cycle allocs", "rss(KiB)");
+    for(int i = 0; i < warmup + episodes; i++)
+    {
+        const std::string& host = hosts[i % hosts.size()];
+        CLatencyHistogram cycles;
+        Episode ep;
+        if(!runEpisode(host, cycles, ep))
+        {
+            std::cerr << "Can not run an episode on " << host << std::endl;
+            return 1;
+        }
+
+        printf("%8s %8llu %10.2f %10.1f %10.1f %12llu %12llu %12llu %10ld\n",
+               i < warmup ? "warmup" : std::to_string(i - warmup + 1).c_str(),
+               (unsigned long long)ep.cycles, ep.meanUs, ep.p99Us, ep.maxUs,
+               (unsigned long long)ep.allocs, (unsigned long long)ep.allocBytes,
+               (unsigned long long)ep.cycleAllocs, ep.rssKb);
+        fflush(stdout);
+
+        if(i < warmup) continue;
+        steady.merge(cycles);
+        allocs += ep.allocs;
+        allocBytes += ep.allocBytes;
+        cycleAllocs += ep.cycleAllocs;
+    }
+
+    uint64_t n = steady.count();
+    printf("\n%d episodes, %llu cycles: mean %.2f us, p99 %.1f us, max %.1f us per cycle\n",
+           episodes, (unsigned long long)n, n ? steady.total() / 1e3 / n : 0.0,
+           steady.percentile(0.99) / 1e3, steady.max() / 1e3);
+    printf("%llu allocations (%.1f per cycle, %llu bytes), %llu in the cycles, peak RSS %ld KiB\n",
+           (unsigned long long)allocs, n ? (double)allocs / n : 0.0,
+           (unsigned long long)allocBytes, (unsigned long long)cycleAllocs, peakRss());
+
+    double perCycle = n ? (double)cycleAllocs / n : 0.0;
+    if(maxCycleAllocs >= 0 && perCycle > maxCycleAllocs)
+    {
+        std::cerr << "FAILED: " << perCycle << " allocations per cycle, at most "
+                  << maxCycleAllocs << " expected" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,623 @@
+/* bench-map.cpp
+ *
+ * Microbenchmarks of the perceived map and its planner, on random graphs
+ * of the 25x11 cell grid whose density goes from empty (0%) to fully
+ * connected (100% of the links between neighboring cells), and on
+ * generated mazes, from trees to fully looped (simulator/clabgen.h), of
+ * the lab's grid and of the larger LargeGrid (agent/grid.h). The
+ * scoring of the files the agent writes is timed on the mazes too
+ * (simulator/cscore.h). The planner is also timed with cold caches, as
+ * the agent calls it once a cycle after the rest of the cycle has run.
+ *
+ * Google Benchmark's flags apply, e.g. --benchmark_filter=regex, and
+ * --benchmark_out=file --benchmark_out_format=json to keep the results.
+ * Besides them:
+ *   --compare baseline.json [--threshold pct]
+ * runs the benchmarks and compares their CPU time to the results kept in
+ * baseline.json, exiting with 1 if any is slower by more than pct percent
+ * (10 by default).
+ */
+
+#include "agent/map.h"
+#include "agent/utils.h"
+#include "simulator/clab.h"
+#include "simulator/clabgen.h"
+#include "simulator/cscore.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+namespace agent
+{
+
+/**
+ * Access to the planner, which PerceivedMap keeps private.
+*/
+struct MapBenchmark
+{
+    template<class Grid>
+    static bool computePath(BasicPerceivedMap<Grid>& t_map, int t_start, int t_goal)
+    {
+        return t_map.computePath(t_start, t_goal);
+    }
+
+    static void writePathToFile(PerceivedMap& t_map, const std::string& t_fname, const std::vector<int>& t_checkpoints)
+    {
+        t_map.writePathToFile(t_fname, t_checkpoints);
+    }
+};
+
+} // namespace agent
+
+using namespace agent;
+
+/**
+ * A lab: the cells of the grid and the links between them.
+*/
+struct Graph
+{
+    std::vector<int> cells;
+    std::vector<std::pair<int,int>> links;      // each once
+    std::map<int,std::vector<int>> neighbors;
+};
+
+/**
+ * Generate a lab keeping t_density percent of the links between neighboring cells.
+ *
+ * @param t_density The percentage of links kept (0..100).
+ * @param t_seed The seed of the generator.
+ * @return The lab.
+*/
+static Graph makeGraph(int t_density, unsigned int t_seed = 1)
+{
+    Graph g;
+    std::mt19937 rng(t_seed);
+    std::uniform_int_distribution<int> percent(0, 99);
+
+    for(int y = -10; y <= 10; y += 2)
+        for(int x = -24; x <= 24; x += 2)
+            g.cells.push_back(computeCellId(x, y));
+
+    // east, north-east, north and north-west, the other half are the same links
+    const int dirs[4][2] = {{2, 0}, {2, 2}, {0, 2}, {-2, 2}};
+    for(int id : g.cells)
+    {
+        CellCoord p = computeCellCoord(id);
+        for(const auto& d : dirs)
+        {
+            int x = p.x + d[0], y = p.y + d[1];
+            if(!validateCellCoordinates(x, y) || percent(rng) >= t_density) continue;
+
+            int nid = computeCellId(x, y);
+            g.links.push_back(std::make_pair(id, nid));
+            g.neighbors[id].push_back(nid);
+            g.neighbors[nid].push_back(id);
+        }
+    }
+
+    return g;
+}
+
+/**
+ * Fill a map with every cell and link of a lab.
+*/
+template<class Grid>
+static void buildMap(BasicPerceivedMap<Grid>& t_map, const Graph& t_g)
+{
+    t_map.reset();
+    for(int id : t_g.cells)
+        t_map.addCell(id);
+    for(const auto& l : t_g.links)
+    {
+        t_map.linkNeighbor(l.first, l.second);
+        t_map.linkNeighbor(l.second, l.first);
+    }
+}
+
+/**
+ * Explore a lab as the agent does: link the neighbors of the current cell,
+ * mark it expanded and move to the cell getNextCell gives, until the map
+ * is complete.
+ *
+ * @return The number of calls to getNextCell.
+*/
+template<class Grid>
+static int explore(BasicPerceivedMap<Grid>& t_map, const Graph& t_g)
+{
+    t_map.reset();
+    int cid = computeCellId<Grid>(0, 0);
+    t_map.addCell(cid);
+
+    int calls = 0;
+    for(int step = 0; step < 10000; step++)
+    {
+        auto it = t_g.neighbors.find(cid);
+        if(it != t_g.neighbors.end())
+        {
+            for(int nid : it->second)
+            {
+                t_map.addCell(nid);
+                t_map.linkNeighbor(cid, nid);
+            }
+        }
+        t_map.setCellExpanded(cid, true);
+        if(t_map.isComplete()) break;
+
+        cid = t_map.getNextCell(cid);
+        calls++;
+    }
+
+    return calls;
+}
+
+/**
+ * Random pairs of cells, the same for every run.
+*/
+template<class Grid = DefaultGrid>
+static std::vector<std::pair<int,int>> makePairs(const Graph& t_g, int t_n, bool t_adjacent)
+{
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<int> pick(0, t_g.cells.size() - 1);
+    std::vector<std::pair<int,int>> pairs;
+
+    while((int)pairs.size() < t_n)
+    {
+        int a = t_g.cells[pick(rng)];
+        int b = t_g.cells[pick(rng)];
+        if(t_adjacent)
+        {
+            // one of the 8 cells around a, linked or not
+            CellCoord p = computeCellCoord<Grid>(a);
+            int x = p.x + 2 * (int)(rng() % 3) - 2;
+            int y = p.y + 2 * (int)(rng() % 3) - 2;
+            if((x == p.x && y == p.y) || !validateCellCoordinates<Grid>(x, y)) continue;
+            b = computeCellId<Grid>(x, y);
+        }
+        pairs.push_back(std::make_pair(a, b));
+    }
+
+    return pairs;
+}
+
+static void BM_addCell(benchmark::State& state)
+{
+    Graph g = makeGraph(0);
+    int n = state.range(0);
+    PerceivedMap map{};
+
+    for(auto _ : state)
+    {
+        map.reset();
+        for(int i = 0; i < n; i++)
+            benchmark::DoNotOptimize(map.addCell(g.cells[i]));
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_addCell)->Arg(16)->Arg(64)->Arg(275);
+
+static void BM_linkNeighbor(benchmark::State& state)
+{
+    Graph g = makeGraph(state.range(0));
+    PerceivedMap map{};
+
+    for(auto _ : state)
+    {
+        state.PauseTiming();
+        map.reset();
+        for(int id : g.cells)
+            map.addCell(id);
+        state.ResumeTiming();
+
+        for(const auto& l : g.links)
+        {
+            benchmark::DoNotOptimize(map.linkNeighbor(l.first, l.second));
+            benchmark::DoNotOptimize(map.linkNeighbor(l.second, l.first));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * g.links.size() * 2);
+}
+BENCHMARK(BM_linkNeighbor)->DenseRange(0, 100, 25);
+
+static void BM_isNeighbor(benchmark::State& state)
+{
+    Graph g = makeGraph(state.range(0));
+    PerceivedMap map{};
+    buildMap(map, g);
+    std::vector<std::pair<int,int>> pairs = makePairs(g, 1024, true);
+
+    for(auto _ : state)
+    {
+        for(const auto& p : pairs)
+            benchmark::DoNotOptimize(map.isNeighbor(p.first, p.second));
+    }
+    state.SetItemsProcessed(state.iterations() * pairs.size());
+}
+BENCHMARK(BM_isNeighbor)->DenseRange(0, 100, 25);
+
+static void BM_getNextCell(benchmark::State& state)
+{
+    Graph g = makeGraph(state.range(0));
+    PerceivedMap map{};
+    int calls = 0;
+
+    for(auto _ : state)
+        calls = explore(map, g);
+
+    // the whole exploration is timed, the map updates included
+    state.counters["calls"] = calls;
+    state.SetItemsProcessed(state.iterations() * calls);
+}
+BENCHMARK(BM_getNextCell)->DenseRange(0, 100, 25)->Unit(benchmark::kMicrosecond);
+
+static void BM_computePath(benchmark::State& state)
+{
+    Graph g = makeGraph(state.range(0));
+    PerceivedMap map{};
+    buildMap(map, g);
+    std::vector<std::pair<int,int>> pairs = makePairs(g, 64, false);
+
+    size_t i = 0;
+    for(auto _ : state)
+    {
+        const auto& p = pairs[i++ % pairs.size()];
+        benchmark::DoNotOptimize(MapBenchmark::computePath(map, p.first, p.second));
+    }
+}
+BENCHMARK(BM_computePath)->DenseRange(0, 100, 25)->Unit(benchmark::kMicrosecond);
+
+static void BM_computePathCold(benchmark::State& state)
+{
+    Graph g = makeGraph(state.range(0));
+    PerceivedMap map{};
+    buildMap(map, g);
+
+    // larger than the last level cache, written between runs to evict the map
+    std::vector<char> evict(32 << 20);
+    char fill = 0;
+
+    for(auto _ : state)
+    {
+        state.PauseTiming();
+        std::fill(evict.begin(), evict.end(), ++fill);
+        benchmark::ClobberMemory();
+        state.ResumeTiming();
+
+        // corner to corner, across the whole map
+        benchmark::DoNotOptimize(MapBenchmark::computePath(map, computeCellId(-24, -10), computeCellId(24, 10)));
+    }
+    state.counters["map_bytes"] = sizeof(map);
+}
+BENCHMARK(BM_computePathCold)->Arg(50)->Arg(100)->Unit(benchmark::kMicrosecond);
+
+static void BM_writePathToFile(benchmark::State& state)
+{
+    Graph g = makeGraph(100);
+    PerceivedMap map{};
+    buildMap(map, g);
+
+    // the starting cell and other checkpoints spread over the lab
+    std::vector<int> checkpoints{computeCellId(0, 0)};
+    std::mt19937 rng(3);
+    while((int)checkpoints.size() < state.range(0))
+    {
+        int id = g.cells[rng() % g.cells.size()];
+        if(std::find(checkpoints.begin(), checkpoints.end(), id) == checkpoints.end())
+            checkpoints.push_back(id);
+    }
+
+    std::string fname = std::string(P_tmpdir) + "/bench-map-" + std::to_string(getpid());
+    for(auto _ : state)
+        MapBenchmark::writePathToFile(map, fname, checkpoints);
+    remove((fname + ".path").c_str());
+}
+BENCHMARK(BM_writePathToFile)->DenseRange(2, 12, 1)->Unit(benchmark::kMillisecond);
+
+
+/**
+ * A maze filling the cells of a grid, the start in the middle (see
+ * simulator/clabgen.h), keeping t_loops percent of the links a tree leaves out.
+*/
+template<class Grid = DefaultGrid>
+static CLabGen makeMaze(int t_loops)
+{
+    CLabGenOptions options;
+    options.cols = Grid::HALF_WIDTH + 1;
+    options.rows = Grid::HALF_HEIGHT + 1;
+    options.loops = t_loops / 100.0;
+    options.targets = 4;
+    return CLabGen(options);
+}
+
+/**
+ * The cell id of a cell of a maze.
+*/
+template<class Grid = DefaultGrid>
+static int mazeCellId(const CLabGen& t_maze, int t_cell)
+{
+    int start = t_maze.startCell(), cols = t_maze.nCols();
+    return computeCellId<Grid>(2 * (t_cell % cols - start % cols), 2 * (t_cell / cols - start / cols));
+}
+
+/**
+ * A maze as a lab of the benchmarks.
+*/
+template<class Grid = DefaultGrid>
+static Graph mazeGraph(const CLabGen& t_maze)
+{
+    Graph g;
+    for(int cell = 0; cell < t_maze.nCols() * t_maze.nRows(); cell++)
+        g.cells.push_back(mazeCellId<Grid>(t_maze, cell));
+
+    for(const auto& l : t_maze.getLinks())
+    {
+        int a = mazeCellId<Grid>(t_maze, l.first), b = mazeCellId<Grid>(t_maze, l.second);
+        g.links.push_back(std::make_pair(a, b));
+        g.neighbors[a].push_back(b);
+        g.neighbors[b].push_back(a);
+    }
+
+    return g;
+}
+
+static void BM_getNextCellMaze(benchmark::State& state)
+{
+    Graph g = mazeGraph(makeMaze(state.range(0)));
+    PerceivedMap map{};
+    int calls = 0;
+
+    for(auto _ : state)
+        calls = explore(map, g);
+
+    state.counters["calls"] = calls;
+    state.SetItemsProcessed(state.iterations() * calls);
+}
+BENCHMARK(BM_getNextCellMaze)->Arg(0)->Arg(10)->Arg(50)->Arg(100)->Unit(benchmark::kMicrosecond);
+
+static void BM_computePathMaze(benchmark::State& state)
+{
+    Graph g = mazeGraph(makeMaze(state.range(0)));
+    PerceivedMap map{};
+    buildMap(map, g);
+    std::vector<std::pair<int,int>> pairs = makePairs(g, 64, false);
+
+    size_t i = 0;
+    for(auto _ : state)
+    {
+        const auto& p = pairs[i++ % pairs.size()];
+        benchmark::DoNotOptimize(MapBenchmark::computePath(map, p.first, p.second));
+    }
+}
+BENCHMARK(BM_computePathMaze)->Arg(0)->Arg(10)->Arg(50)->Arg(100)->Unit(benchmark::kMicrosecond);
+
+/**
+ * The same on mazes of the 49x21 cells of LargeGrid, four times the lab.
+*/
+static void BM_getNextCellLargeMaze(benchmark::State& state)
+{
+    Graph g = mazeGraph<LargeGrid>(makeMaze<LargeGrid>(state.range(0)));
+    BasicPerceivedMap<LargeGrid> map{};
+    int calls = 0;
+
+    for(auto _ : state)
+        calls = explore(map, g);
+
+    state.counters["calls"] = calls;
+    state.SetItemsProcessed(state.iterations() * calls);
+}
+BENCHMARK(BM_getNextCellLargeMaze)->Arg(0)->Arg(100)->Unit(benchmark::kMillisecond);
+
+static void BM_computePathLargeMaze(benchmark::State& state)
+{
+    Graph g = mazeGraph<LargeGrid>(makeMaze<LargeGrid>(state.range(0)));
+    BasicPerceivedMap<LargeGrid> map{};
+    buildMap(map, g);
+    std::vector<std::pair<int,int>> pairs = makePairs<LargeGrid>(g, 64, false);
+
+    size_t i = 0;
+    for(auto _ : state)
+    {
+        const auto& p = pairs[i++ % pairs.size()];
+        benchmark::DoNotOptimize(MapBenchmark::computePath(map, p.first, p.second));
+    }
+}
+BENCHMARK(BM_computePathLargeMaze)->Arg(0)->Arg(100)->Unit(benchmark::kMicrosecond);
+
+static void BM_score(benchmark::State& state)
+{
+    CLabGen maze = makeMaze(state.range(0));
+    std::string xml = maze.labXml("bench");
+    CLab lab;
+    lab.parseLab(xml.data(), xml.size());
+    CScorer scorer(lab);
+
+    // the files the agent writes once it has mapped the whole maze
+    Graph g = mazeGraph(maze);
+    std::vector<int> checkpoints;
+    for(int t : maze.getTargets())
+        checkpoints.push_back(mazeCellId(maze, t));
+
+    PerceivedMap map{};
+    buildMap(map, g);
+    std::string fname = std::string(P_tmpdir) + "/bench-score-" + std::to_string(getpid());
+    map.writeToFile(fname, checkpoints);
+    std::string mapFile = fname + ".map", pathFile = fname + ".path";
+
+    for(auto _ : state)
+    {
+        CScoreMap m;
+        m.read(mapFile.c_str());
+        benchmark::DoNotOptimize(scorer.mapScore(m));
+        benchmark::DoNotOptimize(scorer.pathScore(pathFile.c_str()));
+    }
+
+    CScoreMap m;
+    m.read(mapFile.c_str());
+    if(scorer.mapScore(m) != scorer.bestMapScore() || scorer.pathScore(pathFile.c_str()) <= 0.0)
+        state.SkipWithError("the agent's files do not score as the lab");
+    remove(mapFile.c_str());
+    remove(pathFile.c_str());
+
+    // runs scored per second
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_score)->Arg(0)->Arg(10)->Arg(50)->Arg(100)->Unit(benchmark::kMicrosecond);
+
+
+/*** Comparison with a baseline ***/
+
+/**
+ * Console output that also keeps the CPU time of each run, in ns.
+*/
+class CollectingReporter : public benchmark::ConsoleReporter
+{
+public:
+    CollectingReporter() : ConsoleReporter(isatty(STDOUT_FILENO) ? OO_Color : OO_None) {}
+
+    void ReportRuns(const std::vector<Run>& t_runs) override
+    {
+        for(const Run& r : t_runs)
+        {
+            if(r.run_type != Run::RT_Iteration || r.error_occurred) continue;
+            double ns = r.GetAdjustedCPUTime() * 1e9 / benchmark::GetTimeUnitMultiplier(r.time_unit);
+            m_cpuNs.push_back(std::make_pair(r.benchmark_name(), ns));
+        }
+        ConsoleReporter::ReportRuns(t_runs);
+    }
+
+    // in the order they ran
+    const std::vector<std::pair<std::string,double>>& results() const { return m_cpuNs; }
+
+private:
+    std::vector<std::pair<std::string,double>> m_cpuNs;
+};
+
+/**
+ * Get the text of a field of a flat JSON object.
+*/
+static std::string jsonField(const std::string& t_obj, const std::string& t_key)
+{
+    size_t k = t_obj.find("\"" + t_key + "\"");
+    if(k == std::string::npos) return "";
+    size_t v = t_obj.find_first_not_of(" \t\n:", k + t_key.size() + 2);
+    if(v == std::string::npos) return "";
+
+    if(t_obj[v] == '"')
+        return t_obj.substr(v + 1, t_obj.find('"', v + 1) - v - 1);
+    return t_obj.substr(v, t_obj.find_first_of(",}\n", v) - v);
+}
+
+/**
+ * Read the CPU time of each run in a JSON output of Google Benchmark, in ns.
+ *
+ * @return False if the file can not be read or has no benchmarks.
+*/
+static bool readBaseline(const std::string& t_fname, std::map<std::string,double>& t_cpuNs)
+{
+    std::ifstream file(t_fname);
+    if(!file) return false;
+    std::stringstream ss;
+    ss << file.rdbuf();
+    std::string text = ss.str();
+
+    // the runs are flat objects in the "benchmarks" array
+    size_t pos = text.find("\"benchmarks\"");
+    if(pos == std::string::npos) return false;
+
+    while((pos = text.find('{', pos)) != std::string::npos)
+    {
+        size_t end = text.find('}', pos);
+        if(end == std::string::npos) break;
+        std::string obj = text.substr(pos, end - pos + 1);
+        pos = end;
+
+        if(jsonField(obj, "run_type") == "aggregate" || jsonField(obj, "error_occurred") == "true") continue;
+
+        std::string unit = jsonField(obj, "time_unit");
+        double scale = unit == "s" ? 1e9 : unit == "ms" ? 1e6 : unit == "us" ? 1e3 : 1;
+        t_cpuNs[jsonField(obj, "name")] = atof(jsonField(obj, "cpu_time").c_str()) * scale;
+    }
+
+    return !t_cpuNs.empty();
+}
+
+/**
+ * Print how each benchmark changed since the baseline.
+ *
+ * @return The number of benchmarks slower by more than t_threshold percent.
+*/
+static int compare(const std::map<std::string,double>& t_base, const std::vector<std::pair<std::string,double>>& t_now, double t_threshold)
+{
+    int slower = 0;
+    printf("\n%-32s %14s %14s %9s\n", "Benchmark", "Baseline (ns)", "Now (ns)", "Change");
+    for(const auto& r : t_now)
+    {
+        auto b = t_base.find(r.first);
+        if(b == t_base.end())
+        {
+            printf("%-32s %14s %14.1f %9s\n", r.first.c_str(), "-", r.second, "new");
+            continue;
+        }
+
+        double change = b->second > 0 ? (r.second - b->second) / b->second * 100.0 : 0.0;
+        bool regressed = change > t_threshold;
+        slower += regressed;
+        printf("%-32s %14.1f %14.1f %+8.1f%%%s\n", r.first.c_str(), b->second, r.second, change,
+               regressed ? "  SLOWER" : change < -t_threshold ? "  faster" : "");
+    }
+
+    if(slower > 0) printf("\n%d benchmark%s slower by more than %.0f%%\n", slower, slower == 1 ? "" : "s", t_threshold);
+    return slower;
+}
+
+int main(int argc, char** argv)
+{
+    std::string baseline;
+    double threshold = 10.0;
+
+    // take out our options, the rest are Google Benchmark's
+    int n = 1;
+    for(int i = 1; i < argc; i++)
+    {
+        std::string opt = argv[i];
+        if(opt == "--compare" && i + 1 < argc) baseline = argv[++i];
+        else if(opt == "--threshold" && i + 1 < argc) threshold = atof(argv[++i]);
+        else argv[n++] = argv[i];
+    }
+    argc = n;
+
+    benchmark::Initialize(&argc, argv);
+    if(benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+    if(baseline.empty())
+    {
+        benchmark::RunSpecifiedBenchmarks();
+        benchmark::Shutdown();
+        return 0;
+    }
+
+    std::map<std::string,double> base;
+    if(!readBaseline(baseline, base))
+    {
+        std::cerr << "Can not read benchmark results from " << baseline << std::endl;
+        return 1;
+    }
+
+    CollectingReporter reporter;
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    benchmark::Shutdown();
+
+    return compare(base, reporter.results(), threshold) > 0 ? 1 : 0;
+}
@@ -0,0 +1,69 @@
+#!/bin/sh
+#
+# run-transport.sh simulator mainRob lab grid address out [reclaim]
+#
+# Runs one episode of the agent against the simulator over address (see
+# simulator/csimchannel.h). Fails unless both exit cleanly and the robot
+# stayed registered until the end. Their output is kept in out.sim and
+# out.rob.
+#
+# With reclaim, robots come and go before the episode: more robots are
+# refused than there are shared memory slots, so each needs the slot of
+# the one before back, and a robot that registered is killed, so the
+# simulator has to notice it is gone.
+
+set -u
+
+sim=$1 rob=$2 lab=$3 grid=$4 address=$5 out=$6
+reclaim=${7:-}
+
+nrobots=1
+[ "$reclaim" = reclaim ] && nrobots=2
+
+"$sim" --lab "$lab" --grid "$grid" --listen "$address" --nrobots $nrobots --seed 1 --unthrottled > "$out.sim" 2>&1 &
+simpid=$!
+
+fail() {
+    echo "$1"; cat "$out.sim"
+    kill $simpid 2>/dev/null
+    exit 1
+}
+
+# robots started before the channel is open would miss it, or find the
+# segment of an earlier run: the lab line comes once it is
+for i in $(seq 50) ; do
+    grep -q "simulator: lab" "$out.sim" && break
+    sleep 0.1
+done
+grep -q "simulator: lab" "$out.sim" || fail "simulator did not start"
+
+if [ "$reclaim" = reclaim ] ; then
+    for i in 1 2 3 4 5 6 7 8 9 10 ; do
+        "$rob" -c 4 -h "$address" -r refused$i -p -1 > "$out.refused" 2>&1
+        grep -q "refused" "$out.refused" || fail "robot refused$i was not answered"
+    done
+
+    "$rob" -c 4 -h "$address" -r killed -p 2 > /dev/null 2>&1 &
+    killed=$!
+    for i in $(seq 50) ; do
+        grep -q "robot killed registered" "$out.sim" && break
+        sleep 0.1
+    done
+    kill -9 $killed
+    wait $killed 2>/dev/null
+fi
+
+if ! "$rob" -c 4 -h "$address" -f "$out" > "$out.rob" 2>&1 ; then
+    cat "$out.rob"
+    fail "mainRob failed"
+fi
+
+wait $simpid || fail "simulator failed"
+cat "$out.sim"
+
+grep -q "robot cppAgent registered" "$out.sim" || exit 1
+grep -q "robot cppAgent is gone" "$out.sim" && exit 1
+if [ "$reclaim" = reclaim ] ; then
+    grep -q "robot killed is gone" "$out.sim" || exit 1
+fi
+exit 0
@@ -1,9 +1,38 @@
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <queue>
+#include <random>
+#include <set>
 #include <catch2/catch_test_macros.hpp>
 
 #include "agent/map.h"
 
+namespace agent
+{
+
+struct MapTest
+{
+    // the path of computePath, from t_start to t_goal, empty if there is none
+    template<class Grid>
+    static std::vector<int> computePath(BasicPerceivedMap<Grid>& t_map, int t_start, int t_goal)
+    {
+        if(!t_map.computePath(t_start, t_goal))
+            return {};
+        return std::vector<int>(t_map.m_path.rbegin(), t_map.m_path.rend());
+    }
+
+    template<class Grid>
+    static double distanceBetweenCells(BasicPerceivedMap<Grid>& t_map, int t_id1, int t_id2)
+    {
+        return t_map.distanceBetweenCells(t_id1, t_id2);
+    }
+};
+
+} // namespace agent
+
 TEST_CASE( "Common map usage", "[map]" )
 {
     using namespace agent;
@@ -71,6 +100,118 @@ TEST_CASE( "Common map usage", "[map]" )
     }
 }
 
+TEST_CASE( "Larger grid", "[map]" )
+{
+    using namespace agent;
+
+    static_assert(computeCellId(0,0) == 514, "the default grid is the ciberRato one");
+    static_assert(computeCellId<LargeGrid>(-48,-20) == 0, "the bottom left cell is the first");
+    static_assert(!validateCellCoordinates(26,0) && validateCellCoordinates<LargeGrid>(26,0), "");
+
+    BasicPerceivedMap<LargeGrid> map{};
+
+    for(int x =-48; x <= 48; x+=2)
+        for(int y =-20; y <= 20; y+=2)
+            REQUIRE( map.addCell(computeCellId<LargeGrid>(x,y)) );
+
+    // a border cell of the large grid is expanded with 5 neighbors
+    int id = computeCellId<LargeGrid>(48,0);
+    for(int dx = -2; dx <= 0; dx+=2)
+        for(int dy = -2; dy <= 2; dy+=2)
+            if(dx != 0 || dy != 0)
+                map.linkNeighbor(id, computeCellId<LargeGrid>(48+dx,dy));
+    REQUIRE( map.cellIsExpanded(id) );
+
+    REQUIRE_THROWS_AS( map.addCell(computeCellId<LargeGrid>(49,0)), std::invalid_argument );
+}
+
+TEST_CASE( "Grid tables", "[map]" )
+{
+    using namespace agent;
+
+    static_assert(neighborCellId(computeCellId(0,0), 1) == computeCellId(2,2), "north-east of the start");
+    static_assert(neighborCellId(computeCellId(24,10), 0) == -1, "nothing east of the corner");
+    static_assert(neighborCellId(computeCellId(1,0), 0) == -1, "links have no neighbors");
+    static_assert(cellX(computeCellId(-24,6)) == -24 && cellY(computeCellId(-24,6)) == 6, "");
+    static_assert(computeCellCoord(computeCellId(-24,6)) == CellCoord{-24,6}, "");
+    static_assert(computeCellId(CellCoord{2,-4}) == computeCellId(2,-4), "");
+    static_assert(CellCoord{-2,4}.packed() != CellCoord{4,-2}.packed(), "");
+
+    for(int id = -1; id <= DefaultGrid::SIZE; id++)
+    {
+        int x = id % DefaultGrid::COLS - 24, y = id / DefaultGrid::COLS - 10;
+        REQUIRE( validateCellId(id) == (id >= 0 && id < DefaultGrid::SIZE && x % 2 == 0 && y % 2 == 0) );
+    }
+
+    REQUIRE( neighborDirection(computeCellId(0,0), computeCellId(-2,-2)) == 5 );
+    REQUIRE( neighborDirection(computeCellId(0,0), computeCellId(4,0)) == -1 );
+    REQUIRE( neighborDirection(computeCellId(24,0), computeCellId(-24,2)) == -1 ); // across the grid
+}
+
+TEST_CASE( "Cell links", "[map]" )
+{
+    using namespace agent;
+
+    PerceivedMap map{};
+    int id = computeCellId(0,0);
+    for(int x = -2; x <= 2; x+=2)
+        for(int y = -2; y <= 2; y+=2)
+            map.addCell(computeCellId(x,y));
+
+    // neighbors come in the order they were linked in
+    REQUIRE( map.linkNeighbor(id, computeCellId(0,-2)) );
+    REQUIRE( map.linkNeighbor(id, computeCellId(2,0)) );
+    REQUIRE( map.linkNeighbor(id, computeCellId(-2,2)) );
+    REQUIRE_FALSE( map.linkNeighbor(id, computeCellId(2,0)) );
+    REQUIRE( map.getNeighbors(id) == std::vector<int>{computeCellId(0,-2), computeCellId(2,0), computeCellId(-2,2)} );
+
+    map.unlinkNeighbor(id, computeCellId(2,0));
+    REQUIRE_FALSE( map.isNeighbor(id, computeCellId(2,0)) );
+    REQUIRE( map.getNeighbors(id) == std::vector<int>{computeCellId(0,-2), computeCellId(-2,2)} );
+    REQUIRE( map.linkNeighbor(id, computeCellId(2,0)) );
+    REQUIRE( map.getNeighbors(id) == std::vector<int>{computeCellId(0,-2), computeCellId(-2,2), computeCellId(2,0)} );
+
+    std::vector<int> visited;
+    map.forEachNeighbor(id, [&visited](int t_nei) { visited.push_back(t_nei); });
+    REQUIRE( visited == map.getNeighbors(id) );
+
+    REQUIRE_THROWS_AS( map.linkNeighbor(id, computeCellId(4,0)), std::invalid_argument );
+    REQUIRE_THROWS_AS( map.getNeighbors(computeCellId(4,0)), std::invalid_argument );
+    REQUIRE_THROWS_AS( map.forEachNeighbor(computeCellId(4,0), [](int) {}), std::invalid_argument );
+}
+
+TEST_CASE( "Scratch arena", "[map]" )
+{
+    using namespace agent;
+
+    Arena arena{256};
+    char* a = static_cast<char*>(arena.allocate(10, 1));
+    double* b = static_cast<double*>(arena.allocate(sizeof(double), alignof(double)));
+    REQUIRE( reinterpret_cast<uintptr_t>(b) % alignof(double) == 0 );
+    REQUIRE( (char*)b > a );
+
+    // past the buffer, then grown to hold it all on reset
+    arena.allocate(1000);
+    REQUIRE( arena.used() > 1000 );
+    arena.reset();
+    REQUIRE( arena.used() == 0 );
+    REQUIRE( arena.capacity() >= 1000 );
+
+    // the planner takes its temporaries from the arena, and keeps none of them
+    PerceivedMap map{};
+    map.setScratch(&arena);
+    map.addCell(computeCellId(0,0));
+    map.addCell(computeCellId(2,0));
+    map.linkNeighbor(computeCellId(0,0), computeCellId(2,0));
+    map.setCellExpanded(computeCellId(0,0), true);
+    REQUIRE( map.getNextCell(computeCellId(0,0)) == computeCellId(2,0) );
+    REQUIRE( arena.used() > 0 );
+
+    std::vector<int> neighbors = map.getNeighbors(computeCellId(0,0));
+    arena.reset();
+    REQUIRE( neighbors == std::vector<int>{computeCellId(2,0)} );
+}
+
 TEST_CASE("Invalid cells", "[map]")
 {
     using namespace agent;
@@ -211,5 +352,358 @@ TEST_CASE( "Small real world scenario", "[map]" )
     }
 }
 
+TEST_CASE( "Bitboard shifts", "[map]" )
+{
+    using namespace agent;
+    typedef CellBoard<DefaultGrid> Board;
+
+    auto moved = [](int t_x, int t_y, int t_dir) {
+        Board b;
+        b.set(computeCellId(t_x, t_y));
+        return b.shifted(t_dir);
+    };
+
+    // inside the grid, a cell moves to its neighbor
+    for(int d = 0; d < N_DIRECTIONS; d++)
+    {
+        Board b = moved(0, 0, d);
+        REQUIRE( b.count() == 1 );
+        REQUIRE( b.first() == neighborCellId(computeCellId(0,0), d) );
+    }
+    REQUIRE( moved(22, 4, 0).first() == computeCellId(24,4) );
+    REQUIRE( moved(-22, 4, 4).first() == computeCellId(-24,4) );
+
+    // nothing east of column 24 nor west of column -24, and no wrapping to the next row
+    for(int d : {7, 0, 1})
+        for(int y : {-10, 0, 10})
+            REQUIRE_FALSE( moved(24, y, d).any() );
+    for(int d : {3, 4, 5})
+        for(int y : {-10, 0, 10})
+            REQUIRE_FALSE( moved(-24, y, d).any() );
+
+    // nothing south of the first row nor north of the last
+    for(int d : {5, 6, 7})
+        for(int x : {-24, 0, 24})
+            REQUIRE_FALSE( moved(x, -10, d).any() );
+    for(int d : {1, 2, 3})
+        for(int x : {-24, 0, 24})
+            REQUIRE_FALSE( moved(x, 10, d).any() );
+
+    // the whole grid loses its border on the side it moves to
+    Board all;
+    for(int id = 0; id < DefaultGrid::SIZE; id++)
+        if(validateCellId(id)) all.set(id);
+    REQUIRE( all.shifted(0).count() == Board::SIZE - Board::ROWS );
+    REQUIRE( all.shifted(1).count() == (Board::COLS - 1)*(Board::ROWS - 1) );
+    REQUIRE( all.shifted(6).count() == Board::SIZE - Board::COLS );
+    REQUIRE_FALSE( all.shifted(0).test(computeCellId(-24,0)) );
+    REQUIRE_FALSE( all.shifted(2).test(computeCellId(0,-10)) );
+
+    // a row of the large grid holds 49 cells
+    typedef CellBoard<LargeGrid> LargeBoard;
+    LargeBoard l;
+    l.set(computeCellId<LargeGrid>(46,0));
+    REQUIRE( l.shifted(0).first() == computeCellId<LargeGrid>(48,0) );
+    REQUIRE_FALSE( l.shifted(0).shifted(0).any() );
+    REQUIRE_FALSE( l.shifted(0).shifted(1).any() );
+}
+
+// the path to the nearest open cell as a queue visits the cells, empty if there is none
+template<class Grid>
+static std::vector<int> queuePath(agent::BasicPerceivedMap<Grid>& t_map, int t_start)
+{
+    std::map<int,int> cameFrom{{t_start, -1}};
+    std::queue<int> queue;
+    queue.push(t_start);
+    while(!queue.empty())
+    {
+        int v = queue.front();
+        queue.pop();
+        if(!t_map.cellIsExpanded(v))
+        {
+            std::vector<int> path;
+            for(int c = v; c >= 0; c = cameFrom[c])
+                path.insert(path.begin(), c);
+            return path;
+        }
+        for(int nei : t_map.getNeighbors(v))
+            if(cameFrom.emplace(nei, v).second)
+                queue.push(nei);
+    }
+    return {};
+}
+
+// the cells getNextCell goes through from t_start, until it stays on an open cell
+template<class Grid>
+static std::vector<int> nextCells(agent::BasicPerceivedMap<Grid>& t_map, int t_start)
+{
+    std::vector<int> path{t_start};
+    for(int next; (next = t_map.getNextCell(path.back())) != path.back(); )
+        path.push_back(next);
+    return path;
+}
+
+// a random map of about half the cells, linked both ways, mostly expanded;
+// returns whether each identifier is a cell of the map
+template<class Grid>
+static std::vector<bool> randomMap(agent::BasicPerceivedMap<Grid>& t_map, std::mt19937& t_rng)
+{
+    using namespace agent;
+    std::uniform_real_distribution<double> p(0, 1);
+
+    std::vector<bool> known(Grid::SIZE);
+    t_map.reset();
+    for(int id = 0; id < Grid::SIZE; id++)
+        if(validateCellId<Grid>(id) && p(t_rng) < 0.5)
+            known[id] = t_map.addCell(id);
+    for(int id = 0; id < Grid::SIZE; id++)
+    {
+        if(!known[id]) continue;
+        for(int d = 0; d < N_DIRECTIONS/2; d++)
+        {
+            int nei = neighborCellId<Grid>(id, d);
+            if(nei < 0 || !known[nei] || p(t_rng) < 0.3) continue;
+            t_map.linkNeighbor(id, nei);
+            t_map.linkNeighbor(nei, id);
+        }
+    }
+    for(int id = 0; id < Grid::SIZE; id++)
+        if(known[id] && p(t_rng) < 0.9)
+            t_map.setCellExpanded(id, true);
+    return known;
+}
 
-// TODO: test getNextCell
\ No newline at end of file
+TEST_CASE( "Next cell to expand", "[map]" )
+{
+    using namespace agent;
+
+    // a corridor east from the start, branching north, south and east at (4,0)
+    PerceivedMap map{};
+    const int cells[][2] = {{0,0}, {2,0}, {4,0}, {4,2}, {4,-2}, {6,0}};
+    for(auto& c : cells)
+        map.addCell(computeCellId(c[0], c[1]));
+    auto link = [&map](int x1, int y1, int x2, int y2) {
+        map.linkNeighbor(computeCellId(x1,y1), computeCellId(x2,y2));
+        map.linkNeighbor(computeCellId(x2,y2), computeCellId(x1,y1));
+    };
+    link(0,0, 2,0);
+    link(2,0, 4,0);
+    // north first: the queue reaches (4,2) before (4,-2), of lower identifier,
+    // and before (6,0), east
+    link(4,0, 4,2);
+    link(4,0, 4,-2);
+    link(4,0, 6,0);
+    for(auto& c : {cells[0], cells[1], cells[2]})
+        map.setCellExpanded(computeCellId(c[0], c[1]), true);
+
+    SECTION( "Path to the nearest open cell" )
+    {
+        REQUIRE( nextCells(map, computeCellId(0,0)) ==
+                 std::vector<int>{computeCellId(0,0), computeCellId(2,0), computeCellId(4,0), computeCellId(4,2)} );
+    }
+
+    SECTION( "An open cell is its own next cell" )
+    {
+        REQUIRE( map.getNextCell(computeCellId(6,0)) == computeCellId(6,0) );
+    }
+
+    SECTION( "Back to the start once complete" )
+    {
+        for(auto& c : cells)
+            map.setCellExpanded(computeCellId(c[0], c[1]), true);
+
+        // the current cell first, as the path computed to the start begins there
+        REQUIRE( map.getNextCell(computeCellId(6,0)) == computeCellId(6,0) );
+        REQUIRE( map.isComplete() );
+        REQUIRE( map.getNextCell(computeCellId(6,0)) == computeCellId(4,0) );
+        REQUIRE( map.getNextCell(computeCellId(4,0)) == computeCellId(2,0) );
+        REQUIRE( map.getNextCell(computeCellId(2,0)) == computeCellId(0,0) );
+    }
+
+    SECTION( "Unknown cells" )
+    {
+        REQUIRE_THROWS_AS( map.getNextCell(computeCellId(8,0)), std::invalid_argument );
+        REQUIRE_THROWS_AS( map.getNextCell(computeCellId(1,0)), std::invalid_argument );
+    }
+}
+
+TEST_CASE( "Next cell against a queue", "[map]" )
+{
+    using namespace agent;
+
+    std::mt19937 rng{47};
+    int checked = 0;
+
+    PerceivedMap map{};
+    BasicPerceivedMap<LargeGrid> large{};
+    for(int trial = 0; trial < 200; trial++)
+    {
+        std::vector<bool> known = randomMap(map, rng);
+        std::vector<bool> largeKnown = randomMap(large, rng);
+        for(int id = 0; id < DefaultGrid::SIZE; id += 7)
+        {
+            if(!known[id]) continue;
+            std::vector<int> expected = queuePath(map, id);
+            if(expected.empty()) continue;
+            REQUIRE( nextCells(map, id) == expected );
+            checked++;
+        }
+        for(int id = 0; id < LargeGrid::SIZE; id += 23)
+        {
+            if(!largeKnown[id]) continue;
+            std::vector<int> expected = queuePath(large, id);
+            if(expected.empty()) continue;
+            REQUIRE( nextCells(large, id) == expected );
+            checked++;
+        }
+    }
+    REQUIRE( checked > 1000 );
+}
+// the whole grid, without the links between some neighbors, always the same ones
+template<class Grid>
+static void patternMap(agent::BasicPerceivedMap<Grid>& t_map)
+{
+    using namespace agent;
+
+    for(int id = 0; id < Grid::SIZE; id++)
+        if(validateCellId<Grid>(id)) t_map.addCell(id);
+    for(int id = 0; id < Grid::SIZE; id++)
+    {
+        if(!validateCellId<Grid>(id)) continue;
+        int x = cellX<Grid>(id) + Grid::HALF_WIDTH, y = cellY<Grid>(id) + Grid::HALF_HEIGHT;
+        for(int d = 0; d < N_DIRECTIONS/2; d++)
+        {
+            int nei = neighborCellId<Grid>(id, d);
+            if(nei < 0 || (7*x + 13*y + 3*d) % 5 == 0) continue;
+            t_map.linkNeighbor(id, nei);
+            t_map.linkNeighbor(nei, id);
+        }
+    }
+}
+
+// the length of a path, each step as long as the link
+template<class Grid>
+static double pathLength(const std::vector<int>& t_path)
+{
+    double length = 0;
+    for(size_t i = 1; i < t_path.size(); i++)
+        length += std::hypot(agent::cellX<Grid>(t_path[i]) - agent::cellX<Grid>(t_path[i-1]),
+                             agent::cellY<Grid>(t_path[i]) - agent::cellY<Grid>(t_path[i-1]));
+    return length;
+}
+
+// the length of the shortest path, by Dijkstra over getNeighbors
+template<class Grid>
+static double shortestLength(agent::BasicPerceivedMap<Grid>& t_map, int t_start, int t_goal)
+{
+    std::map<int,double> dist{{t_start, 0}};
+    std::set<std::pair<double,int>> queue{{0, t_start}};
+    while(!queue.empty())
+    {
+        std::pair<double,int> top = *queue.begin();
+        queue.erase(queue.begin());
+        if(top.second == t_goal) return top.first;
+        for(int nei : t_map.getNeighbors(top.second))
+        {
+            double d = top.first + pathLength<Grid>({top.second, nei});
+            auto it = dist.find(nei);
+            if(it != dist.end() && it->second <= d) continue;
+            if(it != dist.end()) queue.erase({it->second, nei});
+            dist[nei] = d;
+            queue.insert({d, nei});
+        }
+    }
+    return -1;
+}
+
+// a path, link after link, from the first cell to the last
+template<class Grid>
+static bool isPath(agent::BasicPerceivedMap<Grid>& t_map, const std::vector<int>& t_path, int t_start, int t_goal)
+{
+    if(t_path.empty() || t_path.front() != t_start || t_path.back() != t_goal)
+        return false;
+    for(size_t i = 1; i < t_path.size(); i++)
+        if(!t_map.isNeighbor(t_path[i-1], t_path[i]))
+            return false;
+    return true;
+}
+
+TEST_CASE( "Planner paths and distances", "[map]" )
+{
+    using namespace agent;
+
+    // start, goal, steps and length of the shortest path; distanceBetweenCells
+    // adds the steps in whole units, so a diagonal counts as 2
+    struct Case { int x1, y1, x2, y2; int steps; double length; double distance; };
+
+    SECTION( "Default grid" )
+    {
+        PerceivedMap map{};
+        patternMap(map);
+
+        const Case cases[] = {
+            {-24,-10,  24, 10, 24, 61.254834, 48},
+            { 24,-10, -24, 10, 24, 56.284271, 48},
+            {  0,  0,   2,  2,  1,  2.828427,  2},
+            { -6,  4,  10, -8,  9, 22.142136, 18},
+            { 24, 10, -24, 10, 24, 56.284271, 48},
+            {  4,  0,   4,  0,  0,  0,         0},
+        };
+        for(const Case& c : cases)
+        {
+            int start = computeCellId(c.x1, c.y1), goal = computeCellId(c.x2, c.y2);
+            std::vector<int> path = MapTest::computePath(map, start, goal);
+            REQUIRE( isPath(map, path, start, goal) );
+            REQUIRE( (int)path.size() - 1 == c.steps );
+            REQUIRE( std::abs(pathLength<DefaultGrid>(path) - c.length) < 1e-6 );
+            REQUIRE( std::abs(shortestLength(map, start, goal) - c.length) < 1e-6 );
+            REQUIRE( MapTest::distanceBetweenCells(map, start, goal) == c.distance );
+        }
+
+        // the ties between equally short paths are broken as before
+        std::vector<int> path = MapTest::computePath(map, computeCellId(-6,4), computeCellId(10,-8));
+        const int cells[][2] = {{-6,4}, {-4,4}, {-2,2}, {0,0}, {2,0}, {4,-2}, {6,-4}, {6,-6}, {8,-6}, {10,-8}};
+        REQUIRE( path.size() == 10 );
+        for(size_t i = 0; i < path.size(); i++)
+            REQUIRE( path[i] == computeCellId(cells[i][0], cells[i][1]) );
+
+        // a cell with no links is out of reach
+        int lone = computeCellId(0,0);
+        for(int nei : map.getNeighbors(lone))
+        {
+            map.unlinkNeighbor(lone, nei);
+            map.unlinkNeighbor(nei, lone);
+        }
+        REQUIRE( MapTest::computePath(map, computeCellId(-24,-10), lone).empty() );
+        REQUIRE( MapTest::distanceBetweenCells(map, computeCellId(-24,-10), lone) == std::numeric_limits<int>::max() );
+        REQUIRE( isPath(map, MapTest::computePath(map, computeCellId(-6,4), computeCellId(10,-8)),
+                        computeCellId(-6,4), computeCellId(10,-8)) );
+    }
+
+    SECTION( "Large grid" )
+    {
+        // the predecessors are kept as shorts, up to the highest identifier of the grid
+        static_assert(LargeGrid::SIZE - 1 <= std::numeric_limits<short>::max(), "");
+        REQUIRE( computeCellId<LargeGrid>(48,20) == LargeGrid::SIZE - 1 );
+
+        BasicPerceivedMap<LargeGrid> map{};
+        patternMap(map);
+
+        const Case cases[] = {
+            {-48,-20,  48, 20, 48, 122.509668, 96},
+            { 48, 20, -48,-20, 48, 122.509668, 96},
+            { 48,-20, -48, 20, 48, 112.568542, 96},
+            { 46, 18,  48, 20,  2,   4,         4},
+        };
+        for(const Case& c : cases)
+        {
+            int start = computeCellId<LargeGrid>(c.x1, c.y1), goal = computeCellId<LargeGrid>(c.x2, c.y2);
+            std::vector<int> path = MapTest::computePath(map, start, goal);
+            REQUIRE( isPath(map, path, start, goal) );
+            REQUIRE( (int)path.size() - 1 == c.steps );
+            REQUIRE( std::abs(pathLength<LargeGrid>(path) - c.length) < 1e-6 );
+            REQUIRE( std::abs(shortestLength(map, start, goal) - c.length) < 1e-6 );
+            REQUIRE( MapTest::distanceBetweenCells(map, start, goal) == c.distance );
+        }
+    }
+}